@@ -0,0 +1,192 @@
+//
+//  @file BenchSupport.h
+//  @framework fliclib-core
+//
+//  Copyright (c) 2016-2026 Shortcut Labs. All rights reserved.
+//
+
+#ifndef SCL_FLIC_BENCH_SUPPORT_H
+#define SCL_FLIC_BENCH_SUPPORT_H
+
+#include <atomic>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "Classifier.h"
+#include "Manager.h"
+#include "Random.h"
+#include "SimulatedPeripheral.h"
+
+namespace scl {
+namespace bench {
+
+using namespace scl::flic;
+
+/*!
+ *  @class CountingDelegate
+ *
+ *  @discussion Counts every button callback. Safe to use from a delegate executor thread.
+ *
+ */
+class CountingDelegate : public ButtonDelegate
+{
+public:
+    void didReceiveButtonDown(Button&, bool, long) override { events++; }
+    void didReceiveButtonUp(Button&, bool, long) override { events++; }
+    void didReceiveButtonClick(Button&, bool, long) override { events++; }
+    void didReceiveButtonDoubleClick(Button&, bool, long) override { events++; }
+    void didReceiveButtonHold(Button&, bool, long) override { events++; }
+    void didReceiveButtonProvisionalClick(Button&, bool, long) override { events++; }
+    void didReceiveQueuedEvents(Button&, const QueuedEventBatch& batch) override
+    {
+        events += batch.count;
+        batches++;
+    }
+    void isReady(Button&) override { ready++; }
+
+    std::atomic<uint64_t> events { 0 };
+    std::atomic<uint64_t> batches { 0 };
+    std::atomic<uint64_t> ready { 0 };
+};
+
+/*!
+ *  @class NullTransport
+ *
+ *  @discussion A transport that never connects, for benchmarks that only need buttons to exist.
+ *
+ */
+class NullTransport : public Transport
+{
+public:
+    void connect() override {}
+    void disconnect() override {}
+    void write(const uint8_t*, size_t) override {}
+    void readRSSI() override {}
+};
+
+/*!
+ *  @class SimulatedFleet
+ *
+ *  @discussion A Manager with <code>count</code> buttons, each on its own SimulatedPeripheral and SimulatedLink, all
+ *              connected and ready once the constructor returns unless <code>connectionSlots</code> limits how many can be.
+ *
+ */
+class SimulatedFleet
+{
+public:
+    SimulatedFleet(size_t count, Executor* executor = nullptr, LinkParameters parameters = LinkParameters(),
+                   size_t connectionSlots = 0)
+    {
+        for (size_t i = 0; i < count; i++)
+        {
+            ButtonInfo info;
+            info.identifier = "B" + std::to_string(i);
+            uint64_t seed = i;
+            for (uint8_t& byte : info.longTermKey)
+            {
+                byte = (uint8_t)splitMix64(seed);
+            }
+            infos.push_back(info);
+            peripherals.emplace_back(new SimulatedPeripheral(scheduler, info.longTermKey, i));
+            links.emplace_back(new SimulatedLink(scheduler, *peripherals.back(), parameters));
+        }
+        manager.reset(new Manager(scheduler, nullptr, &delegate, executor));
+        manager->setConnectionSlots(connectionSlots);
+        for (size_t i = 0; i < count; i++)
+        {
+            buttons.push_back(manager->addButton(infos[i], *links[i]));
+        }
+        scheduler.advanceBy(kNanosPerSecond);
+    }
+
+    ~SimulatedFleet()
+    {
+        // Buttons hold on to their links, and links to their peripherals.
+        manager.reset();
+        links.clear();
+    }
+
+    /*!
+     *  @method clickAll:
+     *
+     *  @discussion Presses and releases every button and lets the resulting events through.
+     *
+     */
+    void clickAll(Timestamp pressDuration = 60 * kNanosPerMilli)
+    {
+        for (auto& peripheral : peripherals)
+        {
+            peripheral->press();
+        }
+        scheduler.advanceBy(pressDuration);
+        for (auto& peripheral : peripherals)
+        {
+            peripheral->release();
+        }
+        scheduler.advanceBy(Classifier::kDoubleClickWindow + 200 * kNanosPerMilli);
+    }
+
+    ManualScheduler scheduler;
+    CountingDelegate delegate;
+    std::vector<ButtonInfo> infos;
+    std::vector<std::unique_ptr<SimulatedPeripheral>> peripherals;
+    std::vector<std::unique_ptr<SimulatedLink>> links;
+    std::unique_ptr<Manager> manager;
+    std::vector<Button*> buttons;
+};
+
+/*!
+ *  @method temporaryPath:
+ *
+ *  @discussion A path for a scratch file in <code>$TMPDIR</code>, or <code>/tmp</code>.
+ *
+ */
+inline std::string temporaryPath(const std::string& name)
+{
+    const char* directory = getenv("TMPDIR");
+    return std::string(directory && *directory ? directory : "/tmp") + "/flic-bench-" + name;
+}
+
+/*!
+ *  @method syntheticPressTrace:seed:
+ *
+ *  @discussion A reproducible stand-in for a recorded press trace: mostly single clicks with user specific timing, one in
+ *              eight presses a double click and one in twenty a hold.
+ *
+ */
+inline std::vector<PressTransition> syntheticPressTrace(size_t presses, uint64_t seed)
+{
+    std::vector<PressTransition> transitions;
+    transitions.reserve(presses * 2);
+    Timestamp time = 0;
+    for (size_t i = 0; i < presses; i++)
+    {
+        uint64_t random = splitMix64(seed);
+        time += (Timestamp)(700 + random % 3000) * kNanosPerMilli;
+        Timestamp length = (Timestamp)(60 + (random >> 16) % 90) * kNanosPerMilli;
+        unsigned kind = (unsigned)((random >> 32) % 40);
+        if (kind < 2)
+        {
+            length += 1200 * kNanosPerMilli;
+        }
+        transitions.push_back(PressTransition { time, true });
+        time += length;
+        transitions.push_back(PressTransition { time, false });
+        if (kind >= 2 && kind < 7)
+        {
+            time += (Timestamp)(80 + (random >> 40) % 120) * kNanosPerMilli;
+            transitions.push_back(PressTransition { time, true });
+            time += length;
+            transitions.push_back(PressTransition { time, false });
+            i++;
+        }
+    }
+    return transitions;
+}
+
+} // namespace bench
+} // namespace scl
+
+#endif // SCL_FLIC_BENCH_SUPPORT_H
@@ -0,0 +1,514 @@
+//
+//  @file Benchmark.cpp
+//  @framework fliclib-core
+//
+//  Copyright (c) 2016-2026 Shortcut Labs. All rights reserved.
+//
+
+#include "Benchmark.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <memory>
+#include <new>
+#include <thread>
+
+namespace scl {
+namespace bench {
+
+namespace {
+
+std::atomic<uint64_t> allocations { 0 };
+
+int64_t realNow()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+int64_t cpuNow()
+{
+    timespec time;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &time);
+    return (int64_t)time.tv_sec * 1000000000 + time.tv_nsec;
+}
+
+std::vector<std::unique_ptr<Benchmark>>& registry()
+{
+    static std::vector<std::unique_ptr<Benchmark>> benchmarks;
+    return benchmarks;
+}
+
+std::string escapeJSON(const std::string& value)
+{
+    std::string escaped;
+    for (char c : value)
+    {
+        if (c == '"' || c == '\\')
+        {
+            escaped += '\\';
+        }
+        escaped += c;
+    }
+    return escaped;
+}
+
+} // namespace
+
+uint64_t allocationCount()
+{
+    return allocations.load(std::memory_order_relaxed);
+}
+
+State::State(uint64_t maxIterations, const std::vector<int64_t>& args)
+    : _maxIterations(maxIterations),
+      _remaining(maxIterations),
+      _args(args)
+{
+}
+
+bool State::keepRunning()
+{
+    if (!_started)
+    {
+        _started = true;
+        resumeTiming();
+    }
+    if (_remaining > 0 && _error.empty())
+    {
+        _remaining--;
+        return true;
+    }
+    pauseTiming();
+    return false;
+}
+
+void State::pauseTiming()
+{
+    if (!_running)
+    {
+        return;
+    }
+    _realTime += realNow() - _realStart;
+    _cpuTime += cpuNow() - _cpuStart;
+    _running = false;
+}
+
+void State::resumeTiming()
+{
+    if (_running)
+    {
+        return;
+    }
+    _realStart = realNow();
+    _cpuStart = cpuNow();
+    _running = true;
+}
+
+Benchmark* Benchmark::arg(int64_t value)
+{
+    _args.push_back({ value });
+    return this;
+}
+
+Benchmark* Benchmark::args(const std::vector<int64_t>& values)
+{
+    _args.push_back(values);
+    return this;
+}
+
+Benchmark* Benchmark::minTime(double seconds)
+{
+    _minTime = seconds;
+    return this;
+}
+
+Benchmark* Benchmark::iterations(uint64_t count)
+{
+    _iterations = count;
+    return this;
+}
+
+Benchmark* registerBenchmark(const std::string& name, Function function)
+{
+    registry().emplace_back(new Benchmark(name, function));
+    return registry().back().get();
+}
+
+struct Result
+{
+    std::string name;
+    uint64_t iterations = 0;
+    double realTime = 0;
+    double cpuTime = 0;
+    double itemsPerSecond = 0;
+    std::map<std::string, double> counters;
+    std::string error;
+};
+
+class Runner
+{
+public:
+    static Result run(const Benchmark& benchmark, const std::string& name, const std::vector<int64_t>& args,
+                      double minTime)
+    {
+        double target = benchmark._minTime > 0 ? benchmark._minTime : minTime;
+        uint64_t iterations = benchmark._iterations ? benchmark._iterations : 1;
+        while (true)
+        {
+            State state(iterations, args);
+            benchmark._function(state);
+            double seconds = (double)state._realTime / 1e9;
+            bool done = benchmark._iterations || !state._error.empty() || seconds >= target || iterations >= 1000000000;
+            if (done)
+            {
+                Result result;
+                result.name = name;
+                result.iterations = iterations;
+                result.realTime = (double)state._realTime / (double)iterations;
+                result.cpuTime = (double)state._cpuTime / (double)iterations;
+                result.itemsPerSecond = state._items && state._realTime ? (double)state._items / seconds : 0;
+                result.counters = state._counters;
+                result.error = state._error;
+                return result;
+            }
+            // Aim 40% past the target from the last measurement, growing at most tenfold per round.
+            double scale = seconds > 0 ? target * 1.4 / seconds : 10;
+            scale = scale > 10 ? 10 : scale < 2 ? 2 : scale;
+            iterations = (uint64_t)((double)iterations * scale);
+        }
+    }
+
+    static std::vector<std::pair<std::string, const std::vector<int64_t>*>> instances(const Benchmark& benchmark)
+    {
+        static const std::vector<int64_t> kNoArgs;
+        std::vector<std::pair<std::string, const std::vector<int64_t>*>> instances;
+        if (benchmark._args.empty())
+        {
+            instances.emplace_back(benchmark._name, &kNoArgs);
+        }
+        for (auto& args : benchmark._args)
+        {
+            std::string name = benchmark._name;
+            for (int64_t value : args)
+            {
+                name += "/" + std::to_string(value);
+            }
+            instances.emplace_back(name, &args);
+        }
+        return instances;
+    }
+};
+
+namespace {
+
+void printConsoleHeader()
+{
+    printf("%-48s %14s %14s %12s %14s\n", "Benchmark", "Time (ns)", "CPU (ns)", "Iterations", "Items/s");
+    printf("%s\n", std::string(106, '-').c_str());
+}
+
+void printConsole(const Result& result)
+{
+    if (!result.error.empty())
+    {
+        printf("%-48s ERROR: %s\n", result.name.c_str(), result.error.c_str());
+        return;
+    }
+    printf("%-48s %14.1f %14.1f %12llu", result.name.c_str(), result.realTime, result.cpuTime,
+           (unsigned long long)result.iterations);
+    if (result.itemsPerSecond > 0)
+    {
+        printf(" %14.4g", result.itemsPerSecond);
+    }
+    for (auto& counter : result.counters)
+    {
+        printf(" %s=%g", counter.first.c_str(), counter.second);
+    }
+    printf("\n");
+    fflush(stdout);
+}
+
+std::string toJSON(const std::vector<Result>& results)
+{
+    char buffer[256];
+    std::string json = "{\n  \"context\": {\n";
+    time_t now = time(nullptr);
+    strftime(buffer, sizeof(buffer), "%Y-%m-%dT%H:%M:%SZ", gmtime(&now));
+    json += "    \"date\": \"" + std::string(buffer) + "\",\n";
+    json += "    \"num_cpus\": " + std::to_string(std::thread::hardware_concurrency()) + ",\n";
+#ifdef NDEBUG
+    json += "    \"library_build_type\": \"release\"\n";
+#else
+    json += "    \"library_build_type\": \"debug\"\n";
+#endif
+    json += "  },\n  \"benchmarks\": [";
+    for (size_t i = 0; i < results.size(); i++)
+    {
+        const Result& result = results[i];
+        json += i ? ",\n    {\n" : "\n    {\n";
+        json += "      \"name\": \"" + escapeJSON(result.name) + "\",\n";
+        if (!result.error.empty())
+        {
+            json += "      \"error_occurred\": true,\n";
+            json += "      \"error_message\": \"" + escapeJSON(result.error) + "\",\n";
+        }
+        snprintf(buffer, sizeof(buffer),
+                 "      \"iterations\": %llu,\n      \"real_time\": %.3f,\n      \"cpu_time\": %.3f,\n"
+                 "      \"time_unit\": \"ns\"",
+                 (unsigned long long)result.iterations, result.realTime, result.cpuTime);
+        json += buffer;
+        if (result.itemsPerSecond > 0)
+        {
+            snprintf(buffer, sizeof(buffer), ",\n      \"items_per_second\": %.6g", result.itemsPerSecond);
+            json += buffer;
+        }
+        for (auto& counter : result.counters)
+        {
+            snprintf(buffer, sizeof(buffer), ",\n      \"%s\": %.6g", escapeJSON(counter.first).c_str(), counter.second);
+            json += buffer;
+        }
+        json += "\n    }";
+    }
+    json += "\n  ]\n}\n";
+    return json;
+}
+
+bool parseOption(const char* argument, const char* name, std::string& value)
+{
+    size_t length = strlen(name);
+    if (strncmp(argument, name, length) != 0 || argument[length] != '=')
+    {
+        return false;
+    }
+    value = argument + length + 1;
+    return true;
+}
+
+} // namespace
+
+int runBenchmarks(int argc, char** argv)
+{
+    std::string filter;
+    std::string format = "console";
+    std::string out;
+    std::string minTimeText;
+    double minTime = 0.5;
+    for (int i = 1; i < argc; i++)
+    {
+        if (parseOption(argv[i], "--filter", filter) || parseOption(argv[i], "--format", format) ||
+            parseOption(argv[i], "--out", out))
+        {
+            continue;
+        }
+        if (parseOption(argv[i], "--min_time", minTimeText))
+        {
+            minTime = atof(minTimeText.c_str());
+            continue;
+        }
+        fprintf(stderr, "usage: %s [--filter=substring] [--min_time=seconds] [--format=console|json] [--out=path]\n",
+                argv[0]);
+        return 2;
+    }
+    bool console = format != "json";
+
+    std::vector<Result> results;
+    if (console)
+    {
+        printConsoleHeader();
+    }
+    for (auto& benchmark : registry())
+    {
+        for (auto& instance : Runner::instances(*benchmark))
+        {
+            if (!filter.empty() && instance.first.find(filter) == std::string::npos)
+            {
+                continue;
+            }
+            results.push_back(Runner::run(*benchmark, instance.first, *instance.second, minTime));
+            if (console)
+            {
+                printConsole(results.back());
+            }
+        }
+    }
+
+    std::string json = toJSON(results);
+    if (!console)
+    {
+        fputs(json.c_str(), stdout);
+    }
+    if (!out.empty())
+    {
+        FILE* file = fopen(out.c_str(), "w");
+        if (!file || fputs(json.c_str(), file) < 0)
+        {
+            fprintf(stderr, "could not write %s\n", out.c_str());
+            return 1;
+        }
+        fclose(file);
+    }
+    for (auto& result : results)
+    {
+        if (!result.error.empty())
+        {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+} // namespace bench
+} // namespace scl
+
+// The allocation counter replaces the whole set of global allocation functions, so that whatever form a block is
+// allocated with, it is counted once and released by a matching replacement. The plain and array forms get their memory
+// from malloc, the aligned ones from aligned_alloc, and all of them return it with free. GCC does not know that these
+// replacements pair up and warns about handing memory of operator new to free, so the warning is off for this set only
+// (older GCCs do not know the warning, hence -Wpragmas).
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wpragmas"
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+
+namespace {
+
+void* countedAllocate(size_t size) noexcept
+{
+    scl::bench::allocations.fetch_add(1, std::memory_order_relaxed);
+    return malloc(size ? size : 1);
+}
+
+void* countedAllocate(size_t size, std::align_val_t alignment) noexcept
+{
+    scl::bench::allocations.fetch_add(1, std::memory_order_relaxed);
+    size_t align = std::max((size_t)alignment, sizeof(void*));
+    // aligned_alloc wants a size that is a multiple of the alignment.
+    return aligned_alloc(align, (std::max(size, (size_t)1) + align - 1) / align * align);
+}
+
+} // namespace
+
+void* operator new(size_t size)
+{
+    void* memory = countedAllocate(size);
+    if (!memory)
+    {
+        throw std::bad_alloc();
+    }
+    return memory;
+}
+
+void* operator new[](size_t size)
+{
+    return operator new(size);
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept
+{
+    return countedAllocate(size);
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept
+{
+    return countedAllocate(size);
+}
+
+void* operator new(size_t size, std::align_val_t alignment)
+{
+    void* memory = countedAllocate(size, alignment);
+    if (!memory)
+    {
+        throw std::bad_alloc();
+    }
+    return memory;
+}
+
+void* operator new[](size_t size, std::align_val_t alignment)
+{
+    return operator new(size, alignment);
+}
+
+void* operator new(size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+    return countedAllocate(size, alignment);
+}
+
+void* operator new[](size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+    return countedAllocate(size, alignment);
+}
+
+void operator delete(void* memory) noexcept
+{
+    free(memory);
+}
+
+void operator delete[](void* memory) noexcept
+{
+    free(memory);
+}
+
+void operator delete(void* memory, size_t) noexcept
+{
+    free(memory);
+}
+
+void operator delete[](void* memory, size_t) noexcept
+{
+    free(memory);
+}
+
+void operator delete(void* memory, const std::nothrow_t&) noexcept
+{
+    free(memory);
+}
+
+void operator delete[](void* memory, const std::nothrow_t&) noexcept
+{
+    free(memory);
+}
+
+void operator delete(void* memory, std::align_val_t) noexcept
+{
+    free(memory);
+}
+
+void operator delete[](void* memory, std::align_val_t) noexcept
+{
+    free(memory);
+}
+
+void operator delete(void* memory, size_t, std::align_val_t) noexcept
+{
+    free(memory);
+}
+
+void operator delete[](void* memory, size_t, std::align_val_t) noexcept
+{
+    free(memory);
+}
+
+void operator delete(void* memory, std::align_val_t, const std::nothrow_t&) noexcept
+{
+    free(memory);
+}
+
+void operator delete[](void* memory, std::align_val_t, const std::nothrow_t&) noexcept
+{
+    free(memory);
+}
+
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+
+int main(int argc, char** argv)
+{
+    return scl::bench::runBenchmarks(argc, argv);
+}
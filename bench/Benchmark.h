@@ -0,0 +1,179 @@
+//
+//  @file Benchmark.h
+//  @framework fliclib-core
+//
+//  Copyright (c) 2016-2026 Shortcut Labs. All rights reserved.
+//
+
+#ifndef SCL_FLIC_BENCHMARK_H
+#define SCL_FLIC_BENCHMARK_H
+
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace scl {
+namespace bench {
+
+/*!
+ *  @class State
+ *
+ *  @discussion Handed to a benchmark function, which runs its measured work once per iteration of
+ *              <code>while (state.keepRunning())</code>. Setup before the loop and teardown after it are not timed.
+ *              The harness calls the function repeatedly with a growing iteration count until the loop takes at least the
+ *              minimum time, and reports the last run.
+ *
+ */
+class State
+{
+public:
+    State(uint64_t maxIterations, const std::vector<int64_t>& args);
+
+    bool keepRunning();
+
+    /*!
+     *  @method pauseTiming
+     *
+     *  @discussion Excludes work inside the loop from the measured time until <code>resumeTiming</code> is called.
+     *
+     */
+    void pauseTiming();
+    void resumeTiming();
+
+    int64_t arg(size_t index = 0) const { return _args[index]; }
+    uint64_t iterations() const { return _maxIterations; }
+
+    /*!
+     *  @method setItemsProcessed:
+     *
+     *  @discussion Reported as <code>items_per_second</code> in addition to the time per iteration, e.g. events delivered.
+     *
+     */
+    void setItemsProcessed(uint64_t items) { _items = items; }
+
+    /*!
+     *  @method setCounter:value:
+     *
+     *  @discussion Adds a named result to the report as is, e.g. a percentile of a latency histogram in nanoseconds.
+     *
+     */
+    void setCounter(const std::string& name, double value) { _counters[name] = value; }
+
+    void skipWithError(const std::string& message) { _error = message; }
+
+private:
+    friend class Runner;
+
+    uint64_t _maxIterations;
+    uint64_t _remaining;
+    const std::vector<int64_t>& _args;
+    bool _started = false;
+    bool _running = false;
+    int64_t _realStart = 0;
+    int64_t _cpuStart = 0;
+    int64_t _realTime = 0;
+    int64_t _cpuTime = 0;
+    uint64_t _items = 0;
+    std::map<std::string, double> _counters;
+    std::string _error;
+};
+
+typedef std::function<void(State&)> Function;
+
+/*!
+ *  @method doNotOptimize:
+ *
+ *  @discussion Keeps the compiler from discarding a result that is otherwise unused.
+ *
+ */
+template <class T>
+inline void doNotOptimize(const T& value)
+{
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+/*!
+ *  @method allocationCount
+ *
+ *  @discussion The number of times operator new has been called in the whole process so far, from any thread. The
+ *              difference across a piece of work counts its heap allocations.
+ *
+ */
+uint64_t allocationCount();
+
+/*!
+ *  @class Benchmark
+ *
+ *  @discussion A registered benchmark. Every argument added with <code>arg</code> makes it run once more, named
+ *              <code>name/arg</code>.
+ *
+ */
+class Benchmark
+{
+public:
+    Benchmark(const std::string& name, Function function) : _name(name), _function(function) {}
+
+    Benchmark* arg(int64_t value);
+    Benchmark* args(const std::vector<int64_t>& values);
+
+    /*!
+     *  @method minTime:
+     *
+     *  @discussion Overrides the minimum measured time of this benchmark, in seconds.
+     *
+     */
+    Benchmark* minTime(double seconds);
+
+    /*!
+     *  @method iterations:
+     *
+     *  @discussion Runs exactly this many iterations instead of growing the count, for benchmarks that are a whole
+     *              simulation per iteration.
+     *
+     */
+    Benchmark* iterations(uint64_t count);
+
+private:
+    friend class Runner;
+
+    std::string _name;
+    Function _function;
+    std::vector<std::vector<int64_t>> _args;
+    double _minTime = 0;
+    uint64_t _iterations = 0;
+};
+
+Benchmark* registerBenchmark(const std::string& name, Function function);
+
+/*!
+ *  @method runBenchmarks:argv:
+ *
+ *  @discussion Runs the registered benchmarks. Understands <code>--filter=substring</code>, <code>--min_time=seconds</code>,
+ *              <code>--format=console|json</code> and <code>--out=path</code>, which writes the JSON report to a file
+ *              whatever the console format.
+ *
+ *  @return The process exit code.
+ *
+ */
+int runBenchmarks(int argc, char** argv);
+
+} // namespace bench
+} // namespace scl
+
+#define SCL_BENCH_CONCAT2(a, b) a##b
+#define SCL_BENCH_CONCAT(a, b) SCL_BENCH_CONCAT2(a, b)
+
+/*!
+ *  @define BENCHMARK
+ *
+ *  @discussion Registers a <code>void f(scl::bench::State&)</code> under its own name at static initialization time. The
+ *              result can be chained, e.g. <code>BENCHMARK(BM_Dispatch)->arg(1)->arg(10)</code>.
+ *
+ */
+#define BENCHMARK(function)                                                                                              \
+    static scl::bench::Benchmark* SCL_BENCH_CONCAT(benchmark_, __LINE__) =                                             \
+        scl::bench::registerBenchmark(#function, function)
+
+#endif // SCL_FLIC_BENCHMARK_H
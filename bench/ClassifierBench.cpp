@@ -0,0 +1,89 @@
+//
+//  @file ClassifierBench.cpp
+//  @framework fliclib-core
+//
+//  Copyright (c) 2016-2026 Shortcut Labs. All rights reserved.
+//
+
+#include "Benchmark.h"
+#include "BenchSupport.h"
+
+namespace scl {
+namespace bench {
+
+namespace {
+
+class NullListener : public ClassifierListener
+{
+public:
+    void classifierDidEmit(EventType type, Timestamp time, bool queued) override
+    {
+        (void)time;
+        (void)queued;
+        emitted[(int)type]++;
+    }
+
+    uint64_t emitted[kEventTypeCount] = {};
+};
+
+const size_t kTracePresses = 20000;
+
+double millis(Timestamp time)
+{
+    return (double)time / kNanosPerMilli;
+}
+
+} // namespace
+
+// Cost of classifying one press, with the window resolved through expire like the classifier timer does.
+void BM_ClassifyPress(State& state)
+{
+    NullListener listener;
+    Classifier classifier(listener);
+    classifier.setBehavior((TriggerBehavior)state.arg());
+    Timestamp time = 0;
+    while (state.keepRunning())
+    {
+        classifier.buttonDown(time, false);
+        classifier.buttonUp(time + 80 * kNanosPerMilli, false);
+        time += 2 * kNanosPerSecond;
+        classifier.expire(time - kNanosPerSecond);
+    }
+    doNotOptimize(listener.emitted);
+    state.setItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_ClassifyPress)->arg(0)->arg(1)->arg(2)->arg(3);
+
+// Decision latency of each trigger behavior over a press trace, plain (0), speculative (1), adaptive (2) or both (3),
+// and how many press sequences end up classified differently than with the fixed windows.
+void BM_ClassifierTrace(State& state)
+{
+    std::vector<PressTransition> trace = syntheticPressTrace(kTracePresses, 1);
+    ClassifierTraceOptions options;
+    options.behavior = (TriggerBehavior)state.arg(0);
+    std::vector<ClassifiedSequence> reference;
+    runClassifierTrace(options, trace.data(), trace.size(), &reference);
+
+    options.speculative = (state.arg(1) & 1) != 0;
+    options.adaptive = (state.arg(1) & 2) != 0;
+    std::vector<ClassifiedSequence> sequences;
+    ClassifierTraceStats stats;
+    while (state.keepRunning())
+    {
+        sequences.clear();
+        stats = runClassifierTrace(options, trace.data(), trace.size(), &sequences);
+    }
+    state.setItemsProcessed(state.iterations() * trace.size());
+    state.setCounter("click_ms", millis(stats.meanDelay(EventType::ButtonClick)));
+    state.setCounter("provisional_click_ms", millis(stats.meanDelay(EventType::ButtonProvisionalClick)));
+    state.setCounter("double_click_ms", millis(stats.meanDelay(EventType::ButtonDoubleClick)));
+    state.setCounter("hold_ms", millis(stats.meanDelay(EventType::ButtonHold)));
+    state.setCounter("misclassified", misclassificationRate(reference, sequences));
+}
+BENCHMARK(BM_ClassifierTrace)
+    ->args({ 0, 0 })->args({ 0, 2 })
+    ->args({ 1, 0 })->args({ 1, 1 })->args({ 1, 2 })->args({ 1, 3 })
+    ->args({ 2, 0 })->args({ 2, 1 })->args({ 2, 2 })->args({ 2, 3 });
+
+} // namespace bench
+} // namespace scl
@@ -0,0 +1,170 @@
+//
+//  @file CodecBench.cpp
+//  @framework fliclib-core
+//
+//  Copyright (c) 2016-2026 Shortcut Labs. All rights reserved.
+//
+
+#include "Benchmark.h"
+#include "BenchSupport.h"
+#include "Packet.h"
+
+namespace scl {
+namespace bench {
+
+namespace {
+
+const size_t kPacketRing = 4096;
+
+void sessionKey(uint8_t key[kSessionKeySize])
+{
+    uint64_t seed = 42;
+    for (size_t i = 0; i < kSessionKeySize; i++)
+    {
+        key[i] = (uint8_t)splitMix64(seed);
+    }
+}
+
+// Signed button event packets as a flic would send them, with consecutive counters.
+std::vector<Packet> signedEvents(size_t count)
+{
+    uint8_t key[kSessionKeySize];
+    sessionKey(key);
+    PacketSigner signer(false);
+    signer.reset(key);
+    std::vector<Packet> packets(count);
+    for (size_t i = 0; i < count; i++)
+    {
+        ButtonEventPayload event;
+        event.pressCounter = (uint32_t)i + 1;
+        event.down = (i & 1) == 0;
+        event.eventTicks = (uint32_t)i * 3000;
+        event.sentTicks = event.eventTicks + 5;
+        encodeButtonEvent(packets[i], event);
+        signer.sign(packets[i]);
+    }
+    return packets;
+}
+
+} // namespace
+
+void BM_ChaskeyMac(State& state)
+{
+    uint8_t key[ChaskeyKey::kKeySize] = { 1, 2, 3 };
+    ChaskeyKey chaskey(key);
+    uint8_t message[16] = { 7 };
+    uint8_t tag[kSignatureSize];
+    while (state.keepRunning())
+    {
+        chaskey.mac(message, sizeof(message), tag, sizeof(tag));
+        message[0] = tag[0];
+    }
+    doNotOptimize(tag);
+    state.setItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_ChaskeyMac);
+
+void BM_DecodeButtonEvent(State& state)
+{
+    std::vector<Packet> packets = signedEvents(kPacketRing);
+    DecodedPacket decoded;
+    uint64_t i = 0;
+    while (state.keepRunning())
+    {
+        const Packet& packet = packets[i++ % kPacketRing];
+        Error error = decodePacket(packet.bytes, packet.size, decoded);
+        doNotOptimize(error);
+        doNotOptimize(decoded);
+    }
+    state.setItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_DecodeButtonEvent);
+
+void BM_SignPacket(State& state)
+{
+    uint8_t key[kSessionKeySize];
+    sessionKey(key);
+    PacketSigner signer(true);
+    signer.reset(key);
+    Packet packet;
+    while (state.keepRunning())
+    {
+        encodeEventAck(packet, (uint32_t)signer.txCounter());
+        signer.sign(packet);
+        doNotOptimize(packet);
+    }
+    state.setItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_SignPacket);
+
+void BM_VerifyButtonEvent(State& state)
+{
+    std::vector<Packet> packets = signedEvents(kPacketRing);
+    uint8_t key[kSessionKeySize];
+    sessionKey(key);
+    PacketSigner signer(true);
+    signer.reset(key);
+    uint64_t i = 0;
+    uint64_t failures = 0;
+    while (state.keepRunning())
+    {
+        if (i == kPacketRing)
+        {
+            // The receive counter has to start over together with the packets.
+            state.pauseTiming();
+            signer.reset(key);
+            i = 0;
+            state.resumeTiming();
+        }
+        const Packet& packet = packets[i++];
+        failures += !signer.verify(packet.bytes, packet.size);
+    }
+    if (failures)
+    {
+        state.skipWithError("signature verification failed");
+    }
+    state.setItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_VerifyButtonEvent);
+
+// The same packets as BM_VerifyButtonEvent, checked arg(0) at a time the way a burst of queued events is. Compare the
+// items per second of the two.
+void BM_VerifyButtonEventBatch(State& state)
+{
+    size_t batch = (size_t)state.arg(0);
+    std::vector<Packet> packets = signedEvents(kPacketRing);
+    std::vector<const uint8_t*> data(kPacketRing);
+    std::vector<size_t> sizes(kPacketRing);
+    for (size_t i = 0; i < kPacketRing; i++)
+    {
+        data[i] = packets[i].bytes;
+        sizes[i] = packets[i].size;
+    }
+    uint8_t key[kSessionKeySize];
+    sessionKey(key);
+    PacketSigner signer(true);
+    signer.reset(key);
+    size_t i = 0;
+    uint64_t failures = 0;
+    while (state.keepRunning())
+    {
+        if (i == kPacketRing)
+        {
+            state.pauseTiming();
+            signer.reset(key);
+            i = 0;
+            state.resumeTiming();
+        }
+        failures += batch - signer.verifyBatch(&data[i], &sizes[i], batch);
+        i += batch;
+    }
+    if (failures)
+    {
+        state.skipWithError("signature verification failed");
+    }
+    state.setItemsProcessed(state.iterations() * batch);
+}
+BENCHMARK(BM_VerifyButtonEventBatch)->arg(8)->arg(64);
+
+} // namespace bench
+} // namespace scl
@@ -0,0 +1,324 @@
+//
+//  @file ConnectionBench.cpp
+//  @framework fliclib-core
+//
+//  Copyright (c) 2016-2026 Shortcut Labs. All rights reserved.
+//
+
+#include <deque>
+#include <unordered_map>
+
+#include "Benchmark.h"
+#include "BenchSupport.h"
+
+namespace scl {
+namespace bench {
+
+namespace {
+
+// Simulated time from a press to its down event reaching the delegate, queued or not.
+class DeliveryLatencyDelegate : public ButtonDelegate
+{
+public:
+    void press(Button& button, SimulatedPeripheral& peripheral)
+    {
+        presses[&button].push_back(button.scheduler().now());
+        peripheral.press();
+    }
+
+    void didReceiveButtonDown(Button& button, bool, long) override
+    {
+        std::deque<Timestamp>& pending = presses[&button];
+        if (!pending.empty())
+        {
+            latency.record(button.scheduler().now() - pending.front());
+            pending.pop_front();
+        }
+    }
+
+    std::unordered_map<Button*, std::deque<Timestamp>> presses;
+    LatencyHistogram latency;
+};
+
+double millis(Timestamp time)
+{
+    return (double)time / kNanosPerMilli;
+}
+
+// Simulated time at which a button became ready.
+class ReadyDelegate : public ButtonDelegate
+{
+public:
+    void isReady(Button& button) override { readyAt = button.scheduler().now(); }
+
+    Timestamp readyAt = 0;
+};
+
+// Sessions of 5 to 30 presses with the timing of syntheticPressTrace, separated by 30 s to 10 min of idle time, the way
+// a button on a desk or a game controller tends to be used.
+std::vector<PressTransition> burstyPressTrace(size_t sessions, uint64_t seed)
+{
+    std::vector<PressTransition> transitions;
+    Timestamp start = 0;
+    for (size_t session = 0; session < sessions; session++)
+    {
+        uint64_t random = splitMix64(seed);
+        for (const PressTransition& transition : syntheticPressTrace(5 + random % 26, random))
+        {
+            transitions.push_back(PressTransition { start + transition.time, transition.down });
+        }
+        start = transitions.back().time + (Timestamp)(30 + (random >> 16) % 570) * kNanosPerSecond;
+    }
+    return transitions;
+}
+
+} // namespace
+
+// A fleet of the given number of buttons sharing the given number of connection slots (0 for one connection each), one
+// in twenty of them out of range. Every iteration is a simulated minute with a press every 250 ms, half of them on ten
+// busy buttons and the rest spread over the fleet. delivery_*_ms is the simulated press to delegate latency,
+// occupied the mean number of slots in use and rotations the idle buttons rotated off a slot per minute.
+void BM_ConnectionSlots(State& state)
+{
+    SimulatedFleet fleet((size_t)state.arg(0), nullptr, LinkParameters(), (size_t)state.arg(1));
+    DeliveryLatencyDelegate delegate;
+    for (size_t i = 0; i < fleet.buttons.size(); i++)
+    {
+        fleet.buttons[i]->setDelegate(&delegate);
+        fleet.peripherals[i]->setRSSI(-40 - (int)(i % 50));
+        if (i % 20 == 19)
+        {
+            fleet.peripherals[i]->setInRange(false);
+        }
+    }
+    fleet.scheduler.advanceBy(10 * kNanosPerSecond);
+
+    const Timestamp kPressInterval = 250 * kNanosPerMilli;
+    const Timestamp kPressDuration = 80 * kNanosPerMilli;
+    uint64_t seed = 11;
+    double occupied = 0;
+    uint64_t samples = 0;
+    ConnectionSlotStats before = fleet.manager->connectionSlotStats();
+    while (state.keepRunning())
+    {
+        for (Timestamp elapsed = 0; elapsed < 60 * kNanosPerSecond; elapsed += kPressInterval)
+        {
+            uint64_t random = splitMix64(seed);
+            size_t index = (random & 1) ? (size_t)(random >> 8) % 10 : (size_t)(random >> 8) % fleet.peripherals.size();
+            SimulatedPeripheral& peripheral = *fleet.peripherals[index];
+            if (peripheral.inRange())
+            {
+                delegate.press(*fleet.buttons[index], peripheral);
+                fleet.scheduler.advanceBy(kPressDuration);
+                peripheral.release();
+                fleet.scheduler.advanceBy(kPressInterval - kPressDuration);
+            }
+            else
+            {
+                fleet.scheduler.advanceBy(kPressInterval);
+            }
+            occupied += (double)fleet.manager->connectionSlotStats().occupied;
+            samples++;
+        }
+    }
+    ConnectionSlotStats after = fleet.manager->connectionSlotStats();
+    LatencySnapshot latency = delegate.latency.snapshot();
+    state.setItemsProcessed(latency.count);
+    state.setCounter("delivery_p50_ms", millis(latency.percentile(0.5)));
+    state.setCounter("delivery_p99_ms", millis(latency.percentile(0.99)));
+    state.setCounter("occupied", occupied / (double)samples);
+    state.setCounter("rotations", (double)(after.rotations - before.rotations) / (double)state.iterations());
+    state.setCounter("timeouts", (double)(after.timeouts - before.timeouts) / (double)state.iterations());
+}
+BENCHMARK(BM_ConnectionSlots)->args({ 500, 0 })->args({ 500, 8 })->args({ 500, 32 })->args({ 500, 128 });
+
+// Connect to ready of one button over a link that needs service discovery (2 round trips) and a notification
+// subscription (1 round trip), set up one step after the other (0) or pipelined (1), on the first connection of the
+// button (0) or a reconnect (1), when a pipelined connection can reuse the verified attribute layout. ready_ms is in
+// simulated time.
+void BM_ConnectToReady(State& state)
+{
+    bool pipelined = state.arg(0) != 0;
+    bool reconnect = state.arg(1) != 0;
+    ManualScheduler scheduler;
+    ButtonInfo info;
+    info.identifier = "B0";
+    SimulatedPeripheral peripheral(scheduler, info.longTermKey);
+    LinkParameters parameters;
+    parameters.discoveryRoundTrips = 2;
+    parameters.subscriptionRoundTrips = 1;
+    SimulatedLink link(scheduler, peripheral, parameters);
+    ReadyDelegate delegate;
+    std::unique_ptr<Button> button;
+    Timestamp readyTime = 0;
+    while (state.keepRunning())
+    {
+        if (!button || !reconnect)
+        {
+            button.reset(new Button(info, link, scheduler));
+            button->setDelegate(&delegate);
+            button->setPipelinedConnect(pipelined);
+            if (reconnect)
+            {
+                button->connect();
+                scheduler.runUntilIdle();
+                button->disconnect();
+                scheduler.runUntilIdle();
+            }
+        }
+
+        Timestamp start = scheduler.now();
+        delegate.readyAt = 0;
+        button->connect();
+        scheduler.runUntilIdle();
+        if (!delegate.readyAt)
+        {
+            state.skipWithError("button did not become ready");
+            break;
+        }
+        readyTime += delegate.readyAt - start;
+        button->disconnect();
+        scheduler.runUntilIdle();
+    }
+    button.reset();
+    state.setItemsProcessed(state.iterations());
+    state.setCounter("ready_ms", (double)readyTime / (double)state.iterations() / kNanosPerMilli);
+    state.setCounter("discoveries", (double)link.discoveries() / (double)state.iterations());
+}
+BENCHMARK(BM_ConnectToReady)->args({ 0, 0 })->args({ 1, 0 })->args({ 0, 1 })->args({ 1, 1 });
+
+// A connected button that drops out of range for a second, from coming back in range to ready again, in simulated time.
+// The flic takes 100 ms to answer a full verification. Resumption off (0), on (1), or on with a flic that has lost the
+// ticket (2), which falls back to the full verification.
+void BM_ReconnectToReady(State& state)
+{
+    int mode = (int)state.arg(0);
+    ManualScheduler scheduler;
+    ButtonInfo info;
+    info.identifier = "B0";
+    SimulatedPeripheral peripheral(scheduler, info.longTermKey);
+    peripheral.setVerificationTime(100 * kNanosPerMilli);
+    LinkParameters parameters;
+    parameters.discoveryRoundTrips = 2;
+    parameters.subscriptionRoundTrips = 1;
+    SimulatedLink link(scheduler, peripheral, parameters);
+    ReadyDelegate delegate;
+    Button button(info, link, scheduler);
+    button.setDelegate(&delegate);
+    button.setSessionResumption(mode != 0);
+    button.connect();
+    scheduler.runUntilIdle();
+
+    Timestamp readyTime = 0;
+    uint64_t resumed = 0;
+    while (state.keepRunning())
+    {
+        peripheral.setInRange(false);
+        scheduler.advanceBy(kNanosPerSecond);
+        if (mode == 2)
+        {
+            peripheral.forgetTicket();
+        }
+        Timestamp start = scheduler.now();
+        delegate.readyAt = 0;
+        peripheral.setInRange(true);
+        scheduler.runUntilIdle();
+        if (!delegate.readyAt)
+        {
+            state.skipWithError("button did not become ready");
+            break;
+        }
+        readyTime += delegate.readyAt - start;
+        resumed += button.isSessionResumed();
+    }
+    state.setItemsProcessed(state.iterations());
+    state.setCounter("ready_ms", (double)readyTime / (double)state.iterations() / kNanosPerMilli);
+    state.setCounter("resumed", (double)resumed / (double)state.iterations());
+}
+BENCHMARK(BM_ReconnectToReady)->arg(0)->arg(1)->arg(2);
+
+// Click latency against radio duty cycle for each ConnectionProfile (arg 0: Balanced, Gaming, Kiosk, Battery), over a
+// link that models connection events with 1 ms of air and host stack delay. Every iteration is a simulated minute with a
+// click every 2 to 4 s at a random phase of the connection interval. click_*_ms is from the press to the down event in
+// simulated time, duty_cycle_pct the estimated share of the connected time the radio of the flic is on.
+void BM_ConnectionProfile(State& state)
+{
+    ConnectionProfile profile = (ConnectionProfile)state.arg(0);
+    const Timestamp kMinute = 60 * kNanosPerSecond;
+    const Timestamp kPressDuration = 80 * kNanosPerMilli;
+    ManualScheduler scheduler;
+    ButtonInfo info;
+    info.identifier = "B0";
+    SimulatedPeripheral peripheral(scheduler, info.longTermKey);
+    LinkParameters parameters;
+    parameters.latency = kNanosPerMilli;
+    parameters.modelsConnectionEvents = true;
+    SimulatedLink link(scheduler, peripheral, parameters);
+    Button button(info, link, scheduler);
+    DeliveryLatencyDelegate delegate;
+    button.setDelegate(&delegate);
+    button.setConnectionProfile(profile);
+    button.connect();
+    scheduler.advanceBy(kNanosPerSecond);
+    if (!button.isReady())
+    {
+        state.skipWithError("button did not become ready");
+        return;
+    }
+
+    uint64_t seed = 7;
+    Timestamp radioBefore = link.radioOnTime();
+    Timestamp connectedBefore = link.connectedTime();
+    while (state.keepRunning())
+    {
+        Timestamp end = scheduler.now() + kMinute;
+        while (scheduler.now() < end)
+        {
+            delegate.press(button, peripheral);
+            scheduler.advanceBy(kPressDuration);
+            peripheral.release();
+            scheduler.advanceBy(2 * kNanosPerSecond + (Timestamp)(splitMix64(seed) % (2 * kNanosPerSecond)));
+        }
+    }
+    LatencySnapshot latency = delegate.latency.snapshot();
+    state.setItemsProcessed(latency.count);
+    state.setCounter("interval_ms", millis(button.connectionInterval()));
+    state.setCounter("click_p50_ms", millis(latency.percentile(0.5)));
+    state.setCounter("click_p99_ms", millis(latency.percentile(0.99)));
+    state.setCounter("duty_cycle_pct", 100.0 * (double)(link.radioOnTime() - radioBefore) /
+                                           (double)(link.connectedTime() - connectedBefore));
+}
+BENCHMARK(BM_ConnectionProfile)->arg(0)->arg(1)->arg(2)->arg(3);
+
+// runConnectionTrace over 20 sessions of clicks with the given ConnectionProfile (arg 0) as is (arg 1 = 0) or with
+// adaptive latency (1). added_ms is the average time a down or up waited for a connection event, radio_s_per_hour the
+// radio on time of the flic per hour of the trace.
+void BM_AdaptiveLatency(State& state)
+{
+    ConnectionTraceOptions options;
+    options.profile = (ConnectionProfile)state.arg(0);
+    options.adaptiveLatency = state.arg(1) != 0;
+    options.link.latency = kNanosPerMilli;
+    std::vector<PressTransition> trace = burstyPressTrace(20, 3);
+    ConnectionTraceStats stats;
+    while (state.keepRunning())
+    {
+        stats = runConnectionTrace(options, trace.data(), trace.size());
+    }
+    if (stats.transitions != trace.size())
+    {
+        state.skipWithError("not every transition was delivered in real time");
+    }
+    state.setItemsProcessed(state.iterations() * stats.transitions);
+    state.setCounter("added_ms", millis(stats.averageAddedLatency()));
+    state.setCounter("added_max_ms", millis(stats.maxAddedLatency));
+    state.setCounter("duty_cycle_pct", 100.0 * stats.dutyCycle());
+    state.setCounter("radio_s_per_hour", (double)stats.radioOnTime / (double)kNanosPerSecond /
+                                             ((double)stats.connectedTime / (double)(3600 * kNanosPerSecond)));
+}
+BENCHMARK(BM_AdaptiveLatency)
+    ->args({ 0, 0 })->args({ 1, 0 })->args({ 3, 0 })
+    ->args({ 0, 1 })->args({ 3, 1 });
+
+} // namespace bench
+} // namespace scl
@@ -0,0 +1,358 @@
+//
+//  @file DispatchBench.cpp
+//  @framework fliclib-core
+//
+//  Copyright (c) 2016-2026 Shortcut Labs. All rights reserved.
+//
+
+#include <algorithm>
+#include <thread>
+
+#include "Benchmark.h"
+#include "BenchSupport.h"
+#include "EventCallback.h"
+#include "EventRing.h"
+
+extern "C" void sclBenchCountEvents(void* context, const SCLFlicButtonEventNotification* events, size_t count);
+
+namespace scl {
+namespace bench {
+
+namespace {
+
+void reportDeliverLatency(State& state, const Manager& manager)
+{
+    LatencySnapshot deliver = manager.latencySnapshot(LatencyStage::Deliver);
+    state.setCounter("deliver_p50_ns", (double)deliver.percentile(0.5));
+    state.setCounter("deliver_p99_ns", (double)deliver.percentile(0.99));
+}
+
+// Checks the button events that come out of an event ring on the consumer thread: each from a button of the fleet, in
+// the order of its flic clock, and without loss the down, up and click of every press in turn. Takes a while over each
+// event so that bursts fill the ring.
+class RingCheckDelegate : public ButtonDelegate
+{
+public:
+    RingCheckDelegate(size_t buttons, bool lossless)
+        : _lossless(lossless), _seen(buttons, false), _lastTicks(buttons, 0), _next(buttons, EventType::ButtonDown)
+    {
+    }
+
+    void didReceiveButtonDown(Button& button, bool queued, long) override { check(button, EventType::ButtonDown, queued); }
+    void didReceiveButtonUp(Button& button, bool queued, long) override { check(button, EventType::ButtonUp, queued); }
+    void didReceiveButtonClick(Button& button, bool queued, long) override
+    {
+        check(button, EventType::ButtonClick, queued);
+    }
+    void didReceiveButtonDoubleClick(Button&, bool, long) override { violations++; }
+    void didReceiveButtonHold(Button&, bool, long) override { violations++; }
+
+    uint64_t events = 0;
+    uint64_t violations = 0;
+
+private:
+    void check(Button& button, EventType type, bool queued)
+    {
+        events++;
+        uint32_t index = button.index();
+        if (index >= _lastTicks.size() || queued)
+        {
+            violations++;
+            return;
+        }
+        const EventTime& time = button.currentEventTime();
+        // The flic clock wraps around.
+        if ((_seen[index] && (int32_t)(time.buttonTicks - _lastTicks[index]) < 0) || time.receivedTime < time.eventTime)
+        {
+            violations++;
+        }
+        _seen[index] = true;
+        _lastTicks[index] = time.buttonTicks;
+        if (_lossless)
+        {
+            if (type != _next[index])
+            {
+                violations++;
+            }
+            _next[index] = type == EventType::ButtonDown ? EventType::ButtonUp
+                         : type == EventType::ButtonUp ? EventType::ButtonClick : EventType::ButtonDown;
+        }
+        for (volatile int i = 0; i < 200; i++)
+        {
+        }
+    }
+
+    bool _lossless;
+    std::vector<bool> _seen;
+    std::vector<uint32_t> _lastTicks;
+    std::vector<EventType> _next;
+};
+
+} // namespace
+
+// One click on every button of a fleet of the given size: receipt, verification, classification and delegate fan-out
+// of the down, up and click of each, plus the simulated radio around them.
+void BM_Dispatch(State& state)
+{
+    SimulatedFleet fleet((size_t)state.arg());
+    uint64_t before = fleet.delegate.events;
+    while (state.keepRunning())
+    {
+        fleet.clickAll();
+    }
+    state.setItemsProcessed(fleet.delegate.events - before);
+    reportDeliverLatency(state, *fleet.manager);
+}
+BENCHMARK(BM_Dispatch)->arg(1)->arg(10)->arg(100)->arg(1000);
+
+// Delegate delivery directly on the radio side (0), through the event ring onto an inline executor (1) or onto a serial
+// executor thread (2), the stand-in for the main queue.
+void BM_DispatchExecutor(State& state)
+{
+    InlineExecutor inlineExecutor;
+    SerialExecutor serialExecutor;
+    Executor* executors[] = { nullptr, &inlineExecutor, &serialExecutor };
+    SimulatedFleet fleet((size_t)state.arg(0), executors[state.arg(1)]);
+    serialExecutor.sync();
+    uint64_t before = fleet.delegate.events;
+    while (state.keepRunning())
+    {
+        fleet.clickAll();
+        serialExecutor.sync();
+    }
+    state.setItemsProcessed(fleet.delegate.events - before);
+    reportDeliverLatency(state, *fleet.manager);
+}
+BENCHMARK(BM_DispatchExecutor)
+    ->args({ 10, 0 })->args({ 10, 1 })->args({ 10, 2 })
+    ->args({ 100, 0 })->args({ 100, 1 })->args({ 100, 2 });
+
+// Reconnect of one button with a backlog of the given number of presses, delivered one callback per event (0) or as a
+// single QueuedEventBatch (1), with the given ack window. drain_ms is the simulated time from coming back in range to the
+// end of the backlog, acks_per_event the packets the host sent per event while draining.
+void BM_QueuedDrain(State& state)
+{
+    SimulatedFleet fleet(1);
+    SimulatedPeripheral& peripheral = *fleet.peripherals[0];
+    fleet.buttons[0]->setBatchesQueuedEvents(state.arg(1) != 0);
+    fleet.buttons[0]->setAckWindow((uint8_t)state.arg(2));
+    uint64_t before = fleet.delegate.events;
+    Timestamp drainTime = 0;
+    uint64_t acks = 0;
+    while (state.keepRunning())
+    {
+        state.pauseTiming();
+        peripheral.setInRange(false);
+        fleet.scheduler.runUntilIdle();
+        for (int64_t i = 0; i < state.arg(0); i++)
+        {
+            peripheral.press();
+            fleet.scheduler.advanceBy(50 * kNanosPerMilli);
+            peripheral.release();
+            fleet.scheduler.advanceBy(kNanosPerSecond);
+        }
+        state.resumeTiming();
+
+        Timestamp start = fleet.scheduler.now();
+        uint64_t sent = fleet.links[0]->packetsToPeripheral();
+        peripheral.setInRange(true);
+        fleet.scheduler.runUntilIdle();
+        drainTime += fleet.scheduler.now() - start;
+        // One of the packets is the verify request.
+        acks += fleet.links[0]->packetsToPeripheral() - sent - 1;
+    }
+    state.setItemsProcessed(fleet.delegate.events - before);
+    state.setCounter("drain_ms", (double)drainTime / (double)state.iterations() / kNanosPerMilli);
+    uint64_t queued = std::min<uint64_t>(2 * (uint64_t)state.arg(0), SimulatedPeripheral::kMaxQueuedEvents);
+    state.setCounter("acks_per_event", (double)acks / (double)(state.iterations() * queued));
+}
+BENCHMARK(BM_QueuedDrain)
+    ->args({ 10, 0, 1 })->args({ 10, 1, 1 })->args({ 10, 1, 32 })
+    ->args({ 100, 0, 1 })->args({ 100, 1, 1 })->args({ 100, 1, 32 })
+    ->args({ 1000, 0, 1 })->args({ 1000, 1, 1 })->args({ 1000, 1, 32 })->args({ 1000, 0, 32 });
+
+// One click on every button of a fleet of 100 with ClickAndDoubleClickAndHold, delivering every event (0) or with an
+// event mask of clicks only (1), directly on the radio side (0) or onto a serial executor thread (1). Items are presses,
+// callbacks_per_press the delegate callbacks each of them made.
+void BM_DispatchMask(State& state)
+{
+    SerialExecutor executor;
+    SimulatedFleet fleet(100, state.arg(1) ? &executor : nullptr);
+    for (Button* button : fleet.buttons)
+    {
+        button->setTriggerBehavior(TriggerBehavior::ClickAndDoubleClickAndHold);
+        if (state.arg(0))
+        {
+            button->setEventMask(eventMaskOf(EventType::ButtonClick));
+        }
+    }
+    executor.sync();
+    uint64_t before = fleet.delegate.events;
+    while (state.keepRunning())
+    {
+        fleet.clickAll();
+        executor.sync();
+    }
+    uint64_t presses = state.iterations() * fleet.buttons.size();
+    state.setItemsProcessed(presses);
+    state.setCounter("callbacks_per_press", (double)(fleet.delegate.events - before) / (double)presses);
+}
+BENCHMARK(BM_DispatchMask)->args({ 0, 0 })->args({ 1, 0 })->args({ 0, 1 })->args({ 1, 1 });
+
+// Steady state delivery of one click on every button of a fleet of 100, directly on the radio side (0) or onto a serial
+// executor thread (1), to the button delegates (0) or to an event callback written in C (1). After a few rounds to warm
+// up, the event callback must not allocate at all and must only get well formed events, the benchmark fails otherwise.
+void BM_EventCallback(State& state)
+{
+    SerialExecutor executor;
+    SimulatedFleet fleet(100, state.arg(0) ? &executor : nullptr);
+    // The events the callback got and how many of them were malformed.
+    uint64_t callbackEvents[2] = {};
+    if (state.arg(1))
+    {
+        fleet.manager->setEventCallback(&sclBenchCountEvents, callbackEvents);
+    }
+    for (int i = 0; i < 3; i++)
+    {
+        fleet.clickAll();
+        executor.sync();
+    }
+    uint64_t before = fleet.delegate.events + callbackEvents[0];
+    uint64_t allocations = allocationCount();
+    while (state.keepRunning())
+    {
+        fleet.clickAll();
+        executor.sync();
+    }
+    allocations = allocationCount() - allocations;
+    uint64_t events = fleet.delegate.events + callbackEvents[0] - before;
+    if (state.arg(1) && allocations != 0)
+    {
+        state.skipWithError("event delivery allocated");
+        return;
+    }
+    if (callbackEvents[1] != 0)
+    {
+        state.skipWithError("event callback got malformed events");
+        return;
+    }
+    state.setItemsProcessed(events);
+    state.setCounter("allocations_per_event", (double)allocations / (double)events);
+}
+BENCHMARK(BM_EventCallback)->args({ 0, 0 })->args({ 0, 1 })->args({ 1, 0 })->args({ 1, 1 });
+
+// Producer and consumer thread hammering an event ring of the given capacity with DropNewest (0) or Block (1).
+void BM_EventRing(State& state)
+{
+    EventRing<ButtonEventRecord> ring((size_t)state.arg(0), (OverflowPolicy)state.arg(1));
+    const uint64_t kRecords = 100000;
+    while (state.keepRunning())
+    {
+        std::atomic<bool> done { false };
+        std::thread consumer([&]
+        {
+            ButtonEventRecord record;
+            while (!done.load(std::memory_order_acquire) || !ring.empty())
+            {
+                if (!ring.pop(record))
+                {
+                    std::this_thread::yield();
+                }
+            }
+        });
+        ButtonEventRecord record;
+        for (uint64_t i = 0; i < kRecords; i++)
+        {
+            record.sequence = (uint32_t)i;
+            ring.push(record);
+        }
+        done.store(true, std::memory_order_release);
+        consumer.join();
+    }
+    EventRingCounters counters = ring.counters();
+    state.setItemsProcessed(counters.popped);
+    state.setCounter("dropped", (double)counters.dropped);
+    state.setCounter("stalls", (double)counters.stalls);
+}
+BENCHMARK(BM_EventRing)->args({ 64, 0 })->args({ 64, 1 })->args({ 1024, 0 })->args({ 1024, 1 });
+
+// Stress test of the event ring between the radio side and a consumer thread: a fleet of 200 buttons on the simulated
+// transport clicked all at once, so every press and release is a burst of 200 events into a ring of the given capacity,
+// with DropNewest (0) or Block (1). The consumer thread delivers to a delegate that checks every event. The benchmark
+// fails if an event arrives out of order or garbled, if the delivered and dropped events do not add up to the events
+// produced, if Block loses any, or if the high watermark is out of range. Build it with -fsanitize=thread to check the
+// ring for data races as well.
+void BM_EventRingStress(State& state)
+{
+    const size_t capacity = (size_t)state.arg(0);
+    const OverflowPolicy policy = (OverflowPolicy)state.arg(1);
+    SimulatedFleet fleet(200);
+    RingCheckDelegate delegate(fleet.buttons.size(), policy == OverflowPolicy::Block);
+    for (Button* button : fleet.buttons)
+    {
+        button->setDelegate(&delegate);
+    }
+    fleet.manager->enableEventRing(capacity, policy, nullptr);
+    Manager& manager = *fleet.manager;
+
+    std::atomic<bool> done { false };
+    std::thread consumer([&manager, &done]
+    {
+        while (true)
+        {
+            if (manager.deliverEvents() != 0)
+            {
+                continue;
+            }
+            // Everything pushed before done was set is in the ring by now.
+            if (done.load(std::memory_order_acquire))
+            {
+                if (manager.deliverEvents() == 0)
+                {
+                    return;
+                }
+                continue;
+            }
+            std::this_thread::yield();
+        }
+    });
+    while (state.keepRunning())
+    {
+        fleet.clickAll();
+    }
+    done.store(true, std::memory_order_release);
+    consumer.join();
+
+    EventRingCounters counters = manager.eventRingCounters();
+    uint64_t produced = 3 * fleet.buttons.size() * state.iterations();
+    if (delegate.violations != 0)
+    {
+        state.skipWithError("events out of order or garbled");
+        return;
+    }
+    if (delegate.events + counters.dropped != produced || counters.pushed != counters.popped)
+    {
+        state.skipWithError("delivered and dropped events do not add up");
+        return;
+    }
+    if (policy == OverflowPolicy::Block && counters.dropped != 0)
+    {
+        state.skipWithError("Block dropped events");
+        return;
+    }
+    bool overflowed = counters.dropped != 0 || counters.stalls != 0;
+    if (counters.highWatermark > capacity || counters.highWatermark == 0
+        || (overflowed && counters.highWatermark < capacity / 2))
+    {
+        state.skipWithError("high watermark out of range");
+        return;
+    }
+    state.setItemsProcessed(delegate.events);
+    state.setCounter("dropped_ratio", (double)counters.dropped / (double)produced);
+    state.setCounter("stalls", (double)counters.stalls);
+    state.setCounter("high_watermark", (double)counters.highWatermark);
+}
+BENCHMARK(BM_EventRingStress)->args({ 64, 0 })->args({ 64, 1 })->args({ 1024, 0 })->args({ 1024, 1 });
+
+} // namespace bench
+} // namespace scl
@@ -0,0 +1,28 @@
+//
+//  @file EventCallbackC.c
+//  @framework fliclib-core
+//
+//  Copyright (c) 2016-2026 Shortcut Labs. All rights reserved.
+//
+
+// The event callback of BM_EventCallback, written in C against EventCallback.h, so that the header and its layout checks
+// are built by a C compiler and the core calls into C code the way an app would.
+
+#include "EventCallback.h"
+
+void sclBenchCountEvents(void* context, const SCLFlicButtonEventNotification* events, size_t count);
+
+// context is two counters: the events and those of them that are malformed.
+void sclBenchCountEvents(void* context, const SCLFlicButtonEventNotification* events, size_t count)
+{
+    uint64_t* counters = (uint64_t*)context;
+    counters[0] += count;
+    for (size_t i = 0; i < count; i++)
+    {
+        if (events[i].type > SCLFlicButtonEventTypeProvisionalClick || events[i].queued > 1 ||
+            events[i].receivedTime < events[i].eventTime)
+        {
+            counters[1]++;
+        }
+    }
+}
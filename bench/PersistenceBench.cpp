@@ -0,0 +1,253 @@
+//
+//  @file PersistenceBench.cpp
+//  @framework fliclib-core
+//
+//  Copyright (c) 2016-2026 Shortcut Labs. All rights reserved.
+//
+
+#include <unistd.h>
+
+#include "Benchmark.h"
+#include "BenchSupport.h"
+#include "Journal.h"
+
+namespace scl {
+namespace bench {
+
+namespace {
+
+ButtonInfo benchInfo(size_t index)
+{
+    ButtonInfo info;
+    info.identifier = "B" + std::to_string(index);
+    info.publicKey = "K" + std::to_string(index);
+    info.name = "F016H0" + std::to_string(index);
+    info.userAssignedName = "Room " + std::to_string(index % 100);
+    uint64_t seed = index;
+    for (uint8_t& byte : info.longTermKey)
+    {
+        byte = (uint8_t)splitMix64(seed);
+    }
+    return info;
+}
+
+// A journal with the given number of buttons as a long running app leaves it: each button added, its settings changed
+// once and a few dozen rounds of presses flushed, with compaction along the way.
+void writeJournal(const std::string& path, size_t count)
+{
+    unlink(path.c_str());
+    StateJournal journal;
+    journal.open(path);
+    for (size_t i = 0; i < count; i++)
+    {
+        JournalButton button;
+        button.info = benchInfo(i);
+        journal.recordButton(button);
+    }
+    ButtonSettings settings;
+    settings.triggerBehavior = TriggerBehavior::ClickAndDoubleClick;
+    for (size_t i = 0; i < count; i++)
+    {
+        journal.recordSettings(benchInfo(i).identifier, settings);
+    }
+    for (uint32_t press = 1; press <= 40; press++)
+    {
+        for (size_t i = 0; i < count; i++)
+        {
+            journal.recordPressCount("B" + std::to_string(i), press);
+        }
+        journal.flush();
+    }
+}
+
+// Notes the wall clock time of the first event of any button.
+class FirstEventDelegate : public ButtonDelegate
+{
+public:
+    void didReceiveButtonDown(Button&, bool, long) override { note(); }
+    void didReceiveButtonUp(Button&, bool, long) override { note(); }
+    void didReceiveButtonClick(Button&, bool, long) override { note(); }
+    void didReceiveQueuedEvents(Button&, const QueuedEventBatch&) override { note(); }
+
+    void note()
+    {
+        if (!first)
+        {
+            first = monotonicNow();
+        }
+    }
+
+    Timestamp first = 0;
+};
+
+} // namespace
+
+// Cold restoration of a manager with the given number of buttons: mapping and reading the journal and creating every
+// button with its persisted state, up to the point where didRestoreState fires.
+void BM_JournalRestore(State& state)
+{
+    size_t count = (size_t)state.arg();
+    std::string path = temporaryPath("restore.journal");
+    writeJournal(path, count);
+    std::vector<NullTransport> transports(count);
+    size_t next = 0;
+    auto transportForButton = [&](const ButtonInfo&) -> Transport* { return &transports[next++]; };
+    uint64_t fileSize = 0;
+    while (state.keepRunning())
+    {
+        ManualScheduler scheduler;
+        std::unique_ptr<Manager> manager(new Manager(scheduler, nullptr, nullptr));
+        StateJournal journal;
+        JournalState restored;
+        next = 0;
+        if (!journal.open(path, &restored) || manager->restoreState(restored, transportForButton) != count)
+        {
+            state.skipWithError("restore failed");
+            break;
+        }
+        manager->setJournal(&journal);
+        fileSize = journal.fileSize();
+
+        state.pauseTiming();
+        manager.reset();
+        state.resumeTiming();
+    }
+    unlink(path.c_str());
+    state.setItemsProcessed(state.iterations() * count);
+    state.setCounter("file_bytes", (double)fileSize);
+}
+BENCHMARK(BM_JournalRestore)->arg(1)->arg(100)->arg(10000);
+
+// A relaunch in the background for one button among many, eager and lazy: from opening the journal until the queued
+// press of the button that woke the app reaches the delegate. The other buttons get transports that never connect, the
+// waking one a simulated link to a peripheral that holds the press.
+void BM_TimeToFirstEvent(State& state)
+{
+    size_t count = (size_t)state.arg(0);
+    bool lazily = state.arg(1) != 0;
+    std::string path = temporaryPath("wake.journal");
+    writeJournal(path, count);
+    const std::string waking = benchInfo(count / 2).identifier;
+    std::vector<NullTransport> transports(count);
+    uint64_t firstEvent = 0;
+    while (state.keepRunning())
+    {
+        state.pauseTiming();
+        ManualScheduler scheduler;
+        FirstEventDelegate delegate;
+        std::unique_ptr<SimulatedPeripheral> peripheral(new SimulatedPeripheral(scheduler, benchInfo(count / 2).longTermKey));
+        std::unique_ptr<SimulatedLink> link;
+        std::unique_ptr<Manager> manager(new Manager(scheduler, nullptr, &delegate));
+        size_t next = 0;
+        auto transportForButton = [&](const ButtonInfo& info) -> Transport*
+        {
+            if (info.identifier == waking)
+            {
+                link.reset(new SimulatedLink(scheduler, *peripheral));
+                return link.get();
+            }
+            return &transports[next++ % count];
+        };
+        state.resumeTiming();
+
+        Timestamp start = monotonicNow();
+        StateJournal journal;
+        JournalState restored;
+        if (!journal.open(path, &restored) || manager->restoreState(restored, transportForButton, lazily) != count)
+        {
+            state.skipWithError("restore failed");
+            break;
+        }
+        manager->setJournal(&journal);
+        Button* button = manager->buttonWithIdentifier(waking);
+        if (!button)
+        {
+            state.skipWithError("waking button missing");
+            break;
+        }
+        // The flic counts on from the press count the journal holds, which grows with every iteration, earlier
+        // counters would be taken for events sent again. The press waits on the flic until the scheduler runs.
+        peripheral->setPressCounter((uint32_t)button->pressCount());
+        peripheral->press();
+        peripheral->release();
+        scheduler.runUntilIdle();
+        if (!delegate.first)
+        {
+            state.skipWithError("no event delivered");
+            break;
+        }
+        firstEvent += delegate.first - start;
+
+        state.pauseTiming();
+        manager.reset();
+        link.reset();
+        state.resumeTiming();
+    }
+    unlink(path.c_str());
+    state.setItemsProcessed(state.iterations());
+    state.setCounter("first_event_us", state.iterations() ? (double)firstEvent / 1e3 / (double)state.iterations() : 0);
+}
+BENCHMARK(BM_TimeToFirstEvent)->args({ 1, 0 })->args({ 1, 1 })->args({ 100, 0 })->args({ 100, 1 })
+                              ->args({ 10000, 0 })->args({ 10000, 1 });
+
+// One press count update of a button among 100 written through, the write every button event used to cost.
+void BM_JournalAppend(State& state)
+{
+    std::string path = temporaryPath("append.journal");
+    writeJournal(path, 100);
+    StateJournal journal;
+    journal.open(path);
+    uint64_t before = journal.bytesWritten();
+    uint64_t compactions = journal.compactions();
+    uint32_t press = 1000;
+    while (state.keepRunning())
+    {
+        journal.recordPressCount("B" + std::to_string(press % 100), press);
+        journal.flush();
+        press++;
+    }
+    state.setItemsProcessed(state.iterations());
+    state.setCounter("bytes_per_record", (double)(journal.bytesWritten() - before) / (double)state.iterations());
+    state.setCounter("compactions", (double)(journal.compactions() - compactions));
+    journal.close();
+    unlink(path.c_str());
+}
+BENCHMARK(BM_JournalAppend);
+
+// Storage I/O of 20 simulated buttons clicked together over and over, with the given journal flush interval in
+// milliseconds. 0 writes on every button event.
+void BM_JournalClicks(State& state)
+{
+    const size_t count = 20;
+    std::string path = temporaryPath("clicks.journal");
+    unlink(path.c_str());
+    SimulatedFleet fleet(count);
+    StateJournal journal;
+    journal.open(path);
+    fleet.manager->setJournalFlushInterval((Timestamp)state.arg() * kNanosPerMilli);
+    fleet.manager->setJournal(&journal);
+    uint64_t bytes = journal.bytesWritten();
+    uint64_t writes = journal.writes();
+    uint64_t events = fleet.delegate.events;
+    while (state.keepRunning())
+    {
+        fleet.clickAll();
+    }
+    fleet.manager->flushJournal();
+    uint64_t clicks = state.iterations() * count;
+    state.setItemsProcessed(clicks);
+    if (fleet.delegate.events == events)
+    {
+        state.skipWithError("no events delivered");
+    }
+    state.setCounter("bytes_per_click", clicks ? (double)(journal.bytesWritten() - bytes) / (double)clicks : 0);
+    state.setCounter("writes_per_click", clicks ? (double)(journal.writes() - writes) / (double)clicks : 0);
+    state.setCounter("coalesced", (double)journal.coalescedRecords());
+    fleet.manager->setJournal(nullptr);
+    journal.close();
+    unlink(path.c_str());
+}
+BENCHMARK(BM_JournalClicks)->arg(0)->arg(100)->arg(2000);
+
+} // namespace bench
+} // namespace scl
@@ -0,0 +1,205 @@
+//
+//  @file ProximityBench.cpp
+//  @framework fliclib-core
+//
+//  Copyright (c) 2016-2026 Shortcut Labs. All rights reserved.
+//
+
+#include <cmath>
+#include <unordered_map>
+
+#include "Benchmark.h"
+#include "BenchSupport.h"
+
+namespace scl {
+namespace bench {
+
+namespace {
+
+// Keeps the last RSSI the app has heard of for every button, raw or filtered.
+class ProximityDelegate : public ButtonDelegate
+{
+public:
+    explicit ProximityDelegate(const std::vector<Button*>& buttons)
+    {
+        for (size_t i = 0; i < buttons.size(); i++)
+        {
+            indexes[buttons[i]] = i;
+        }
+        known.assign(buttons.size(), 0);
+    }
+
+    void didUpdateRSSI(Button& button, int rssi, Error error) override
+    {
+        callbacks++;
+        if (error == Error::None)
+        {
+            known[indexes[&button]] = rssi;
+        }
+    }
+
+    void didUpdateFilteredRSSI(Button& button, int rssi) override
+    {
+        callbacks++;
+        known[indexes[&button]] = rssi;
+    }
+
+    std::unordered_map<Button*, size_t> indexes;
+    std::vector<int> known;
+    uint64_t callbacks = 0;
+};
+
+// Counts the readings of single readRSSI calls and of Manager::readRSSI requests, and when the last one arrived.
+class SurveyDelegate : public ButtonDelegate, public ManagerDelegate
+{
+public:
+    void didUpdateRSSI(Button& button, int, Error) override
+    {
+        callbacks++;
+        readings++;
+        lastReadingAt = button.scheduler().now();
+    }
+
+    void didReadRSSI(Manager& manager, uint32_t, const RSSIReading*, size_t count) override
+    {
+        callbacks++;
+        readings += count;
+        lastReadingAt = manager.scheduler().now();
+    }
+
+    uint64_t callbacks = 0;
+    uint64_t readings = 0;
+    Timestamp lastReadingAt = 0;
+};
+
+} // namespace
+
+// A site survey: one RSSI reading of every button of a fleet on links that model connection events, a quarter each on
+// the Gaming, Kiosk, Balanced and Battery profiles. The survey calls readRSSI on every button and takes one delegate
+// callback per reading (0), or makes one Manager::readRSSI request without a window (1) or with a window of 16 (2).
+// survey_ms is the simulated time until the last reading is in.
+void BM_RSSISurvey(State& state)
+{
+    LinkParameters parameters;
+    parameters.modelsConnectionEvents = true;
+    SimulatedFleet fleet((size_t)state.arg(0), nullptr, parameters);
+    const int mode = (int)state.arg(1);
+    const ConnectionProfile profiles[] = { ConnectionProfile::Gaming, ConnectionProfile::Kiosk,
+                                           ConnectionProfile::Balanced, ConnectionProfile::Battery };
+    SurveyDelegate delegate;
+    fleet.manager->setDelegate(&delegate);
+    fleet.manager->setRSSIReadWindow(mode == 2 ? 16 : 0);
+    for (size_t i = 0; i < fleet.buttons.size(); i++)
+    {
+        fleet.buttons[i]->setDelegate(&delegate);
+        fleet.buttons[i]->setConnectionProfile(profiles[i % 4]);
+        fleet.peripherals[i]->setRSSI(-40 - (int)(i % 50));
+    }
+    fleet.scheduler.advanceBy(5 * kNanosPerSecond);
+    ButtonView connected = fleet.manager->registry().withConnectionState(ConnectionState::Connected);
+    if (connected.size() != fleet.buttons.size())
+    {
+        state.skipWithError("not all buttons connected");
+        return;
+    }
+
+    Timestamp surveyTime = 0;
+    uint64_t seed = 3;
+    uint64_t callbacks = delegate.callbacks;
+    uint64_t readings = delegate.readings;
+    while (state.keepRunning())
+    {
+        Timestamp start = fleet.scheduler.now();
+        if (mode == 0)
+        {
+            for (Button* button : connected)
+            {
+                button->readRSSI();
+            }
+        }
+        else
+        {
+            fleet.manager->readRSSI(connected);
+        }
+        fleet.scheduler.runUntilIdle();
+        surveyTime += delegate.lastReadingAt - start;
+        // Spreads the surveys over the phases of the connection events.
+        fleet.scheduler.advanceBy(kNanosPerSecond + (Timestamp)(splitMix64(seed) % kNanosPerSecond));
+    }
+    state.setItemsProcessed(delegate.readings - readings);
+    state.setCounter("callbacks", (double)(delegate.callbacks - callbacks) / (double)state.iterations());
+    state.setCounter("survey_ms", (double)surveyTime / (double)state.iterations() / kNanosPerMilli);
+}
+BENCHMARK(BM_RSSISurvey)->args({ 50, 0 })->args({ 50, 1 })->args({ 50, 2 })->args({ 500, 0 })->args({ 500, 1 })
+    ->args({ 500, 2 });
+
+// Proximity tracking of the given number of buttons with readings that scatter 4 dB around their true value. Every 10 s
+// one in ten buttons is moved by up to 12 dB. The app either polls readRSSI on every button once a second and takes
+// each reading as is (0), or subscribes at the same rate with the Kalman (1) or EWMA (2) filter and a 3 dB threshold.
+// Every iteration is a simulated minute. error_db is the mean distance between the value the app last heard of and the
+// true value, sampled every second.
+void BM_RSSIStream(State& state)
+{
+    SimulatedFleet fleet((size_t)state.arg(0));
+    const int mode = (int)state.arg(1);
+    ProximityDelegate delegate(fleet.buttons);
+    std::vector<int> base;
+    for (size_t i = 0; i < fleet.buttons.size(); i++)
+    {
+        base.push_back(-40 - (int)(i % 50));
+        fleet.peripherals[i]->setRSSI(base.back());
+        fleet.peripherals[i]->setRSSINoise(4);
+        fleet.buttons[i]->setDelegate(&delegate);
+        if (mode > 0)
+        {
+            RSSISubscription subscription;
+            subscription.filter = mode == 1 ? RSSIFilterKind::Kalman : RSSIFilterKind::EWMA;
+            fleet.buttons[i]->subscribeRSSI(subscription);
+        }
+    }
+
+    uint64_t seed = 5;
+    uint64_t callbacks = delegate.callbacks;
+    uint64_t allocations = allocationCount();
+    double error = 0;
+    uint64_t samples = 0;
+    while (state.keepRunning())
+    {
+        for (int second = 0; second < 60; second++)
+        {
+            if (second % 10 == 0)
+            {
+                for (size_t i = 0; i < fleet.peripherals.size(); i++)
+                {
+                    uint64_t random = splitMix64(seed);
+                    if (random % 10 == 0)
+                    {
+                        fleet.peripherals[i]->setRSSI(base[i] - 12 + (int)((random >> 8) % 25));
+                    }
+                }
+            }
+            if (mode == 0)
+            {
+                for (Button* button : fleet.buttons)
+                {
+                    button->readRSSI();
+                }
+            }
+            fleet.scheduler.advanceBy(kNanosPerSecond);
+            for (size_t i = 0; i < fleet.peripherals.size(); i++)
+            {
+                error += std::abs(delegate.known[i] - fleet.peripherals[i]->rssi());
+                samples++;
+            }
+        }
+    }
+    double buttonMinutes = (double)fleet.buttons.size() * (double)state.iterations();
+    state.setItemsProcessed(delegate.callbacks - callbacks);
+    state.setCounter("callbacks_per_button_minute", (double)(delegate.callbacks - callbacks) / buttonMinutes);
+    state.setCounter("allocations_per_button_minute", (double)(allocationCount() - allocations) / buttonMinutes);
+    state.setCounter("error_db", error / (double)samples);
+}
+BENCHMARK(BM_RSSIStream)->args({ 100, 0 })->args({ 100, 1 })->args({ 100, 2 });
+
+} // namespace bench
+} // namespace scl
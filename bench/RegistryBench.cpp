@@ -0,0 +1,134 @@
+//
+//  @file RegistryBench.cpp
+//  @framework fliclib-core
+//
+//  Copyright (c) 2016-2026 Shortcut Labs. All rights reserved.
+//
+
+#include "Benchmark.h"
+#include "BenchSupport.h"
+
+namespace scl {
+namespace bench {
+
+namespace {
+
+const size_t kNameCount = 100;
+
+// A manager with the given number of buttons that never connect, every other one with a pending connection and
+// kNameCount distinct user assigned names spread over them.
+class Registered
+{
+public:
+    explicit Registered(size_t count)
+        : transports(count),
+          manager(scheduler, nullptr, nullptr)
+    {
+        manager.disable();
+        for (size_t i = 0; i < count; i++)
+        {
+            ButtonInfo info;
+            info.identifier = "B" + std::to_string(i);
+            info.publicKey = "K" + std::to_string(i);
+            info.userAssignedName = "Room " + std::to_string(i % kNameCount);
+            Button* button = manager.addButton(info, transports[i]);
+            if (i & 1)
+            {
+                button->connect();
+            }
+            identifiers.push_back(info.identifier);
+            publicKeys.push_back(info.publicKey);
+        }
+    }
+
+    ManualScheduler scheduler;
+    std::vector<NullTransport> transports;
+    Manager manager;
+    std::vector<std::string> identifiers;
+    std::vector<std::string> publicKeys;
+};
+
+} // namespace
+
+// Looking up one of the given number of buttons by identifier (0), public key (1) or user assigned name (2), and by
+// identifier in a freshly built knownButtons map (3), which is what finding a button cost before the registry.
+void BM_RegistryLookup(State& state)
+{
+    Registered registered((size_t)state.arg(0));
+    const ButtonRegistry& registry = registered.manager.registry();
+    size_t count = registered.identifiers.size();
+    std::vector<std::string> names;
+    for (size_t i = 0; i < kNameCount; i++)
+    {
+        names.push_back("Room " + std::to_string(i));
+    }
+    uint64_t i = 0;
+    uint64_t found = 0;
+    while (state.keepRunning())
+    {
+        switch (state.arg(1))
+        {
+            case 0:
+                found += registry.withIdentifier(registered.identifiers[i++ % count]) != nullptr;
+                break;
+            case 1:
+                found += registry.withPublicKey(registered.publicKeys[i++ % count]) != nullptr;
+                break;
+            case 2:
+                found += !registry.withUserAssignedName(names[i++ % kNameCount]).empty();
+                break;
+            default:
+                found += registered.manager.knownButtons().count(registered.identifiers[i++ % count]);
+                break;
+        }
+    }
+    if (found != state.iterations())
+    {
+        state.skipWithError("lookup failed");
+    }
+    state.setItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_RegistryLookup)->args({ 10000, 0 })->args({ 10000, 1 })->args({ 10000, 2 })->args({ 10000, 3 });
+
+// Visiting all of the given number of buttons through knownButtons (0) or a registry view (1), and visiting the buttons
+// with a pending connection through a view by state (2).
+void BM_RegistryEnumerate(State& state)
+{
+    Registered registered((size_t)state.arg(0));
+    const ButtonRegistry& registry = registered.manager.registry();
+    uint64_t visited = 0;
+    int pressCount = 0;
+    while (state.keepRunning())
+    {
+        switch (state.arg(1))
+        {
+            case 0:
+                for (auto& entry : registered.manager.knownButtons())
+                {
+                    pressCount += entry.second->pressCount();
+                    visited++;
+                }
+                break;
+            case 1:
+                for (Button* button : registry.all())
+                {
+                    pressCount += button->pressCount();
+                    visited++;
+                }
+                break;
+            default:
+                for (Button* button : registry.withConnectionState(ConnectionState::Connecting))
+                {
+                    pressCount += button->pressCount();
+                    visited++;
+                }
+                break;
+        }
+    }
+    doNotOptimize(pressCount);
+    state.setItemsProcessed(visited);
+}
+BENCHMARK(BM_RegistryEnumerate)->args({ 10000, 0 })->args({ 10000, 1 })->args({ 10000, 2 });
+
+} // namespace bench
+} // namespace scl
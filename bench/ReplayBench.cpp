@@ -0,0 +1,219 @@
+//
+//  @file ReplayBench.cpp
+//  @framework fliclib-core
+//
+//  Copyright (c) 2016-2026 Shortcut Labs. All rights reserved.
+//
+
+#include "Benchmark.h"
+#include "BenchSupport.h"
+#include "Trace.h"
+
+namespace scl {
+namespace bench {
+
+namespace {
+
+// Records a session of the given number of presses, including a spell out of range with a queued backlog.
+std::vector<uint8_t> recordSession(size_t presses, ButtonInfo& info)
+{
+    SimulatedFleet fleet(0);
+    info.identifier = "R0";
+    info.longTermKey[0] = 0x5a;
+    SimulatedPeripheral peripheral(fleet.scheduler, info.longTermKey, 7);
+    std::vector<uint8_t> trace;
+    {
+        SimulatedLink link(fleet.scheduler, peripheral);
+        TraceRecorder recorder;
+        Button* button = fleet.manager->addButton(info, link);
+        button->setTraceRecorder(&recorder);
+        fleet.scheduler.advanceBy(kNanosPerSecond);
+        uint64_t seed = 3;
+        for (size_t i = 0; i < presses; i++)
+        {
+            if (i == presses / 2)
+            {
+                peripheral.setInRange(false);
+            }
+            if (i == presses / 2 + presses / 10)
+            {
+                peripheral.setInRange(true);
+            }
+            peripheral.press();
+            fleet.scheduler.advanceBy((Timestamp)(50 + splitMix64(seed) % 100) * kNanosPerMilli);
+            peripheral.release();
+            fleet.scheduler.advanceBy((Timestamp)(200 + splitMix64(seed) % 1500) * kNanosPerMilli);
+        }
+        fleet.scheduler.runUntilIdle();
+        trace = recorder.data();
+        button->setTraceRecorder(nullptr);
+        fleet.manager->forgetButton(*button);
+    }
+    return trace;
+}
+
+// Logs every button callback with its argument and the time it was made at, to compare a replay with the recording.
+class CallbackLog : public ButtonDelegate
+{
+public:
+    struct Entry
+    {
+        int kind;
+        int value;
+        Timestamp time;
+
+        bool operator==(const Entry& other) const
+        {
+            return kind == other.kind && value == other.value && time == other.time;
+        }
+    };
+
+    void didConnect(Button& button) override { log(button, 0, 0); }
+    void isReady(Button& button) override { log(button, 1, 0); }
+    void didDisconnect(Button& button, Error error) override { log(button, 2, (int)error); }
+    void didReceiveButtonDown(Button& button, bool queued, long) override { log(button, 3, queued); }
+    void didReceiveButtonUp(Button& button, bool queued, long) override { log(button, 4, queued); }
+    void didReceiveButtonClick(Button& button, bool queued, long) override { log(button, 5, queued); }
+    void didReceiveButtonHold(Button& button, bool queued, long) override { log(button, 6, queued); }
+    void didUpdateRSSI(Button& button, int rssi, Error error) override { log(button, 7, rssi); }
+    void didUpdateFilteredRSSI(Button& button, int rssi) override { log(button, 8, rssi); }
+
+    std::vector<Entry> entries;
+
+private:
+    void log(Button& button, int kind, int value) { entries.push_back({ kind, value, button.scheduler().now() }); }
+};
+
+// Records a session of clicks on a button with an RSSI subscription over noisy readings, some readRSSI calls of the app
+// and a spell out of range, and logs the callbacks the app got.
+std::vector<uint8_t> recordRSSISession(ButtonInfo& info, const RSSISubscription& subscription, CallbackLog& log)
+{
+    SimulatedFleet fleet(0);
+    info.identifier = "R1";
+    info.longTermKey[0] = 0x3c;
+    SimulatedPeripheral peripheral(fleet.scheduler, info.longTermKey, 11);
+    peripheral.setRSSI(-60);
+    peripheral.setRSSINoise(4);
+    std::vector<uint8_t> trace;
+    {
+        SimulatedLink link(fleet.scheduler, peripheral);
+        TraceRecorder recorder;
+        Button* button = fleet.manager->addButton(info, link);
+        button->setDelegate(&log);
+        button->subscribeRSSI(subscription);
+        button->setTraceRecorder(&recorder);
+        uint64_t seed = 5;
+        for (int second = 0; second < 120; second++)
+        {
+            if (second == 60)
+            {
+                peripheral.setInRange(false);
+            }
+            if (second == 70)
+            {
+                peripheral.setInRange(true);
+            }
+            if (second % 20 == 10)
+            {
+                peripheral.setRSSI(-50 - (int)(splitMix64(seed) % 30));
+            }
+            // A read while disconnected fails without reaching the transport, so it is not in the trace.
+            if (second % 7 == 3 && button->isReady())
+            {
+                button->readRSSI();
+            }
+            if (second % 5 == 0)
+            {
+                peripheral.press();
+                fleet.scheduler.advanceBy(80 * kNanosPerMilli);
+                peripheral.release();
+                fleet.scheduler.advanceBy(920 * kNanosPerMilli);
+            }
+            else
+            {
+                fleet.scheduler.advanceBy(kNanosPerSecond);
+            }
+        }
+        trace = recorder.data();
+        button->setTraceRecorder(nullptr);
+        button->setDelegate(nullptr);
+        fleet.manager->forgetButton(*button);
+    }
+    return trace;
+}
+
+} // namespace
+
+// Replays a recorded session through a fresh Button per iteration, the unit of a trace based regression run.
+// speedup is the recorded duration over the replay time.
+void BM_TraceReplay(State& state)
+{
+    ButtonInfo info;
+    std::vector<uint8_t> trace = recordSession((size_t)state.arg(), info);
+    CountingDelegate delegate;
+    TraceReplay replay(info);
+    uint64_t records = 0;
+    Timestamp duration = 0;
+    Timestamp start = monotonicNow();
+    while (state.keepRunning())
+    {
+        if (replay.load(trace.data(), trace.size()) != Error::None)
+        {
+            state.skipWithError("invalid trace");
+            break;
+        }
+        replay.button().setDelegate(&delegate);
+        replay.button().setTriggerBehavior(TriggerBehavior::ClickAndDoubleClickAndHold);
+        records += replay.run();
+        duration = replay.duration();
+    }
+    Timestamp elapsed = monotonicNow() - start;
+    state.setItemsProcessed(records);
+    state.setCounter("trace_bytes", (double)trace.size());
+    state.setCounter("events_per_replay", (double)delegate.events / (double)state.iterations());
+    state.setCounter("speedup", (double)duration * (double)state.iterations() / (double)(elapsed ? elapsed : 1));
+}
+BENCHMARK(BM_TraceReplay)->arg(100)->arg(1000);
+
+// Replays a session of a button with an RSSI subscription and checks that the replayed button makes exactly the callbacks
+// the recorded one did, at the same times: requested readings, filtered readings and button events. Fails otherwise.
+void BM_TraceReplayRSSI(State& state)
+{
+    ButtonInfo info;
+    RSSISubscription subscription;
+    subscription.interval = 500 * kNanosPerMilli;
+    CallbackLog recorded;
+    std::vector<uint8_t> trace = recordRSSISession(info, subscription, recorded);
+    TraceReplay replay(info);
+    uint64_t records = 0;
+    while (state.keepRunning())
+    {
+        CallbackLog replayed;
+        if (replay.load(trace.data(), trace.size()) != Error::None)
+        {
+            state.skipWithError("invalid trace");
+            return;
+        }
+        replay.button().setDelegate(&replayed);
+        replay.button().subscribeRSSI(subscription);
+        records += replay.run();
+        // The recording starts at the first connect, so the replay misses nothing.
+        if (!(replayed.entries == recorded.entries))
+        {
+            state.skipWithError("replayed callbacks differ from the recording");
+            return;
+        }
+    }
+    size_t filtered = 0;
+    for (const CallbackLog::Entry& entry : recorded.entries)
+    {
+        filtered += entry.kind == 8;
+    }
+    state.setItemsProcessed(records);
+    state.setCounter("callbacks", (double)recorded.entries.size());
+    state.setCounter("filtered_rssi_callbacks", (double)filtered);
+}
+BENCHMARK(BM_TraceReplayRSSI);
+
+} // namespace bench
+} // namespace scl
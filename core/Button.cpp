@@ -0,0 +1,1057 @@
+//
+//  @file Button.cpp
+//  @framework fliclib-core
+//
+//  Copyright (c) 2016-2026 Shortcut Labs. All rights reserved.
+//
+
+#include "Button.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include "Random.h"
+#include "Trace.h"
+
+namespace scl {
+namespace flic {
+
+const uint8_t Button::kDefaultAckWindow;
+const Timestamp Button::kDefaultAdaptiveIdleTimeout;
+const uint32_t Button::kNoIndex;
+
+Button::Button(const ButtonInfo& info, Transport& transport, Scheduler& scheduler)
+    : _info(info),
+      _transport(transport),
+      _scheduler(scheduler),
+      _longTermKey(info.longTermKey),
+      _signer(true),
+      _classifier(*this),
+      _classifierTimer(*this),
+      _adaptiveLatencyTimer(*this),
+      _rssiSampleTimer(*this),
+      _nonceState(hashString(info.identifier) ^ (uint64_t)scheduler.now())
+{
+    _transport.setListener(this);
+    _transport.setPipelinesSetup(_pipelinedConnect);
+}
+
+Button::~Button()
+{
+    invalidate();
+}
+
+void Button::invalidate()
+{
+    _scheduler.cancel(_classifierTimer);
+    _scheduler.cancel(_adaptiveLatencyTimer);
+    _scheduler.cancel(_rssiSampleTimer);
+    if (_transport.listener() == this)
+    {
+        _transport.setListener(nullptr);
+    }
+    _eventSink = nullptr;
+    _stateObserver = nullptr;
+}
+
+void Button::setTriggerBehavior(TriggerBehavior behavior)
+{
+    _classifier.setBehavior(behavior);
+    _provisionalClickPending = false;
+    armClassifierTimer();
+    settingsDidChange();
+}
+
+void Button::setConnectionProfile(ConnectionProfile profile)
+{
+    if (profile == _connectionProfile)
+    {
+        return;
+    }
+    _connectionProfile = profile;
+    if (_linkUp && !_latencyRaised)
+    {
+        _transport.requestConnectionParameters(connectionParameters(profile));
+    }
+    settingsDidChange();
+}
+
+void Button::setAdaptiveLatency(bool adaptive)
+{
+    if (adaptive == _adaptiveLatency)
+    {
+        return;
+    }
+    _adaptiveLatency = adaptive;
+    if (!adaptive)
+    {
+        lowerLatency();
+    }
+    settingsDidChange();
+}
+
+void Button::setLowLatency(bool lowLatency)
+{
+    setConnectionProfile(lowLatency ? ConnectionProfile::Gaming : ConnectionProfile::Balanced);
+}
+
+void Button::setSpeculativeClicks(bool speculative)
+{
+    _classifier.setSpeculative(speculative);
+    settingsDidChange();
+}
+
+void Button::setAdaptiveTiming(bool adaptive)
+{
+    _classifier.setAdaptive(adaptive);
+    armClassifierTimer();
+    settingsDidChange();
+}
+
+void Button::setEventMask(EventMask mask)
+{
+    _eventMask = mask & kAllEvents;
+    settingsDidChange();
+}
+
+void Button::setBatchesQueuedEvents(bool batches)
+{
+    _batchesQueuedEvents = batches;
+    settingsDidChange();
+}
+
+void Button::setAckWindow(uint8_t window)
+{
+    _ackWindow = std::max<uint8_t>(1, std::min(window, kMaxAckWindow));
+}
+
+void Button::setPipelinedConnect(bool pipelined)
+{
+    _pipelinedConnect = pipelined;
+    _transport.setPipelinesSetup(pipelined);
+    _transport.setCachedAttributeLayout(pipelined ? _verifiedAttributeLayout : 0);
+}
+
+void Button::setVerifiedAttributeLayout(uint64_t layout)
+{
+    _verifiedAttributeLayout = layout;
+    _transport.setCachedAttributeLayout(_pipelinedConnect ? layout : 0);
+}
+
+ButtonSettings Button::settings() const
+{
+    ButtonSettings settings;
+    settings.triggerBehavior = triggerBehavior();
+    settings.connectionProfile = _connectionProfile;
+    settings.adaptiveLatency = _adaptiveLatency;
+    settings.speculativeClicks = speculativeClicks();
+    settings.adaptiveTiming = adaptiveTiming();
+    settings.batchesQueuedEvents = _batchesQueuedEvents;
+    settings.eventMask = _eventMask;
+    return settings;
+}
+
+void Button::setSettings(const ButtonSettings& settings)
+{
+    // Applied without going through the individual setters so that observers hear about it once.
+    if (settings.triggerBehavior != triggerBehavior())
+    {
+        _classifier.setBehavior(settings.triggerBehavior);
+        _provisionalClickPending = false;
+    }
+    bool profileChanged = settings.connectionProfile != _connectionProfile;
+    _connectionProfile = settings.connectionProfile;
+    _adaptiveLatency = settings.adaptiveLatency;
+    if (!_adaptiveLatency && _latencyRaised)
+    {
+        lowerLatency();
+    }
+    else if (profileChanged && _linkUp && !_latencyRaised)
+    {
+        _transport.requestConnectionParameters(connectionParameters(_connectionProfile));
+    }
+    _classifier.setSpeculative(settings.speculativeClicks);
+    _classifier.setAdaptive(settings.adaptiveTiming);
+    _batchesQueuedEvents = settings.batchesQueuedEvents;
+    _eventMask = settings.eventMask & kAllEvents;
+    armClassifierTimer();
+    settingsDidChange();
+}
+
+void Button::restorePressCount(int pressCount)
+{
+    _pressCount = (uint32_t)pressCount;
+    // Events up to the restored count were delivered before, the flic sends them again if their ack never reached it.
+    if (pressCount > 0)
+    {
+        _receivedPressCount = (uint32_t)pressCount & 0xffffff;
+        _hasReceivedEvent = true;
+    }
+}
+
+void Button::settingsDidChange()
+{
+    if (_stateObserver)
+    {
+        _stateObserver->buttonDidChangeSettings(*this);
+    }
+}
+
+void Button::setWantsConnection(bool wantsConnection)
+{
+    if (_wantsConnection == wantsConnection)
+    {
+        return;
+    }
+    _wantsConnection = wantsConnection;
+    if (_stateObserver)
+    {
+        _stateObserver->buttonDidChangeWantsConnection(*this);
+    }
+}
+
+void Button::connect()
+{
+    setWantsConnection(true);
+    if (!_parked && (_state == ConnectionState::Disconnected || _state == ConnectionState::Disconnecting))
+    {
+        setState(ConnectionState::Connecting);
+        _transport.connect();
+    }
+}
+
+void Button::disconnect()
+{
+    setWantsConnection(false);
+    if (_state == ConnectionState::Disconnected || _state == ConnectionState::Disconnecting)
+    {
+        return;
+    }
+    setState(ConnectionState::Disconnecting);
+    _transport.disconnect();
+}
+
+void Button::setParked(bool parked)
+{
+    if (_parked == parked)
+    {
+        return;
+    }
+    _parked = parked;
+    if (parked)
+    {
+        if (_state == ConnectionState::Connecting || _state == ConnectionState::Connected)
+        {
+            setState(ConnectionState::Disconnecting);
+            _transport.disconnect();
+        }
+    }
+    else if (_wantsConnection && _state == ConnectionState::Disconnected)
+    {
+        // While still disconnecting, transportDidDisconnect picks the connection up again.
+        setState(ConnectionState::Connecting);
+        _transport.connect();
+    }
+}
+
+void Button::setState(ConnectionState state)
+{
+    if (_state == state)
+    {
+        return;
+    }
+    ConnectionState previous = _state;
+    _state = state;
+    if (_stateObserver)
+    {
+        _stateObserver->buttonDidChangeConnectionState(*this, previous);
+    }
+}
+
+void Button::indicateLED(LEDIndicateCount count)
+{
+    if (!_ready)
+    {
+        return;
+    }
+    Packet packet;
+    encodeIndicateLED(packet, (uint8_t)count);
+    sendSigned(packet);
+}
+
+void Button::readRSSI()
+{
+    if (!_linkUp)
+    {
+        emitCallback(ButtonEventRecord::Kind::DidUpdateRSSI, Error::CouldNotUpdateRSSI);
+        return;
+    }
+    _requestedRSSIReads++;
+    _rssiReadsInFlight++;
+    _transport.readRSSI();
+}
+
+void Button::readRSSIForObserver()
+{
+    if (!_linkUp)
+    {
+        observeRSSI(0, Error::CouldNotUpdateRSSI);
+        return;
+    }
+    _observerWaitsForRSSI = true;
+    if (_rssiReadsInFlight == 0)
+    {
+        _rssiReadsInFlight++;
+        _transport.readRSSI();
+    }
+}
+
+void Button::observeRSSI(int rssi, Error error)
+{
+    _observerWaitsForRSSI = false;
+    if (_stateObserver)
+    {
+        _stateObserver->buttonDidReadRSSI(*this, rssi, error);
+    }
+}
+
+void Button::subscribeRSSI(const RSSISubscription& subscription)
+{
+    RSSISubscription adjusted = subscription;
+    adjusted.interval = std::max(adjusted.interval, RSSISubscription::kMinInterval);
+    // A Kalman filter without noise divides zero by zero, and a weight outside (0, 1] never settles. The negated
+    // comparisons catch NaN as well.
+    if (!(adjusted.measurementNoise >= RSSISubscription::kMinNoise))
+    {
+        adjusted.measurementNoise = RSSISubscription::kMinNoise;
+    }
+    if (!(adjusted.processNoise >= RSSISubscription::kMinNoise))
+    {
+        adjusted.processNoise = RSSISubscription::kMinNoise;
+    }
+    if (!(adjusted.smoothing >= RSSISubscription::kMinSmoothing))
+    {
+        adjusted.smoothing = RSSISubscription::kMinSmoothing;
+    }
+    adjusted.smoothing = std::min(adjusted.smoothing, 1.0);
+    _rssiFilter = RSSIFilter(adjusted);
+    _subscribedToRSSI = true;
+    if (_ready)
+    {
+        startRSSISampling();
+    }
+}
+
+void Button::unsubscribeRSSI()
+{
+    _subscribedToRSSI = false;
+    _scheduler.cancel(_rssiSampleTimer);
+    _rssiFilter.reset();
+}
+
+void Button::startRSSISampling()
+{
+    _scheduler.schedule(_rssiSampleTimer, _scheduler.now());
+}
+
+void Button::transportDidConnect()
+{
+    if (_traceRecorder)
+    {
+        // The nonce state is captured before this session draws from it, so that a replay repeats the handshake. A replay
+        // starts without a ticket, so the trace has to start with a full verification.
+        if (!_traceRecorder->hasStarted())
+        {
+            _ticket.valid = false;
+        }
+        _traceRecorder->begin(_scheduler.now(), _nonceState);
+        _traceRecorder->recordConnected(_scheduler.now());
+    }
+    _linkUp = true;
+    _ready = false;
+    emitCallback(ButtonEventRecord::Kind::DidConnect);
+    if (_state == ConnectionState::Disconnecting)
+    {
+        return;
+    }
+
+    _transport.requestConnectionParameters(connectionParameters(activeConnectionProfile()));
+    Packet packet;
+    nextNonce(_hostNonce);
+    _resuming = _sessionResumption && _ticket.isValidAt(_scheduler.now());
+    if (_resuming)
+    {
+        encodeResumeRequest(packet, _ticket.id, _hostNonce, _ackWindow);
+    }
+    else
+    {
+        encodeVerifyRequest(packet, _hostNonce, _ackWindow);
+    }
+    _transport.write(packet.bytes, packet.size);
+}
+
+void Button::transportDidFailToConnect(Error error)
+{
+    if (_traceRecorder && _traceRecorder->hasStarted())
+    {
+        _traceRecorder->recordFailedToConnect(_scheduler.now(), error);
+    }
+    setWantsConnection(false);
+    setState(ConnectionState::Disconnected);
+    emitCallback(ButtonEventRecord::Kind::DidFailToConnect, error);
+}
+
+void Button::transportDidDisconnect(Error error)
+{
+    if (_traceRecorder && _traceRecorder->hasStarted())
+    {
+        _traceRecorder->recordDisconnected(_scheduler.now(), error);
+    }
+    Error reported = error;
+    bool failed = false;
+    if (_abortError != Error::None)
+    {
+        reported = _abortError;
+        failed = _abortFailsConnection;
+        _abortError = Error::None;
+        _abortFailsConnection = false;
+    }
+
+    _linkUp = false;
+    _ready = false;
+    _drainingQueue = false;
+    // A new link starts with the parameters of the profile.
+    _latencyRaised = false;
+    _scheduler.cancel(_adaptiveLatencyTimer);
+    // The next link may be somewhere else entirely.
+    _scheduler.cancel(_rssiSampleTimer);
+    _rssiFilter.reset();
+    if (_observerWaitsForRSSI)
+    {
+        observeRSSI(0, Error::CouldNotUpdateRSSI);
+    }
+    // Readings still on their way are lost with the link. Those asked for through readRSSI are reported as failed after
+    // the disconnect, the counts start over for the next link.
+    unsigned lostRSSIReads = _requestedRSSIReads;
+    _requestedRSSIReads = 0;
+    _rssiReadsInFlight = 0;
+    endQueuedBatch();
+    armClassifierTimer();
+
+    if (_wantsConnection && !_parked)
+    {
+        setState(ConnectionState::Connecting);
+        _transport.connect();
+    }
+    else
+    {
+        setState(ConnectionState::Disconnected);
+    }
+
+    emitCallback(ButtonEventRecord::Kind::DidDisconnect, reported);
+    if (failed)
+    {
+        emitCallback(ButtonEventRecord::Kind::DidFailToConnect, reported);
+    }
+    for (unsigned i = 0; i < lostRSSIReads; i++)
+    {
+        receiveRSSI(0, Error::CouldNotUpdateRSSI, true);
+    }
+}
+
+void Button::transportDidReceive(const uint8_t* data, size_t size)
+{
+    receivePacket(data, size, false, 0);
+}
+
+void Button::transportDidReceivePackets(const ReceivedPacket* packets, size_t count)
+{
+    // Runs of events in an established session have their signatures checked together, everything else goes through
+    // receivePacket one by one. Either way the packets are handled in order with the same result, and the rest of the
+    // burst is dropped once the connection is being torn down, as the link would have done between single packets.
+    const size_t lanes = ChaskeyKey::kChaskeyLanes;
+    size_t next = 0;
+    while (next < count)
+    {
+        const uint8_t* data[lanes];
+        size_t sizes[lanes];
+        size_t run = 0;
+        while (_ready && run < lanes && next + run < count && packets[next + run].size > 0 &&
+               ((Opcode)packets[next + run].data[0] == Opcode::ButtonEvent ||
+                (Opcode)packets[next + run].data[0] == Opcode::QueueDrained))
+        {
+            data[run] = packets[next + run].data;
+            sizes[run] = packets[next + run].size;
+            run++;
+        }
+
+        if (run < 2)
+        {
+            receivePacket(packets[next].data, packets[next].size, false, 0);
+            next++;
+        }
+        else
+        {
+            Timestamp verifyStart = monotonicNow();
+            size_t verified = _signer.verifyBatch(data, sizes, run);
+            Timestamp verifyDuration = (monotonicNow() - verifyStart) / (Timestamp)run;
+            for (size_t i = 0; i < verified && _ready; i++)
+            {
+                receivePacket(data[i], sizes[i], true, verifyDuration);
+            }
+            next += verified;
+            if (_ready && verified < run)
+            {
+                // Fails the same check again and aborts the connection.
+                receivePacket(data[verified], sizes[verified], false, 0);
+                next++;
+            }
+        }
+
+        if (_abortError != Error::None || _state == ConnectionState::Disconnecting)
+        {
+            return;
+        }
+    }
+}
+
+void Button::receivePacket(const uint8_t* data, size_t size, bool verified, Timestamp verifyDuration)
+{
+    Timestamp received = _scheduler.now();
+    if (_traceRecorder && _traceRecorder->hasStarted())
+    {
+        _traceRecorder->recordReceived(received, data, size);
+    }
+    Timestamp decodeStart = monotonicNow();
+    DecodedPacket packet;
+    Error error = decodePacket(data, size, packet);
+    if (error != Error::None)
+    {
+        abortConnection(Error::UnknownDataReceived, false);
+        return;
+    }
+
+    if (packet.opcode == Opcode::VerifyResponse)
+    {
+        handleVerifyResponse(packet);
+        return;
+    }
+    if (packet.opcode == Opcode::ResumeResponse || packet.opcode == Opcode::ResumeRejected)
+    {
+        handleResumeResult(packet, data, size);
+        return;
+    }
+    if (!_ready || !isSignedOpcode(packet.opcode))
+    {
+        abortConnection(Error::UnknownDataReceived, false);
+        return;
+    }
+    if (!verified && !_signer.verify(data, size))
+    {
+        abortConnection(Error::InvalidSignature, false);
+        return;
+    }
+
+    switch (packet.opcode)
+    {
+        case Opcode::ButtonEvent:
+            handleButtonEvent(packet, received, monotonicNow() - decodeStart + verifyDuration);
+            break;
+        case Opcode::QueueDrained:
+            handleQueueDrained();
+            break;
+        default:
+            abortConnection(Error::UnknownDataReceived, false);
+            break;
+    }
+}
+
+void Button::transportDidReadRSSI(int rssi, Error error)
+{
+    // The reads of a link that went down have been reported as failed already.
+    if (!_linkUp)
+    {
+        return;
+    }
+    // Readings come back in the order they were asked for, and a sample and a requested reading are worth the same, so
+    // only their number matters. A reading nobody asked for is reported like a requested one.
+    bool requested = _requestedRSSIReads > 0 || _rssiReadsInFlight == 0;
+    if (_requestedRSSIReads > 0)
+    {
+        _requestedRSSIReads--;
+    }
+    if (_rssiReadsInFlight > 0)
+    {
+        _rssiReadsInFlight--;
+    }
+    receiveRSSI(rssi, error, requested);
+}
+
+void Button::receiveRSSI(int rssi, Error error, bool requested)
+{
+    if (_traceRecorder && _traceRecorder->hasStarted())
+    {
+        _traceRecorder->recordRSSI(_scheduler.now(), rssi, error, requested);
+    }
+    if (error == Error::None)
+    {
+        _lastRSSI = rssi;
+        if (_subscribedToRSSI && _linkUp)
+        {
+            _rssiFilter.add(rssi, _scheduler.now());
+            if (_rssiFilter.shouldReport())
+            {
+                emitCallback(ButtonEventRecord::Kind::DidUpdateFilteredRSSI, Error::None,
+                             (int)std::lround(_rssiFilter.estimate()));
+            }
+        }
+    }
+    if (_observerWaitsForRSSI)
+    {
+        observeRSSI(rssi, error);
+    }
+    if (requested)
+    {
+        emitCallback(ButtonEventRecord::Kind::DidUpdateRSSI, error, rssi);
+    }
+}
+
+void Button::handleVerifyResponse(const DecodedPacket& packet)
+{
+    if (!_linkUp || _ready || _resuming)
+    {
+        abortConnection(Error::UnknownDataReceived, false);
+        return;
+    }
+
+    uint8_t expected[kProofSize];
+    computeVerificationProof(_longTermKey, _hostNonce, packet.nonce, expected);
+    if (memcmp(expected, packet.proof, kProofSize) != 0)
+    {
+        setVerifiedAttributeLayout(0);
+        abortConnection(Error::IllegalVerificationResponse, true);
+        return;
+    }
+    setVerifiedAttributeLayout(_transport.attributeLayout());
+
+    uint8_t sessionKey[kSessionKeySize];
+    deriveSessionKey(_longTermKey, _hostNonce, packet.nonce, sessionKey);
+    _signer.reset(sessionKey);
+    deriveResumptionTicket(_longTermKey, _hostNonce, packet.nonce, _scheduler.now(), _ticket);
+    _sessionResumed = false;
+    becomeReady(packet.ackWindow);
+}
+
+void Button::handleResumeResult(const DecodedPacket& packet, const uint8_t* data, size_t size)
+{
+    if (!_linkUp || _ready || !_resuming)
+    {
+        abortConnection(Error::UnknownDataReceived, false);
+        return;
+    }
+    _resuming = false;
+    if (packet.opcode == Opcode::ResumeResponse)
+    {
+        // The ticket is used up whether or not the response checks out, a flic that got the request has moved on.
+        uint8_t sessionKey[kSessionKeySize];
+        deriveResumedSession(_ticket, _hostNonce, packet.nonce, sessionKey);
+        _signer.reset(sessionKey);
+        if (_signer.verify(data, size))
+        {
+            _sessionResumed = true;
+            becomeReady(packet.ackWindow);
+            return;
+        }
+    }
+
+    // The flic no longer holds the ticket, or the response is not signed by whoever holds it. Either way the full
+    // verification decides.
+    _ticket.valid = false;
+    Packet request;
+    nextNonce(_hostNonce);
+    encodeVerifyRequest(request, _hostNonce, _ackWindow);
+    _transport.write(request.bytes, request.size);
+}
+
+void Button::becomeReady(uint8_t grantedAckWindow)
+{
+    _grantedAckWindow = std::min(grantedAckWindow, _ackWindow);
+    _ready = true;
+    _drainingQueue = true;
+    setState(ConnectionState::Connected);
+    armClassifierTimer();
+    if (_subscribedToRSSI)
+    {
+        startRSSISampling();
+    }
+    emitCallback(ButtonEventRecord::Kind::IsReady);
+}
+
+void Button::handleButtonEvent(const DecodedPacket& packet, Timestamp received, Timestamp verifyDuration)
+{
+    const ButtonEventPayload& event = packet.event;
+    // Within a window only the events the flic asks for are acked, the ack covers the ones before. A link lost before
+    // that makes the flic send the unacked events again on the next connection, those are acked but not delivered twice.
+    if (_grantedAckWindow == 1 || event.ackRequested)
+    {
+        Packet ack;
+        encodeEventAck(ack, event.pressCounter);
+        sendSigned(ack);
+    }
+    if (_hasReceivedEvent && ((event.pressCounter - _receivedPressCount - 1) & 0xffffff) >= 0x800000)
+    {
+        return;
+    }
+    _hasReceivedEvent = true;
+    _receivedPressCount = event.pressCounter;
+
+    _pressCount = event.pressCounter;
+    _lastActivity = received;
+    if (_stateObserver)
+    {
+        _stateObserver->buttonDidUpdatePressCount(*this);
+    }
+
+    EventTime time;
+    time.buttonTicks = event.eventTicks;
+    time.eventTime = received - buttonTicksToNanos(event.sentTicks - event.eventTicks);
+    time.receivedTime = received;
+    if (!event.queued)
+    {
+        _latencyStats.record(LatencyStage::Radio, received - time.eventTime);
+        _latencyStats.record(LatencyStage::Verify, verifyDuration);
+    }
+
+    // Resolving the pending window first keeps the delivered events in the order they happened.
+    _classifier.expire(time.eventTime);
+    _classifiedPressCount = event.pressCounter;
+    _anchorTicks = event.eventTicks;
+    _anchorTime = time.eventTime;
+    _anchorReceived = received;
+
+    if (event.down)
+    {
+        noteActivity(time.eventTime);
+        dispatch(EventType::ButtonDown, event.queued, time);
+        _classifier.buttonDown(time.eventTime, event.queued);
+    }
+    else
+    {
+        dispatch(EventType::ButtonUp, event.queued, time);
+        _classifier.buttonUp(time.eventTime, event.queued);
+    }
+    armClassifierTimer();
+}
+
+void Button::handleQueueDrained()
+{
+    _drainingQueue = false;
+    _classifier.expire(_scheduler.now());
+    endQueuedBatch();
+    armClassifierTimer();
+}
+
+void Button::classifierDidEmit(EventType type, Timestamp time, bool queued)
+{
+    // The speculative click state follows what the classifier says, whatever the mask lets through.
+    bool confirmsProvisional = _provisionalClickPending && type == EventType::ButtonClick;
+    _provisionalClickPending = type == EventType::ButtonProvisionalClick;
+    // Windows are measured on the host clock, map the result back onto the flic clock of the last transition.
+    EventTime eventTime;
+    eventTime.buttonTicks = _anchorTicks + nanosToButtonTicks(time - _anchorTime);
+    eventTime.eventTime = time;
+    eventTime.receivedTime = _scheduler.now();
+    if (!dispatch(type, queued, eventTime))
+    {
+        return;
+    }
+    // A click that confirms a provisional one the delegate got was already reported, only the first report counts
+    // towards the latency.
+    if (!queued && !(confirmsProvisional && (_eventMask & eventMaskOf(EventType::ButtonProvisionalClick))))
+    {
+        _latencyStats.record(LatencyStage::Classify, eventTime.receivedTime - _anchorReceived);
+    }
+}
+
+bool Button::dispatch(EventType type, bool queued, const EventTime& time)
+{
+    if (!(_eventMask & eventMaskOf(type)))
+    {
+        return false;
+    }
+    ButtonEventRecord record;
+    record.button = this;
+    record.kind = ButtonEventRecord::Kind::Event;
+    record.type = type;
+    record.queued = queued;
+    record.sequence = _classifiedPressCount;
+    record.time = time;
+    record.producedAt = queued ? 0 : monotonicNow();
+    emit(record);
+    return true;
+}
+
+void Button::endQueuedBatch()
+{
+    ButtonEventRecord record;
+    record.button = this;
+    record.kind = ButtonEventRecord::Kind::EndOfQueue;
+    emit(record);
+}
+
+void Button::emitCallback(ButtonEventRecord::Kind kind, Error error, int rssi)
+{
+    ButtonEventRecord record;
+    record.button = this;
+    record.kind = kind;
+    record.error = error;
+    record.rssi = rssi;
+    emit(record);
+}
+
+void Button::emit(const ButtonEventRecord& record)
+{
+    if (_eventSink)
+    {
+        _eventSink->buttonDidProduceEvent(record);
+    }
+    else
+    {
+        deliver(record);
+    }
+}
+
+void Button::deliver(const ButtonEventRecord& record)
+{
+    if (record.kind == ButtonEventRecord::Kind::EndOfQueue)
+    {
+        deliverQueuedBatch();
+        return;
+    }
+    if (!_delegate)
+    {
+        return;
+    }
+
+    switch (record.kind)
+    {
+        case ButtonEventRecord::Kind::DidConnect:
+            _delegate->didConnect(*this);
+            return;
+        case ButtonEventRecord::Kind::IsReady:
+            _delegate->isReady(*this);
+            return;
+        case ButtonEventRecord::Kind::DidDisconnect:
+            _delegate->didDisconnect(*this, record.error);
+            return;
+        case ButtonEventRecord::Kind::DidFailToConnect:
+            _delegate->didFailToConnect(*this, record.error);
+            return;
+        case ButtonEventRecord::Kind::DidUpdateRSSI:
+            _delegate->didUpdateRSSI(*this, record.rssi, record.error);
+            return;
+        case ButtonEventRecord::Kind::DidUpdateFilteredRSSI:
+            _delegate->didUpdateFilteredRSSI(*this, record.rssi);
+            return;
+        case ButtonEventRecord::Kind::Event:
+            break;
+        default:
+            return;
+    }
+
+    long age = ageInSeconds(record.time);
+    if (record.queued && _batchesQueuedEvents)
+    {
+        _batchTypes.push_back(record.type);
+        _batchAges.push_back(age);
+        _batchSequences.push_back(record.sequence);
+        _batchTimes.push_back(record.time);
+        return;
+    }
+
+    recordDeliveryLatency(record);
+    _currentEventTime = record.time;
+    switch (record.type)
+    {
+        case EventType::ButtonDown:
+            _delegate->didReceiveButtonDown(*this, record.queued, age);
+            break;
+        case EventType::ButtonUp:
+            _delegate->didReceiveButtonUp(*this, record.queued, age);
+            break;
+        case EventType::ButtonClick:
+            _delegate->didReceiveButtonClick(*this, record.queued, age);
+            break;
+        case EventType::ButtonDoubleClick:
+            _delegate->didReceiveButtonDoubleClick(*this, record.queued, age);
+            break;
+        case EventType::ButtonHold:
+            _delegate->didReceiveButtonHold(*this, record.queued, age);
+            break;
+        case EventType::ButtonProvisionalClick:
+            _delegate->didReceiveButtonProvisionalClick(*this, record.queued, age);
+            break;
+    }
+}
+
+void Button::recordDeliveryLatency(const ButtonEventRecord& record)
+{
+    if (record.producedAt)
+    {
+        _latencyStats.record(LatencyStage::Deliver, monotonicNow() - record.producedAt);
+    }
+}
+
+void Button::deliverQueuedBatch()
+{
+    if (_batchTypes.empty())
+    {
+        return;
+    }
+    QueuedEventBatch batch;
+    batch.types = _batchTypes.data();
+    batch.ages = _batchAges.data();
+    batch.sequences = _batchSequences.data();
+    batch.times = _batchTimes.data();
+    batch.count = _batchTypes.size();
+    if (_delegate)
+    {
+        _delegate->didReceiveQueuedEvents(*this, batch);
+    }
+    // clear() keeps the capacity, so a steady stream of reconnects does not allocate.
+    _batchTypes.clear();
+    _batchAges.clear();
+    _batchSequences.clear();
+    _batchTimes.clear();
+}
+
+void Button::ClassifierTimer::fire()
+{
+    _button._classifier.expire(_button._scheduler.now());
+    _button.armClassifierTimer();
+}
+
+void Button::AdaptiveLatencyTimer::fire()
+{
+    Timestamp idleAt = _button._lastPressTime + _button._adaptiveIdleTimeout;
+    if (idleAt > _button._scheduler.now())
+    {
+        _button._scheduler.schedule(*this, idleAt);
+        return;
+    }
+    _button.lowerLatency();
+}
+
+void Button::RSSISampleTimer::fire()
+{
+    if (!_button._ready || !_button._subscribedToRSSI)
+    {
+        return;
+    }
+    // A reading still on its way counts as this sample, so a slow link is not piled up with requests.
+    if (_button._rssiReadsInFlight == 0)
+    {
+        _button._rssiReadsInFlight++;
+        _button._transport.readRSSI();
+    }
+    _button._scheduler.schedule(*this, _button._scheduler.now() + _button._rssiFilter.subscription().interval);
+}
+
+void Button::noteActivity(Timestamp eventTime)
+{
+    if (!_adaptiveLatency || !_linkUp || _scheduler.now() - eventTime >= _adaptiveIdleTimeout)
+    {
+        return;
+    }
+    // The timer is only moved when it fires, not on every press.
+    _lastPressTime = std::max(_lastPressTime, eventTime);
+    if (!_latencyRaised)
+    {
+        _latencyRaised = true;
+        if (_connectionProfile != ConnectionProfile::Gaming)
+        {
+            _transport.requestConnectionParameters(connectionParameters(ConnectionProfile::Gaming));
+        }
+    }
+    if (!_adaptiveLatencyTimer.isScheduled())
+    {
+        _scheduler.schedule(_adaptiveLatencyTimer, _lastPressTime + _adaptiveIdleTimeout);
+    }
+}
+
+void Button::lowerLatency()
+{
+    _scheduler.cancel(_adaptiveLatencyTimer);
+    if (!_latencyRaised)
+    {
+        return;
+    }
+    _latencyRaised = false;
+    if (_linkUp && _connectionProfile != ConnectionProfile::Gaming)
+    {
+        _transport.requestConnectionParameters(connectionParameters(_connectionProfile));
+    }
+}
+
+ConnectionProfile Button::activeConnectionProfile() const
+{
+    return _latencyRaised ? ConnectionProfile::Gaming : _connectionProfile;
+}
+
+void Button::armClassifierTimer()
+{
+    // While the backlog is being received the next queued press may still fall inside the window, so the window is only
+    // resolved by the next event or by the end of the queue.
+    Timestamp deadline = _drainingQueue ? -1 : _classifier.deadline();
+    if (deadline < 0)
+    {
+        _scheduler.cancel(_classifierTimer);
+        return;
+    }
+    Timestamp now = _scheduler.now();
+    _scheduler.schedule(_classifierTimer, deadline > now ? deadline : now);
+}
+
+void Button::abortConnection(Error error, bool failsConnection)
+{
+    if (failsConnection)
+    {
+        setWantsConnection(false);
+    }
+    if (_abortError == Error::None)
+    {
+        _abortError = error;
+        _abortFailsConnection = failsConnection;
+    }
+    _ready = false;
+    _transport.disconnect();
+}
+
+void Button::sendSigned(Packet& packet)
+{
+    _signer.sign(packet);
+    _transport.write(packet.bytes, packet.size);
+}
+
+long Button::ageInSeconds(const EventTime& time) const
+{
+    Timestamp age = time.receivedTime - time.eventTime;
+    if (age <= 0)
+    {
+        return 0;
+    }
+    return (long)((age + kNanosPerSecond / 2) / kNanosPerSecond);
+}
+
+void Button::nextNonce(uint8_t nonce[kNonceSize])
+{
+    uint64_t value = splitMix64(_nonceState);
+    for (size_t i = 0; i < kNonceSize; i++)
+    {
+        nonce[i] = (uint8_t)(value >> (i * 8));
+    }
+}
+
+} // namespace flic
+} // namespace scl
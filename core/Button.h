@@ -0,0 +1,723 @@
+//
+//  @file Button.h
+//  @framework fliclib-core
+//
+//  Copyright (c) 2016-2026 Shortcut Labs. All rights reserved.
+//
+
+#ifndef SCL_FLIC_BUTTON_H
+#define SCL_FLIC_BUTTON_H
+
+#include <string>
+#include <vector>
+
+#include "Classifier.h"
+#include "Latency.h"
+#include "Packet.h"
+#include "RSSIFilter.h"
+#include "Scheduler.h"
+#include "Transport.h"
+
+namespace scl {
+namespace flic {
+
+class Button;
+class TraceRecorder;
+
+/*!
+ *  @struct QueuedEventBatch
+ *
+ *  @discussion A read-only view of the queued backlog of one button, stored as parallel arrays in the order the events
+ *              happened. <code>sequences</code> holds the press counter value of the down/up transition that produced
+ *              each event and <code>times</code> its high resolution timing. The arrays are owned by the Button and are
+ *              only valid for the duration of the callback.
+ *
+ */
+struct QueuedEventBatch
+{
+    const EventType* types = nullptr;
+    const long* ages = nullptr;
+    const uint32_t* sequences = nullptr;
+    const EventTime* times = nullptr;
+    size_t count = 0;
+};
+
+/*!
+ *  @struct ButtonEventRecord
+ *
+ *  @discussion A delegate callback, typically a decoded button event, on its way from the radio side to the delegate.
+ *              Records are plain values so that they can be moved between threads through an EventRing without allocating.
+ *
+ */
+struct ButtonEventRecord
+{
+    enum class Kind : uint8_t
+    {
+        /** A button event. */
+        Event = 0,
+        /** The queued backlog has been received, completes a QueuedEventBatch. */
+        EndOfQueue,
+        /** Used by the Manager to free a forgotten button after its earlier records have been delivered. */
+        Release,
+        /** Connection and RSSI callbacks, <code>error</code> and <code>rssi</code> carry their arguments. */
+        DidConnect,
+        IsReady,
+        DidDisconnect,
+        DidFailToConnect,
+        DidUpdateRSSI,
+        /** A filtered reading of an RSSI subscription, rounded to whole dBm in <code>rssi</code>. */
+        DidUpdateFilteredRSSI,
+    };
+
+    Button* button = nullptr;
+    Kind kind = Kind::Event;
+    EventType type = EventType::ButtonDown;
+    bool queued = false;
+    uint32_t sequence = 0;
+    EventTime time;
+    Error error = Error::None;
+    int rssi = 0;
+    /** Monotonic time at which a real time event was produced, 0 if its delivery is not measured. */
+    Timestamp producedAt = 0;
+};
+
+/*!
+ *  @protocol ButtonEventSink
+ *
+ *  @discussion Takes the decoded events of a Button instead of having them delivered to its delegate right away. The sink
+ *              is responsible for eventually calling Button::deliver with every record, in order.
+ *
+ */
+class ButtonEventSink
+{
+public:
+    virtual ~ButtonEventSink() = default;
+
+    virtual void buttonDidProduceEvent(const ButtonEventRecord& record) = 0;
+};
+
+/*!
+ *  @struct ButtonSettings
+ *
+ *  @discussion The settings of a Button that outlive a session and are worth persisting.
+ *
+ */
+struct ButtonSettings
+{
+    TriggerBehavior triggerBehavior = TriggerBehavior::ClickAndHold;
+    ConnectionProfile connectionProfile = ConnectionProfile::Balanced;
+    bool speculativeClicks = false;
+    bool adaptiveTiming = false;
+    bool batchesQueuedEvents = false;
+    bool adaptiveLatency = false;
+    EventMask eventMask = kAllEvents;
+
+    bool operator==(const ButtonSettings& other) const
+    {
+        return triggerBehavior == other.triggerBehavior && connectionProfile == other.connectionProfile &&
+               speculativeClicks == other.speculativeClicks && adaptiveTiming == other.adaptiveTiming &&
+               batchesQueuedEvents == other.batchesQueuedEvents && adaptiveLatency == other.adaptiveLatency &&
+               eventMask == other.eventMask;
+    }
+    bool operator!=(const ButtonSettings& other) const { return !(*this == other); }
+};
+
+/*!
+ *  @protocol ButtonStateObserver
+ *
+ *  @discussion Told about every change of the connection state and of the persistent state of a Button (its settings,
+ *              press count and whether it wants a connection), right away on the scheduler that drives the button.
+ *              Meant for bookkeeping such as the indexes of a ButtonRegistry or a StateJournal, delegates are told
+ *              through their own callbacks. Also gets the readings asked for with Button::readRSSIForObserver.
+ *
+ */
+class ButtonStateObserver
+{
+public:
+    virtual ~ButtonStateObserver() = default;
+
+    virtual void buttonDidChangeConnectionState(Button& button, ConnectionState previous) = 0;
+    virtual void buttonDidChangeSettings(Button& button) {}
+    virtual void buttonDidUpdatePressCount(Button& button) {}
+    virtual void buttonDidChangeWantsConnection(Button& button) {}
+    virtual void buttonDidReadRSSI(Button& button, int rssi, Error error) {}
+};
+
+/*!
+ *  @protocol ButtonDelegate
+ *
+ *  @discussion The C++ counterpart of SCLFlicButtonDelegate. All methods are optional and have the same meaning as the
+ *              Objective-C callbacks they are named after.
+ *
+ */
+class ButtonDelegate
+{
+public:
+    virtual ~ButtonDelegate() = default;
+
+    virtual void didReceiveButtonDown(Button& button, bool queued, long age) {}
+    virtual void didReceiveButtonUp(Button& button, bool queued, long age) {}
+    virtual void didReceiveButtonClick(Button& button, bool queued, long age) {}
+    virtual void didReceiveButtonDoubleClick(Button& button, bool queued, long age) {}
+    virtual void didReceiveButtonHold(Button& button, bool queued, long age) {}
+
+    /*!
+     *  @method didReceiveButtonProvisionalClick:queued:age:
+     *
+     *  @discussion Only called for buttons that have <code>speculativeClicks</code> enabled. A press that would be reported
+     *              as a click unless it turns into a double click. It is followed by exactly one of
+     *              <code>didReceiveButtonClick</code>, confirming it, or <code>didReceiveButtonDoubleClick</code>,
+     *              superseding it, unless the trigger behavior is changed while the window is open.
+     *
+     */
+    virtual void didReceiveButtonProvisionalClick(Button& button, bool queued, long age) {}
+
+    /*!
+     *  @method didReceiveQueuedEvents:batch:
+     *
+     *  @discussion Only called for buttons that have <code>batchesQueuedEvents</code> enabled. Instead of one callback per
+     *              queued down, up, click, double click and hold event, the whole backlog that was received after a
+     *              reconnect is handed over in a single call once the flic reports that its queue is empty (or the link
+     *              is lost while draining it).
+     *
+     */
+    virtual void didReceiveQueuedEvents(Button& button, const QueuedEventBatch& batch) {}
+
+    virtual void didConnect(Button& button) {}
+    virtual void isReady(Button& button) {}
+    virtual void didDisconnect(Button& button, Error error) {}
+    virtual void didFailToConnect(Button& button, Error error) {}
+    virtual void didUpdateRSSI(Button& button, int rssi, Error error) {}
+
+    /*!
+     *  @method didUpdateFilteredRSSI:rssi:
+     *
+     *  @discussion Only called for buttons with an RSSI subscription, see Button::subscribeRSSI. <code>rssi</code> is the
+     *              filtered value in dBm, and is only reported when it has moved by at least the threshold of the
+     *              subscription.
+     *
+     */
+    virtual void didUpdateFilteredRSSI(Button& button, int rssi) {}
+};
+
+/*!
+ *  @struct ButtonInfo
+ *
+ *  @discussion Everything the Flic app hands over when a button is grabbed.
+ *
+ */
+struct ButtonInfo
+{
+    std::string identifier;
+    std::string publicKey;
+    std::string name;
+    std::string userAssignedName;
+    uint8_t longTermKey[ChaskeyKey::kKeySize] = {};
+};
+
+/*!
+ *  @class Button
+ *
+ *  @discussion The session state machine behind SCLFlicButton. It owns verification, packet signing, event decoding and
+ *              trigger behavior classification for one flic, talks to it through a Transport and reports to a
+ *              ButtonDelegate. A Button is only ever used from the scheduler that drives it, and its transport must outlive
+ *              it.
+ *
+ */
+class Button : private TransportListener, private ClassifierListener
+{
+public:
+    static const uint8_t kDefaultAckWindow = 32;
+    static const Timestamp kDefaultAdaptiveIdleTimeout = 10 * kNanosPerSecond;
+    static const uint32_t kNoIndex = UINT32_MAX;
+
+    Button(const ButtonInfo& info, Transport& transport, Scheduler& scheduler);
+    ~Button() override;
+
+    Button(const Button&) = delete;
+    Button& operator=(const Button&) = delete;
+
+    ButtonDelegate* delegate() const { return _delegate; }
+    void setDelegate(ButtonDelegate* delegate) { _delegate = delegate; }
+
+    const ButtonInfo& info() const { return _info; }
+    const std::string& buttonIdentifier() const { return _info.identifier; }
+    const std::string& buttonPublicKey() const { return _info.publicKey; }
+    const std::string& name() const { return _info.name; }
+    const std::string& userAssignedName() const { return _info.userAssignedName; }
+
+    ConnectionState connectionState() const { return _state; }
+    bool isReady() const { return _ready; }
+    int pressCount() const { return (int)_pressCount; }
+
+    /*!
+     *  @property wantsConnection
+     *
+     *  @discussion True between <code>connect</code> and <code>disconnect</code> (or a failed connection attempt).
+     *
+     */
+    bool wantsConnection() const { return _wantsConnection; }
+
+    /*!
+     *  @property lastActivity
+     *
+     *  @discussion Host time at which the last button event was received, 0 if none has been.
+     *
+     */
+    Timestamp lastActivity() const { return _lastActivity; }
+
+    /*!
+     *  @property lastRSSI
+     *
+     *  @discussion The last successfully read RSSI in dBm, 0 until the first reading.
+     *
+     */
+    int lastRSSI() const { return _lastRSSI; }
+
+    /*!
+     *  @property currentEventTime
+     *
+     *  @discussion The high resolution timing of the event that is being delivered. Only valid from within one of the
+     *              didReceiveButton... callbacks, where it complements the whole second <code>age</code> parameter.
+     *
+     */
+    const EventTime& currentEventTime() const { return _currentEventTime; }
+
+    /*!
+     *  @property connectionProfile
+     *
+     *  @discussion The connection parameters to ask for, requested on every connection and right away when changed while
+     *              connected. Unlike the <code>lowLatency</code> setting of SCLFlicButton the profile is not reset when the
+     *              app leaves the foreground, it stays in effect until it is changed.
+     *
+     */
+    ConnectionProfile connectionProfile() const { return _connectionProfile; }
+    void setConnectionProfile(ConnectionProfile profile);
+
+    /*!
+     *  @property lowLatency
+     *
+     *  @discussion Shorthand for the Gaming profile: setting it selects Gaming or Balanced.
+     *
+     */
+    bool lowLatency() const { return _connectionProfile == ConnectionProfile::Gaming; }
+    void setLowLatency(bool lowLatency);
+
+    /*!
+     *  @property connectionInterval
+     *
+     *  @discussion The connection interval the host granted for the current link, 0 when not connected or not yet known.
+     *              It may differ from what the profile asks for, the host has the last word.
+     *
+     */
+    Timestamp connectionInterval() const { return _transport.connectionInterval(); }
+    uint16_t peripheralLatency() const { return _transport.peripheralLatency(); }
+    Timestamp untilNextConnectionEvent() const { return _transport.untilNextConnectionEvent(); }
+
+    /*!
+     *  @property adaptiveLatency
+     *
+     *  @discussion When enabled a press raises the connection parameters to the Gaming profile, so that the clicks that
+     *              tend to follow it arrive with low latency, and they decay back to <code>connectionProfile</code> once
+     *              the button has been idle for <code>adaptiveIdleTimeout</code>. A press that is received queued raises
+     *              them too if it happened within the timeout, typically the one that made the flic reconnect.
+     *              <code>isLatencyRaised</code> tells whether the parameters are raised right now.
+     *
+     */
+    bool adaptiveLatency() const { return _adaptiveLatency; }
+    void setAdaptiveLatency(bool adaptive);
+    Timestamp adaptiveIdleTimeout() const { return _adaptiveIdleTimeout; }
+    void setAdaptiveIdleTimeout(Timestamp timeout) { _adaptiveIdleTimeout = timeout; }
+    bool isLatencyRaised() const { return _latencyRaised; }
+
+    TriggerBehavior triggerBehavior() const { return _classifier.behavior(); }
+    void setTriggerBehavior(TriggerBehavior behavior);
+
+    /*!
+     *  @property speculativeClicks
+     *
+     *  @discussion With ClickAndDoubleClick and ClickAndDoubleClickAndHold a click is normally reported only once the
+     *              double click window has expired. When enabled, real time clicks are reported right away through
+     *              ButtonDelegate::didReceiveButtonProvisionalClick and later confirmed or upgraded.
+     *
+     */
+    bool speculativeClicks() const { return _classifier.isSpeculative(); }
+    void setSpeculativeClicks(bool speculative);
+
+    /*!
+     *  @property adaptiveTiming
+     *
+     *  @discussion When enabled the double click window and hold threshold follow the timing learned from the down/up
+     *              stream of this button, see Classifier::setAdaptive. The windows in effect are reported by
+     *              <code>doubleClickWindow</code> and <code>holdThreshold</code>.
+     *
+     */
+    bool adaptiveTiming() const { return _classifier.isAdaptive(); }
+    void setAdaptiveTiming(bool adaptive);
+    Timestamp doubleClickWindow() const { return _classifier.doubleClickWindow(); }
+    Timestamp holdThreshold() const { return _classifier.holdThreshold(); }
+
+    /*!
+     *  @property eventMask
+     *
+     *  @discussion The button events the delegate wants, all of them by default. An event outside the mask is dropped as
+     *              it is produced, before a record is made for it, so it never reaches the event sink, the event ring, a
+     *              queued event batch or the delegate. Classification keeps running whatever the mask: a click needs its
+     *              down and up even when only clicks are wanted.
+     *
+     */
+    EventMask eventMask() const { return _eventMask; }
+    void setEventMask(EventMask mask);
+
+    /*!
+     *  @property batchesQueuedEvents
+     *
+     *  @discussion Opt-in for ButtonDelegate::didReceiveQueuedEvents. Real time events are always delivered one by one.
+     *
+     */
+    bool batchesQueuedEvents() const { return _batchesQueuedEvents; }
+    void setBatchesQueuedEvents(bool batches);
+
+    /*!
+     *  @property ackWindow
+     *
+     *  @discussion The number of unacknowledged events the flic is offered to have in flight, taking effect with the next
+     *              connection. With a window the backlog of a reconnecting flic streams in while the host acknowledges
+     *              only the events the flic asks for, each ack covering everything before it. 1 acknowledges every event
+     *              and waits for it, as does firmware that does not grant a window; <code>grantedAckWindow</code> is
+     *              the window of the current connection.
+     *
+     */
+    uint8_t ackWindow() const { return _ackWindow; }
+    void setAckWindow(uint8_t window);
+    uint8_t grantedAckWindow() const { return _grantedAckWindow; }
+
+    /*!
+     *  @property pipelinedConnect
+     *
+     *  @discussion Enabled by default. The verification request is written as soon as the characteristics of the flic are
+     *              known, overlapping the subscription to its notifications, and once a connection has been verified its
+     *              attribute layout is remembered so that the next connection skips service discovery, see
+     *              Transport::setCachedAttributeLayout. A layout is only remembered after the flic has proved that it
+     *              holds the long term key, and forgotten if a verification fails.
+     *
+     */
+    bool pipelinedConnect() const { return _pipelinedConnect; }
+    void setPipelinedConnect(bool pipelined);
+
+    /*!
+     *  @property sessionResumption
+     *
+     *  @discussion Enabled by default. Every full verification issues a ResumptionTicket, and a reconnect within
+     *              <code>kResumptionTicketLifetime</code> resumes the session with it instead of verifying again, which
+     *              spares the flic the work of a full verification. Each resumption uses up its ticket and hands both
+     *              sides the next one, so reconnects keep resuming until the lifetime of the verification has passed.
+     *              If the flic rejects the ticket or its response does not check out, the button falls back to the full
+     *              verification on the same connection.
+     *              <code>isSessionResumed</code> tells how the current session was established.
+     *
+     */
+    bool sessionResumption() const { return _sessionResumption; }
+    void setSessionResumption(bool resumption) { _sessionResumption = resumption; }
+    bool isSessionResumed() const { return _sessionResumed; }
+
+    /*!
+     *  @property settings
+     *
+     *  @discussion All of the above in one value, for persisting and restoring them.
+     *
+     */
+    ButtonSettings settings() const;
+    void setSettings(const ButtonSettings& settings);
+
+    /*!
+     *  @method restorePressCount:
+     *
+ *  @discussion Sets the press count reported until the next button event, when restoring persisted state. Events
+     *              the flic sends again up to that count are acked but not delivered a second time.
+     *
+     */
+    void restorePressCount(int pressCount);
+
+    /*!
+     *  @property eventSink
+     *
+     *  @discussion When set, decoded events and all other delegate callbacks are handed to the sink on the radio side and
+     *              only reach the delegate once the sink calls <code>deliver:</code>, which may happen on another thread.
+     *
+     */
+    ButtonEventSink* eventSink() const { return _eventSink; }
+    void setEventSink(ButtonEventSink* sink) { _eventSink = sink; }
+
+    ButtonStateObserver* stateObserver() const { return _stateObserver; }
+    void setStateObserver(ButtonStateObserver* observer) { _stateObserver = observer; }
+
+    /*!
+     *  @method deliver:
+     *
+     *  @discussion Delivery side of the event sink. Makes the delegate callback for one record, or collects it into the
+     *              queued event batch. Must be called for the records of one button in the order they were produced.
+     *
+     */
+    void deliver(const ButtonEventRecord& record);
+
+    /*!
+     *  @method recordDeliveryLatency:
+     *
+     *  @discussion For a sink that hands button events to the app without <code>deliver:</code>, records the Deliver
+     *              stage of a real time event.
+     *
+     */
+    void recordDeliveryLatency(const ButtonEventRecord& record);
+
+    /*!
+     *  @property index
+     *
+     *  @discussion A small number assigned by the Manager that identifies the button among all buttons the manager has
+     *              known, for tables indexed by button. <code>kNoIndex</code> for a button without a manager.
+     *
+     */
+    uint32_t index() const { return _index; }
+    void setIndex(uint32_t index) { _index = index; }
+
+    /*!
+     *  @method invalidate
+     *
+     *  @discussion Cancels the timers of the button and detaches it from its transport, event sink and state observer. Used
+     *              when a button is forgotten but its memory has to outlive records that are still on their way to the
+     *              delegate.
+     *
+     */
+    void invalidate();
+
+    /*!
+     *  @method connect
+     *
+     *  @discussion Starts a pending connection that is kept until <code>disconnect</code> is called. Lost links are
+     *              reconnected automatically.
+     *
+     */
+    void connect();
+    void disconnect();
+
+    /*!
+     *  @property parked
+     *
+     *  @discussion A parked button keeps wanting a connection but gives up its link or pending connection until it is
+     *              unparked, at which point it connects again if it still wants to. Used by the ConnectionScheduler to
+     *              share connection slots, a parked button reports didDisconnect like any other.
+     *
+     */
+    bool isParked() const { return _parked; }
+    void setParked(bool parked);
+    void indicateLED(LEDIndicateCount count);
+
+    /*!
+     *  @method readRSSI
+     *
+     *  @discussion Reads the RSSI of the link and reports it through ButtonDelegate::didUpdateRSSI. Without a link, or if
+     *              the link is lost before the reading arrives, the delegate gets <code>Error::CouldNotUpdateRSSI</code>
+     *              instead, in the latter case after didDisconnect.
+     *
+     */
+    void readRSSI();
+
+    /*!
+     *  @method readRSSIForObserver
+     *
+     *  @discussion Like <code>readRSSI</code>, but the reading goes to ButtonStateObserver::buttonDidReadRSSI instead of
+     *              the delegate, and a reading that is already on its way is shared rather than asked for again. Without a
+     *              link, or if the link is lost before the reading arrives, the observer gets
+     *              <code>Error::CouldNotUpdateRSSI</code> right away. Used by Manager::readRSSI.
+     *
+     */
+    void readRSSIForObserver();
+    bool isReadingRSSIForObserver() const { return _observerWaitsForRSSI; }
+
+    /*!
+     *  @method subscribeRSSI:
+     *
+     *  @discussion Samples the RSSI of the link at the rate of the subscription for as long as the button is connected,
+     *              and reports filtered changes through ButtonDelegate::didUpdateFilteredRSSI instead of one
+     *              <code>didUpdateRSSI</code> per reading. A new subscription replaces the previous one. The filter starts
+     *              over with every connection, and <code>readRSSI</code> keeps working alongside, its readings are fed to
+     *              the filter as well. Noise variances and <code>smoothing</code> are kept above 0, and
+     *              <code>smoothing</code> at most 1, so that the filter stays finite. The sampling timer stays armed while connected, so a ManualScheduler driving a
+     *              subscribed button is never idle.
+     *
+     */
+    void subscribeRSSI(const RSSISubscription& subscription = RSSISubscription());
+    void unsubscribeRSSI();
+    bool isSubscribedToRSSI() const { return _subscribedToRSSI; }
+    const RSSISubscription& rssiSubscription() const { return _rssiFilter.subscription(); }
+
+    /*!
+     *  @property filteredRSSI
+     *
+     *  @discussion The current estimate of the RSSI subscription in dBm, 0 until the first reading of the connection.
+     *
+     */
+    double filteredRSSI() const { return _rssiFilter.estimate(); }
+
+    /*!
+     *  @property latencyStats
+     *
+     *  @discussion Per stage latency histograms of the real time events of this button. Always recorded, and safe to read
+     *              from any thread.
+     *
+     */
+    const LatencyStats& latencyStats() const { return _latencyStats; }
+
+    /*!
+     *  @property traceRecorder
+     *
+     *  @discussion When set, everything the button receives from its transport from the next connect on is appended to
+     *              the recorder. See TraceRecorder and TraceReplay.
+     *
+     */
+    TraceRecorder* traceRecorder() const { return _traceRecorder; }
+    void setTraceRecorder(TraceRecorder* recorder) { _traceRecorder = recorder; }
+
+    Transport& transport() const { return _transport; }
+    Scheduler& scheduler() const { return _scheduler; }
+
+private:
+    friend class TraceReplay;
+
+    class ClassifierTimer : public Timer
+    {
+    public:
+        explicit ClassifierTimer(Button& button) : _button(button) {}
+        void fire() override;
+
+    private:
+        Button& _button;
+    };
+
+    class AdaptiveLatencyTimer : public Timer
+    {
+    public:
+        explicit AdaptiveLatencyTimer(Button& button) : _button(button) {}
+        void fire() override;
+
+    private:
+        Button& _button;
+    };
+
+    class RSSISampleTimer : public Timer
+    {
+    public:
+        explicit RSSISampleTimer(Button& button) : _button(button) {}
+        void fire() override;
+
+    private:
+        Button& _button;
+    };
+
+    // TransportListener
+    void transportDidConnect() override;
+    void transportDidFailToConnect(Error error) override;
+    void transportDidDisconnect(Error error) override;
+    void transportDidReceive(const uint8_t* data, size_t size) override;
+    void transportDidReceivePackets(const ReceivedPacket* packets, size_t count) override;
+    void transportDidReadRSSI(int rssi, Error error) override;
+
+    // ClassifierListener
+    void classifierDidEmit(EventType type, Timestamp time, bool queued) override;
+
+    void setState(ConnectionState state);
+    void setWantsConnection(bool wantsConnection);
+    void settingsDidChange();
+    void receivePacket(const uint8_t* data, size_t size, bool verified, Timestamp verifyDuration);
+    void handleVerifyResponse(const DecodedPacket& packet);
+    void handleResumeResult(const DecodedPacket& packet, const uint8_t* data, size_t size);
+    void becomeReady(uint8_t grantedAckWindow);
+    void handleButtonEvent(const DecodedPacket& packet, Timestamp received, Timestamp verifyDuration);
+    void handleQueueDrained();
+    bool dispatch(EventType type, bool queued, const EventTime& time);
+    void endQueuedBatch();
+    void emitCallback(ButtonEventRecord::Kind kind, Error error = Error::None, int rssi = 0);
+    void emit(const ButtonEventRecord& record);
+    void deliverQueuedBatch();
+    void abortConnection(Error error, bool failsConnection);
+    void sendSigned(Packet& packet);
+    void armClassifierTimer();
+    void noteActivity(Timestamp eventTime);
+    void lowerLatency();
+    ConnectionProfile activeConnectionProfile() const;
+    void startRSSISampling();
+    void receiveRSSI(int rssi, Error error, bool requested);
+    void observeRSSI(int rssi, Error error);
+    long ageInSeconds(const EventTime& time) const;
+    void nextNonce(uint8_t nonce[kNonceSize]);
+    void setVerifiedAttributeLayout(uint64_t layout);
+
+    ButtonInfo _info;
+    Transport& _transport;
+    Scheduler& _scheduler;
+    ButtonDelegate* _delegate = nullptr;
+    ButtonEventSink* _eventSink = nullptr;
+    ButtonStateObserver* _stateObserver = nullptr;
+    TraceRecorder* _traceRecorder = nullptr;
+    uint32_t _index = kNoIndex;
+
+    ChaskeyKey _longTermKey;
+    PacketSigner _signer;
+    Classifier _classifier;
+    ClassifierTimer _classifierTimer;
+    AdaptiveLatencyTimer _adaptiveLatencyTimer;
+    RSSISampleTimer _rssiSampleTimer;
+
+    ConnectionState _state = ConnectionState::Disconnected;
+    bool _wantsConnection = false;
+    bool _parked = false;
+    bool _linkUp = false;
+    bool _ready = false;
+    bool _drainingQueue = false;
+    ConnectionProfile _connectionProfile = ConnectionProfile::Balanced;
+    bool _batchesQueuedEvents = false;
+    EventMask _eventMask = kAllEvents;
+    bool _adaptiveLatency = false;
+    bool _latencyRaised = false;
+    Timestamp _adaptiveIdleTimeout = kDefaultAdaptiveIdleTimeout;
+    Timestamp _lastPressTime = 0;
+    uint8_t _ackWindow = kDefaultAckWindow;
+    uint8_t _grantedAckWindow = 1;
+    bool _pipelinedConnect = true;
+    bool _sessionResumption = true;
+    bool _resuming = false;
+    bool _sessionResumed = false;
+    ResumptionTicket _ticket;
+    uint64_t _verifiedAttributeLayout = 0;
+    Error _abortError = Error::None;
+    bool _abortFailsConnection = false;
+    uint32_t _pressCount = 0;
+    Timestamp _lastActivity = 0;
+    int _lastRSSI = 0;
+    bool _subscribedToRSSI = false;
+    RSSIFilter _rssiFilter;
+    unsigned _rssiReadsInFlight = 0;
+    unsigned _requestedRSSIReads = 0;
+    bool _observerWaitsForRSSI = false;
+    uint32_t _classifiedPressCount = 0;
+    uint32_t _receivedPressCount = 0;
+    bool _hasReceivedEvent = false;
+    uint32_t _anchorTicks = 0;
+    Timestamp _anchorTime = 0;
+    Timestamp _anchorReceived = 0;
+    bool _provisionalClickPending = false;
+    EventTime _currentEventTime;
+    LatencyStats _latencyStats;
+
+    std::vector<EventType> _batchTypes;
+    std::vector<long> _batchAges;
+    std::vector<uint32_t> _batchSequences;
+    std::vector<EventTime> _batchTimes;
+    uint8_t _hostNonce[kNonceSize] = {};
+    uint64_t _nonceState;
+};
+
+} // namespace flic
+} // namespace scl
+
+#endif // SCL_FLIC_BUTTON_H
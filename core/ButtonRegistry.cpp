@@ -0,0 +1,177 @@
+//
+//  @file ButtonRegistry.cpp
+//  @framework fliclib-core
+//
+//  Copyright (c) 2016-2026 Shortcut Labs. All rights reserved.
+//
+
+#include "ButtonRegistry.h"
+
+#include <algorithm>
+
+namespace scl {
+namespace flic {
+
+const size_t ButtonRegistry::kStateCount;
+
+ButtonRegistry::~ButtonRegistry()
+{
+    for (Button* button : _all)
+    {
+        button->setStateObserver(nullptr);
+    }
+}
+
+Button* ButtonRegistry::add(std::unique_ptr<Button> button)
+{
+    const std::string& identifier = button->buttonIdentifier();
+    if (_entries.count(identifier))
+    {
+        return nullptr;
+    }
+    Entry& entry = _entries[identifier];
+    entry.button = std::move(button);
+    Button* added = entry.button.get();
+
+    entry.position = _all.size();
+    _all.push_back(added);
+    insertState(entry, added->connectionState());
+    // Empty keys and names are left out, they would only collect every button that has none.
+    if (!added->buttonPublicKey().empty())
+    {
+        _byPublicKey.emplace(added->buttonPublicKey(), added);
+    }
+    if (!added->userAssignedName().empty())
+    {
+        _byUserAssignedName[added->userAssignedName()].push_back(added);
+    }
+    added->setStateObserver(this);
+    _version++;
+    return added;
+}
+
+std::unique_ptr<Button> ButtonRegistry::remove(const Button& button)
+{
+    auto it = _entries.find(button.buttonIdentifier());
+    if (it == _entries.end() || it->second.button.get() != &button)
+    {
+        return nullptr;
+    }
+    Entry& entry = it->second;
+    Button* removed = entry.button.get();
+    removed->setStateObserver(nullptr);
+
+    Button* last = _all.back();
+    _all[entry.position] = last;
+    _entries[last->buttonIdentifier()].position = entry.position;
+    _all.pop_back();
+    eraseState(entry, removed->connectionState());
+
+    auto key = _byPublicKey.find(removed->buttonPublicKey());
+    if (key != _byPublicKey.end() && key->second == removed)
+    {
+        _byPublicKey.erase(key);
+    }
+    auto name = _byUserAssignedName.find(removed->userAssignedName());
+    if (name != _byUserAssignedName.end())
+    {
+        std::vector<Button*>& named = name->second;
+        named.erase(std::find(named.begin(), named.end(), removed));
+        if (named.empty())
+        {
+            _byUserAssignedName.erase(name);
+        }
+    }
+
+    std::unique_ptr<Button> owned = std::move(entry.button);
+    _entries.erase(it);
+    _version++;
+    return owned;
+}
+
+ButtonView ButtonRegistry::withConnectionState(ConnectionState state) const
+{
+    const std::vector<Button*>& buttons = _byState[(size_t)state];
+    return ButtonView(buttons.data(), buttons.size());
+}
+
+ButtonView ButtonRegistry::withUserAssignedName(const std::string& name) const
+{
+    auto it = _byUserAssignedName.find(name);
+    return it == _byUserAssignedName.end() ? ButtonView() : ButtonView(it->second.data(), it->second.size());
+}
+
+Button* ButtonRegistry::withIdentifier(const std::string& identifier) const
+{
+    auto it = _entries.find(identifier);
+    return it == _entries.end() ? nullptr : it->second.button.get();
+}
+
+Button* ButtonRegistry::withPublicKey(const std::string& publicKey) const
+{
+    auto it = _byPublicKey.find(publicKey);
+    return it == _byPublicKey.end() ? nullptr : it->second;
+}
+
+void ButtonRegistry::buttonDidChangeConnectionState(Button& button, ConnectionState previous)
+{
+    Entry& entry = _entries[button.buttonIdentifier()];
+    eraseState(entry, previous);
+    insertState(entry, button.connectionState());
+    _version++;
+    if (_observer)
+    {
+        _observer->buttonDidChangeConnectionState(button, previous);
+    }
+}
+
+void ButtonRegistry::buttonDidChangeSettings(Button& button)
+{
+    if (_observer)
+    {
+        _observer->buttonDidChangeSettings(button);
+    }
+}
+
+void ButtonRegistry::buttonDidUpdatePressCount(Button& button)
+{
+    if (_observer)
+    {
+        _observer->buttonDidUpdatePressCount(button);
+    }
+}
+
+void ButtonRegistry::buttonDidChangeWantsConnection(Button& button)
+{
+    if (_observer)
+    {
+        _observer->buttonDidChangeWantsConnection(button);
+    }
+}
+
+void ButtonRegistry::buttonDidReadRSSI(Button& button, int rssi, Error error)
+{
+    if (_observer)
+    {
+        _observer->buttonDidReadRSSI(button, rssi, error);
+    }
+}
+
+void ButtonRegistry::insertState(Entry& entry, ConnectionState state)
+{
+    std::vector<Button*>& buttons = _byState[(size_t)state];
+    entry.statePosition = buttons.size();
+    buttons.push_back(entry.button.get());
+}
+
+void ButtonRegistry::eraseState(Entry& entry, ConnectionState state)
+{
+    std::vector<Button*>& buttons = _byState[(size_t)state];
+    Button* last = buttons.back();
+    buttons[entry.statePosition] = last;
+    _entries[last->buttonIdentifier()].statePosition = entry.statePosition;
+    buttons.pop_back();
+}
+
+} // namespace flic
+} // namespace scl
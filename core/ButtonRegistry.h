@@ -0,0 +1,142 @@
+//
+//  @file ButtonRegistry.h
+//  @framework fliclib-core
+//
+//  Copyright (c) 2016-2026 Shortcut Labs. All rights reserved.
+//
+
+#ifndef SCL_FLIC_BUTTON_REGISTRY_H
+#define SCL_FLIC_BUTTON_REGISTRY_H
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "Button.h"
+
+namespace scl {
+namespace flic {
+
+/*!
+ *  @class ButtonView
+ *
+ *  @discussion A read-only range of buttons handed out by a ButtonRegistry. It points straight into the storage of the
+ *              registry, so taking one never copies, and it stays valid until the next change of the registry: adding
+ *              or removing a button for every view, and a change of connection state for the views by state. Compare
+ *              ButtonRegistry::version to tell whether a view kept across calls is still current.
+ *
+ */
+class ButtonView
+{
+public:
+    ButtonView() = default;
+    ButtonView(Button* const* buttons, size_t size) : _buttons(buttons), _size(size) {}
+
+    Button* const* begin() const { return _buttons; }
+    Button* const* end() const { return _buttons + _size; }
+    size_t size() const { return _size; }
+    bool empty() const { return _size == 0; }
+    Button* operator[](size_t index) const { return _buttons[index]; }
+
+private:
+    Button* const* _buttons = nullptr;
+    size_t _size = 0;
+};
+
+/*!
+ *  @class ButtonRegistry
+ *
+ *  @discussion Owns the buttons of a Manager and keeps them indexed by identifier, public key, user assigned name and
+ *              connection state. Every lookup is a single hash probe, and enumerating all buttons or the buttons in one
+ *              state walks a dense array without building a container. The connection state index follows the buttons
+ *              through ButtonStateObserver, so a registered button must not be given another state observer, use
+ *              <code>setObserver</code> on the registry instead.
+ *              <br/><br/>
+ *              Only used from the scheduler that drives the buttons.
+ *
+ */
+class ButtonRegistry : private ButtonStateObserver
+{
+public:
+    ButtonRegistry() = default;
+    ~ButtonRegistry() override;
+
+    ButtonRegistry(const ButtonRegistry&) = delete;
+    ButtonRegistry& operator=(const ButtonRegistry&) = delete;
+
+    /*!
+     *  @method add:
+     *
+     *  @return The button, or nullptr if a button with the same identifier is already registered, in which case the
+     *          given button is destroyed.
+     *
+     */
+    Button* add(std::unique_ptr<Button> button);
+
+    /*!
+     *  @method remove:
+     *
+     *  @return The removed button with ownership handed back to the caller, or nullptr if it is not registered.
+     *
+     */
+    std::unique_ptr<Button> remove(const Button& button);
+
+    size_t size() const { return _all.size(); }
+    bool empty() const { return _all.empty(); }
+
+    /*!
+     *  @property version
+     *
+     *  @discussion Changes whenever a view handed out earlier may have become invalid.
+     *
+     */
+    uint64_t version() const { return _version; }
+
+    ButtonView all() const { return ButtonView(_all.data(), _all.size()); }
+    ButtonView withConnectionState(ConnectionState state) const;
+    ButtonView withUserAssignedName(const std::string& name) const;
+
+    Button* withIdentifier(const std::string& identifier) const;
+    Button* withPublicKey(const std::string& publicKey) const;
+
+    /*!
+     *  @property observer
+     *
+     *  @discussion Gets every ButtonStateObserver callback of the registered buttons, after the indexes are up to date.
+     *
+     */
+    ButtonStateObserver* observer() const { return _observer; }
+    void setObserver(ButtonStateObserver* observer) { _observer = observer; }
+
+private:
+    static const size_t kStateCount = 4;
+
+    struct Entry
+    {
+        std::unique_ptr<Button> button;
+        size_t position = 0;
+        size_t statePosition = 0;
+    };
+
+    void buttonDidChangeConnectionState(Button& button, ConnectionState previous) override;
+    void buttonDidChangeSettings(Button& button) override;
+    void buttonDidUpdatePressCount(Button& button) override;
+    void buttonDidChangeWantsConnection(Button& button) override;
+    void buttonDidReadRSSI(Button& button, int rssi, Error error) override;
+    void insertState(Entry& entry, ConnectionState state);
+    void eraseState(Entry& entry, ConnectionState state);
+
+    std::unordered_map<std::string, Entry> _entries;
+    std::unordered_map<std::string, Button*> _byPublicKey;
+    std::unordered_map<std::string, std::vector<Button*>> _byUserAssignedName;
+    std::vector<Button*> _all;
+    std::vector<Button*> _byState[kStateCount];
+    ButtonStateObserver* _observer = nullptr;
+    uint64_t _version = 0;
+};
+
+} // namespace flic
+} // namespace scl
+
+#endif // SCL_FLIC_BUTTON_REGISTRY_H
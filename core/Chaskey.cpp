@@ -0,0 +1,277 @@
+//
+//  @file Chaskey.cpp
+//  @framework fliclib-core
+//
+//  Copyright (c) 2016-2026 Shortcut Labs. All rights reserved.
+//
+
+#include "Chaskey.h"
+
+#include <cstring>
+
+namespace scl {
+namespace flic {
+
+namespace {
+
+inline uint32_t rotl(uint32_t x, int b)
+{
+    return (x << b) | (x >> (32 - b));
+}
+
+// One 32 bit word of the state for every lane of a batch.
+typedef uint32_t Lanes __attribute__((vector_size(ChaskeyKey::kChaskeyLanes * sizeof(uint32_t))));
+
+// Takes the vector by reference, passing it by value would depend on whether AVX is enabled.
+inline void rotl(Lanes& x, int b)
+{
+    x = (x << b) | (x >> (32 - b));
+}
+
+inline uint32_t load32(const uint8_t* p)
+{
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+// Loads a 16 byte block as its four words, in one copy where the byte order allows it.
+inline void loadBlock(uint32_t words[4], const uint8_t* p)
+{
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    memcpy(words, p, 16);
+#else
+    for (int i = 0; i < 4; i++)
+    {
+        words[i] = load32(p + i * 4);
+    }
+#endif
+}
+
+// Copies the fewer than 16 bytes of a last block without a call to memcpy of a variable size.
+inline void copyTail(uint8_t* out, const uint8_t* in, size_t size)
+{
+    size_t offset = 0;
+    if (size & 8)
+    {
+        memcpy(out, in, 8);
+        offset = 8;
+    }
+    if (size & 4)
+    {
+        memcpy(out + offset, in + offset, 4);
+        offset += 4;
+    }
+    if (size & 2)
+    {
+        memcpy(out + offset, in + offset, 2);
+        offset += 2;
+    }
+    if (size & 1)
+    {
+        out[offset] = in[offset];
+    }
+}
+
+void timesTwo(uint32_t out[4], const uint32_t in[4])
+{
+    static const uint32_t C[2] = { 0x00, 0x87 };
+    out[0] = (in[0] << 1) ^ C[in[3] >> 31];
+    out[1] = (in[1] << 1) | (in[0] >> 31);
+    out[2] = (in[2] << 1) | (in[1] >> 31);
+    out[3] = (in[3] << 1) | (in[2] >> 31);
+}
+
+// Works on copies, through the array the state would go back to memory after every step.
+void permuteLanes(Lanes v[4])
+{
+    Lanes v0 = v[0], v1 = v[1], v2 = v[2], v3 = v[3];
+    for (int round = 0; round < 16; round++)
+    {
+        v0 += v1; rotl(v1, 5); v1 ^= v0; rotl(v0, 16);
+        v2 += v3; rotl(v3, 8); v3 ^= v2;
+        v0 += v3; rotl(v3, 13); v3 ^= v0;
+        v2 += v1; rotl(v1, 7); v1 ^= v2; rotl(v2, 16);
+    }
+    v[0] = v0; v[1] = v1; v[2] = v2; v[3] = v3;
+}
+
+// Turns the blocks of eight lanes, one row of four words each, into the four vectors of one word for every lane.
+void transposeBlocks(Lanes out[4], const uint32_t rows[ChaskeyKey::kChaskeyLanes][4])
+{
+    static_assert(ChaskeyKey::kChaskeyLanes == 8, "the shuffles below are written for eight lanes");
+    Lanes r[4];
+    memcpy(r, rows, sizeof(r));
+    // Words 0 and 1, and 2 and 3, of rows 0 to 3 and of rows 4 to 7.
+    Lanes low = __builtin_shufflevector(r[0], r[1], 0, 4, 8, 12, 1, 5, 9, 13);
+    Lanes high = __builtin_shufflevector(r[0], r[1], 2, 6, 10, 14, 3, 7, 11, 15);
+    Lanes nextLow = __builtin_shufflevector(r[2], r[3], 0, 4, 8, 12, 1, 5, 9, 13);
+    Lanes nextHigh = __builtin_shufflevector(r[2], r[3], 2, 6, 10, 14, 3, 7, 11, 15);
+    out[0] = __builtin_shufflevector(low, nextLow, 0, 1, 2, 3, 8, 9, 10, 11);
+    out[1] = __builtin_shufflevector(low, nextLow, 4, 5, 6, 7, 12, 13, 14, 15);
+    out[2] = __builtin_shufflevector(high, nextHigh, 0, 1, 2, 3, 8, 9, 10, 11);
+    out[3] = __builtin_shufflevector(high, nextHigh, 4, 5, 6, 7, 12, 13, 14, 15);
+}
+
+} // namespace
+
+void chaskeyPermute(uint32_t v[4])
+{
+    for (int round = 0; round < 16; round++)
+    {
+        v[0] += v[1]; v[1] = rotl(v[1], 5); v[1] ^= v[0]; v[0] = rotl(v[0], 16);
+        v[2] += v[3]; v[3] = rotl(v[3], 8); v[3] ^= v[2];
+        v[0] += v[3]; v[3] = rotl(v[3], 13); v[3] ^= v[0];
+        v[2] += v[1]; v[1] = rotl(v[1], 7); v[1] ^= v[2]; v[2] = rotl(v[2], 16);
+    }
+}
+
+void ChaskeyKey::setKey(const uint8_t key[kKeySize])
+{
+    for (int i = 0; i < 4; i++)
+    {
+        _k[i] = load32(key + i * 4);
+    }
+    timesTwo(_k1, _k);
+    timesTwo(_k2, _k1);
+}
+
+void ChaskeyKey::mac(const uint8_t* message, size_t size, uint8_t* tag, size_t tagSize) const
+{
+    uint32_t v[4] = { _k[0], _k[1], _k[2], _k[3] };
+
+    while (size > 16)
+    {
+        for (int i = 0; i < 4; i++)
+        {
+            v[i] ^= load32(message + i * 4);
+        }
+        chaskeyPermute(v);
+        message += 16;
+        size -= 16;
+    }
+
+    uint8_t last[16] = {};
+    const uint32_t* finalKey = _k1;
+    memcpy(last, message, size);
+    if (size < 16)
+    {
+        last[size] = 0x01;
+        finalKey = _k2;
+    }
+    for (int i = 0; i < 4; i++)
+    {
+        v[i] ^= load32(last + i * 4) ^ finalKey[i];
+    }
+    chaskeyPermute(v);
+
+    uint8_t out[16];
+    for (int i = 0; i < 4; i++)
+    {
+        v[i] ^= finalKey[i];
+        out[i * 4 + 0] = (uint8_t)v[i];
+        out[i * 4 + 1] = (uint8_t)(v[i] >> 8);
+        out[i * 4 + 2] = (uint8_t)(v[i] >> 16);
+        out[i * 4 + 3] = (uint8_t)(v[i] >> 24);
+    }
+    memcpy(tag, out, tagSize < 16 ? tagSize : 16);
+}
+
+const size_t ChaskeyKey::kChaskeyLanes;
+
+void ChaskeyKey::macBatch(const uint8_t* const* messages, const size_t* sizes, size_t count, uint8_t* tags,
+                          size_t tagSize) const
+{
+    const size_t lanes = kChaskeyLanes;
+    for (size_t first = 0; first < count; first += lanes)
+    {
+        size_t used = count - first < lanes ? count - first : lanes;
+        // Every message is absorbed as its full blocks followed by a padded last block, a lane whose message has fewer
+        // blocks than the longest one of the batch keeps its state through the extra rounds. Each lane copies its block
+        // into a row as it lies in memory, the rows are transposed into the vectors with shuffles, and the key of the
+        // last block is picked and applied with lane masks rather than lane by lane.
+        size_t blocks[lanes] = {};
+        uint32_t partial[lanes] = {};
+        size_t mostBlocks = 1;
+        for (size_t lane = 0; lane < used; lane++)
+        {
+            size_t size = sizes[first + lane];
+            blocks[lane] = size == 0 ? 1 : (size + 15) / 16;
+            partial[lane] = size % 16 != 0 || size == 0 ? ~0u : 0;
+            mostBlocks = blocks[lane] > mostBlocks ? blocks[lane] : mostBlocks;
+        }
+
+        Lanes partialMask;
+        memcpy(&partialMask, partial, sizeof(partialMask));
+        Lanes v[4];
+        Lanes finalKey[4];
+        for (int i = 0; i < 4; i++)
+        {
+            v[i] = Lanes{} + _k[i];
+            finalKey[i] = ((Lanes{} + _k2[i]) & partialMask) | ((Lanes{} + _k1[i]) & ~partialMask);
+        }
+        uint32_t rows[lanes][4] = {};
+        for (size_t block = 0; block < mostBlocks; block++)
+        {
+            uint32_t active[lanes] = {};
+            uint32_t last[lanes] = {};
+            for (size_t lane = 0; lane < used; lane++)
+            {
+                if (block >= blocks[lane])
+                {
+                    continue;
+                }
+                active[lane] = ~0u;
+                last[lane] = block + 1 == blocks[lane] ? ~0u : 0;
+                const uint8_t* message = messages[first + lane] + block * 16;
+                size_t remaining = sizes[first + lane] - block * 16;
+                if (remaining >= 16)
+                {
+                    loadBlock(rows[lane], message);
+                    continue;
+                }
+                uint8_t padded[16] = {};
+                copyTail(padded, message, remaining);
+                padded[remaining] = 0x01;
+                loadBlock(rows[lane], padded);
+            }
+
+            Lanes mask;
+            Lanes lastMask;
+            memcpy(&mask, active, sizeof(mask));
+            memcpy(&lastMask, last, sizeof(lastMask));
+            Lanes next[4];
+            transposeBlocks(next, rows);
+            for (int i = 0; i < 4; i++)
+            {
+                next[i] ^= v[i] ^ (finalKey[i] & lastMask);
+            }
+            permuteLanes(next);
+            for (int i = 0; i < 4; i++)
+            {
+                v[i] = (next[i] & mask) | (v[i] & ~mask);
+            }
+        }
+
+        uint32_t state[4][lanes];
+        for (int i = 0; i < 4; i++)
+        {
+            v[i] ^= finalKey[i];
+        }
+        memcpy(state, v, sizeof(state));
+        for (size_t lane = 0; lane < used; lane++)
+        {
+            uint8_t out[16];
+            for (int i = 0; i < 4; i++)
+            {
+                uint32_t word = state[i][lane];
+                out[i * 4 + 0] = (uint8_t)word;
+                out[i * 4 + 1] = (uint8_t)(word >> 8);
+                out[i * 4 + 2] = (uint8_t)(word >> 16);
+                out[i * 4 + 3] = (uint8_t)(word >> 24);
+            }
+            memcpy(tags + (first + lane) * tagSize, out, tagSize < 16 ? tagSize : 16);
+        }
+    }
+}
+
+} // namespace flic
+} // namespace scl
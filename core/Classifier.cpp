@@ -0,0 +1,289 @@
+//
+//  @file Classifier.cpp
+//  @framework fliclib-core
+//
+//  Copyright (c) 2016-2026 Shortcut Labs. All rights reserved.
+//
+
+#include "Classifier.h"
+
+namespace scl {
+namespace flic {
+
+const Timestamp Classifier::kDoubleClickWindow;
+const Timestamp Classifier::kHoldThreshold;
+const Timestamp Classifier::kMinDoubleClickWindow;
+const Timestamp Classifier::kMinHoldThreshold;
+const Timestamp Classifier::kAdaptiveMargin;
+const size_t TimingEstimator::kMinSamples;
+
+void TimingEstimator::add(Timestamp sample)
+{
+    if (_samples++ == 0)
+    {
+        _mean = sample;
+        _deviation = sample / 4;
+        return;
+    }
+    Timestamp error = sample - _mean;
+    _mean += error / 8;
+    _deviation += ((error < 0 ? -error : error) - _deviation) / 8;
+}
+
+Timestamp TimingEstimator::bound(Timestamp fallback, Timestamp floor, Timestamp margin) const
+{
+    if (_samples < kMinSamples)
+    {
+        return fallback;
+    }
+    Timestamp bound = _mean + 4 * _deviation + margin;
+    return bound < floor ? floor : bound > fallback ? fallback : bound;
+}
+
+void Classifier::setBehavior(TriggerBehavior behavior)
+{
+    _behavior = behavior;
+    reset();
+}
+
+void Classifier::reset()
+{
+    _state = State::Idle;
+    _queued = false;
+    _lastSequenceWasClick = false;
+}
+
+bool Classifier::detectsHold() const
+{
+    return _behavior == TriggerBehavior::ClickAndHold || _behavior == TriggerBehavior::ClickAndDoubleClickAndHold;
+}
+
+bool Classifier::detectsDoubleClick() const
+{
+    return _behavior == TriggerBehavior::ClickAndDoubleClick || _behavior == TriggerBehavior::ClickAndDoubleClickAndHold;
+}
+
+void Classifier::emit(EventType type, Timestamp time)
+{
+    _listener.classifierDidEmit(type, time, _queued);
+}
+
+Timestamp Classifier::doubleClickWindow() const
+{
+    return _adaptive ? _doubleClickGaps.bound(kDoubleClickWindow, kMinDoubleClickWindow, kAdaptiveMargin)
+                     : kDoubleClickWindow;
+}
+
+Timestamp Classifier::holdThreshold() const
+{
+    return _adaptive ? _clickDurations.bound(kHoldThreshold, kMinHoldThreshold, kAdaptiveMargin) : kHoldThreshold;
+}
+
+Timestamp Classifier::deadline() const
+{
+    switch (_state)
+    {
+        case State::Pressed:
+            return detectsHold() ? _firstDown + holdThreshold() : -1;
+        case State::Released:
+            return _firstDown + doubleClickWindow();
+        default:
+            return -1;
+    }
+}
+
+void Classifier::expire(Timestamp time)
+{
+    Timestamp pending = deadline();
+    if (pending < 0 || pending > time)
+    {
+        return;
+    }
+    if (_state == State::Pressed)
+    {
+        _state = State::Held;
+        emit(EventType::ButtonHold, pending);
+    }
+    else
+    {
+        _state = State::Idle;
+        _lastSequenceWasClick = true;
+        emit(EventType::ButtonClick, pending);
+    }
+}
+
+void Classifier::buttonDown(Timestamp time, bool queued)
+{
+    expire(time);
+    _pressDown = time;
+
+    switch (_state)
+    {
+        case State::Idle:
+            if (_lastSequenceWasClick && time - _firstDown < kDoubleClickWindow)
+            {
+                // A second press that came too late for the window in effect, the user may have meant a double click.
+                _doubleClickGaps.add(time - _firstDown);
+            }
+            _lastSequenceWasClick = false;
+            _firstDown = time;
+            _queued = queued;
+            if (_behavior == TriggerBehavior::Click)
+            {
+                emit(EventType::ButtonClick, time);
+            }
+            _state = State::Pressed;
+            break;
+        case State::Released:
+            _doubleClickGaps.add(time - _firstDown);
+            _state = State::PressedAgain;
+            break;
+        default:
+            // A down without the matching up was lost on the way, start over from this press.
+            _state = State::Idle;
+            buttonDown(time, queued);
+            break;
+    }
+}
+
+void Classifier::buttonUp(Timestamp time, bool queued)
+{
+    (void)queued;
+    expire(time);
+    if (_state != State::Idle && time - _pressDown < kHoldThreshold)
+    {
+        _clickDurations.add(time - _pressDown);
+    }
+
+    switch (_state)
+    {
+        case State::Pressed:
+            if (_behavior == TriggerBehavior::Click)
+            {
+                _state = State::Idle;
+            }
+            else if (!detectsDoubleClick() || time - _firstDown > doubleClickWindow())
+            {
+                _state = State::Idle;
+                _lastSequenceWasClick = true;
+                emit(EventType::ButtonClick, time);
+            }
+            else
+            {
+                _state = State::Released;
+                if (_speculative && !_queued)
+                {
+                    emit(EventType::ButtonProvisionalClick, time);
+                }
+            }
+            break;
+        case State::PressedAgain:
+            _state = State::Idle;
+            emit(EventType::ButtonDoubleClick, time);
+            break;
+        case State::Held:
+            _state = State::Idle;
+            break;
+        default:
+            break;
+    }
+}
+
+namespace {
+
+class TraceListener : public ClassifierListener
+{
+public:
+    TraceListener(std::vector<ClassifiedSequence>* sequences) : sequences(sequences) {}
+
+    void classifierDidEmit(EventType type, Timestamp time, bool queued) override
+    {
+        (void)queued;
+        Timestamp delay = time - lastTransition;
+        stats.counts[(int)type]++;
+        stats.totalDelay[(int)type] += delay;
+        if (delay > stats.maxDelay[(int)type])
+        {
+            stats.maxDelay[(int)type] = delay;
+        }
+
+        if (!sequences || type == EventType::ButtonProvisionalClick)
+        {
+            return;
+        }
+        ClassifiedSequence sequence;
+        sequence.start = classifier->sequenceStart();
+        sequence.type = type;
+        if (!sequences->empty() && sequences->back().start == sequence.start)
+        {
+            sequences->back() = sequence;
+        }
+        else
+        {
+            sequences->push_back(sequence);
+        }
+    }
+
+    ClassifierTraceStats stats;
+    Timestamp lastTransition = 0;
+    const Classifier* classifier = nullptr;
+    std::vector<ClassifiedSequence>* sequences;
+};
+
+} // namespace
+
+ClassifierTraceStats runClassifierTrace(const ClassifierTraceOptions& options, const PressTransition* transitions,
+                                        size_t count, std::vector<ClassifiedSequence>* sequences)
+{
+    TraceListener listener(sequences);
+    Classifier classifier(listener);
+    listener.classifier = &classifier;
+    classifier.setBehavior(options.behavior);
+    classifier.setSpeculative(options.speculative);
+    classifier.setAdaptive(options.adaptive);
+    for (size_t i = 0; i < count; i++)
+    {
+        classifier.expire(transitions[i].time);
+        listener.lastTransition = transitions[i].time;
+        if (transitions[i].down)
+        {
+            classifier.buttonDown(transitions[i].time, false);
+        }
+        else
+        {
+            classifier.buttonUp(transitions[i].time, false);
+        }
+    }
+    Timestamp pending = classifier.deadline();
+    if (pending >= 0)
+    {
+        classifier.expire(pending);
+    }
+    return listener.stats;
+}
+
+double misclassificationRate(const std::vector<ClassifiedSequence>& reference,
+                             const std::vector<ClassifiedSequence>& candidate)
+{
+    if (reference.empty())
+    {
+        return 0;
+    }
+    size_t mismatches = 0;
+    size_t j = 0;
+    for (const ClassifiedSequence& sequence : reference)
+    {
+        while (j < candidate.size() && candidate[j].start < sequence.start)
+        {
+            j++;
+        }
+        if (j == candidate.size() || candidate[j].start != sequence.start || candidate[j].type != sequence.type)
+        {
+            mismatches++;
+        }
+    }
+    return (double)mismatches / (double)reference.size();
+}
+
+} // namespace flic
+} // namespace scl
@@ -0,0 +1,279 @@
+//
+//  @file Classifier.h
+//  @framework fliclib-core
+//
+//  Copyright (c) 2016-2026 Shortcut Labs. All rights reserved.
+//
+
+#ifndef SCL_FLIC_CLASSIFIER_H
+#define SCL_FLIC_CLASSIFIER_H
+
+#include <vector>
+
+#include "Types.h"
+
+namespace scl {
+namespace flic {
+
+/*!
+ *  @protocol ClassifierListener
+ *
+ *  @discussion Receives the click, double click and hold events produced by a Classifier.
+ *
+ */
+class ClassifierListener
+{
+public:
+    virtual ~ClassifierListener() = default;
+
+    /*!
+     *  @discussion <code>time</code> is the host time at which the event logically happened, i.e. the release for a
+     *              double click or the expiry of the hold/double click window. <code>queued</code> is taken from the press
+     *              that started the sequence.
+     *
+     */
+    virtual void classifierDidEmit(EventType type, Timestamp time, bool queued) = 0;
+};
+
+/*!
+ *  @class TimingEstimator
+ *
+ *  @discussion Running estimate of one timing of a user, an exponentially weighted mean and mean absolute deviation with
+ *              a weight of 1/8 for each new sample. Fixed size and integer only.
+ *
+ */
+class TimingEstimator
+{
+public:
+    static const size_t kMinSamples = 8;
+
+    void add(Timestamp sample);
+    void reset() { *this = TimingEstimator(); }
+    size_t samples() const { return _samples; }
+    Timestamp mean() const { return _mean; }
+    Timestamp deviation() const { return _deviation; }
+
+    /*!
+     *  @method bound:floor:margin:
+     *
+     *  @return <code>fallback</code> until kMinSamples samples have been seen, then the mean plus four deviations plus
+     *          <code>margin</code>, clamped to [<code>floor</code>, <code>fallback</code>].
+     *
+     */
+    Timestamp bound(Timestamp fallback, Timestamp floor, Timestamp margin) const;
+
+private:
+    size_t _samples = 0;
+    Timestamp _mean = 0;
+    Timestamp _deviation = 0;
+};
+
+/*!
+ *  @class Classifier
+ *
+ *  @discussion The trigger behavior state machine. It turns the raw down/up stream of one button into click, double click
+ *              and hold events following the rules documented on SCLFlicButtonTriggerBehavior.
+ *              <br/><br/>
+ *              The classifier never reads a clock. Every input carries its own time and pending windows are only resolved
+ *              when a later input arrives or when <code>expire:</code> is called, which is what lets a queued backlog be
+ *              classified correctly no matter how long after the fact it is received.
+ *
+ */
+class Classifier
+{
+public:
+    static const Timestamp kDoubleClickWindow = 500 * kNanosPerMilli;
+    static const Timestamp kHoldThreshold = 1000 * kNanosPerMilli;
+    static const Timestamp kMinDoubleClickWindow = 200 * kNanosPerMilli;
+    static const Timestamp kMinHoldThreshold = 400 * kNanosPerMilli;
+    static const Timestamp kAdaptiveMargin = 50 * kNanosPerMilli;
+
+    explicit Classifier(ClassifierListener& listener) : _listener(listener) {}
+
+    /*!
+     *  @method setBehavior:
+     *
+     *  @discussion Changing the behavior drops any press sequence that is in progress.
+     *
+     */
+    void setBehavior(TriggerBehavior behavior);
+    TriggerBehavior behavior() const { return _behavior; }
+
+    /*!
+     *  @method setSpeculative:
+     *
+     *  @discussion In speculative mode a real time press that may still become a double click is reported as
+     *              <code>ButtonProvisionalClick</code> as soon as it is released. The sequence then ends with either
+     *              <code>ButtonClick</code>, confirming it once the double click window has passed, or
+     *              <code>ButtonDoubleClick</code>, which replaces it. Every other event is unaffected, as are queued
+     *              presses and behaviors that do not detect double clicks.
+     *
+     */
+    void setSpeculative(bool speculative) { _speculative = speculative; }
+    bool isSpeculative() const { return _speculative; }
+
+    /*!
+     *  @method setAdaptive:
+     *
+     *  @discussion Adaptive mode shrinks the double click window and the hold threshold to what this user actually needs.
+     *              The classifier always learns from its input: the time from the first down of a sequence to the next
+     *              down whenever that is within <code>kDoubleClickWindow</code>, and the length of every press shorter
+     *              than <code>kHoldThreshold</code>. Near misses count too, a slow double click that was split into two
+     *              clicks widens the window again. Adaptive windows never exceed the fixed ones and never drop below
+     *              <code>kMinDoubleClickWindow</code> and <code>kMinHoldThreshold</code>. Learning survives
+     *              <code>reset</code> and behavior changes.
+     *
+     */
+    void setAdaptive(bool adaptive) { _adaptive = adaptive; }
+    bool isAdaptive() const { return _adaptive; }
+
+    /*!
+     *  @method doubleClickWindow
+     *
+     *  @return The window currently in effect, measured from the first down of a sequence.
+     *
+     */
+    Timestamp doubleClickWindow() const;
+    Timestamp holdThreshold() const;
+
+    const TimingEstimator& doubleClickGaps() const { return _doubleClickGaps; }
+    const TimingEstimator& clickDurations() const { return _clickDurations; }
+
+    /*!
+     *  @method sequenceStart
+     *
+     *  @return The first down of the sequence that is in progress or was last completed.
+     *
+     */
+    Timestamp sequenceStart() const { return _firstDown; }
+
+    void buttonDown(Timestamp time, bool queued);
+    void buttonUp(Timestamp time, bool queued);
+
+    /*!
+     *  @method expire:
+     *
+     *  @discussion Resolves the pending window if its deadline is at or before <code>time</code>.
+     *
+     */
+    void expire(Timestamp time);
+
+    /*!
+     *  @method deadline
+     *
+     *  @return The time at which the pending window resolves, or -1 if nothing is pending.
+     *
+     */
+    Timestamp deadline() const;
+
+    void reset();
+
+private:
+    enum class State
+    {
+        Idle,
+        Pressed,
+        Released,
+        PressedAgain,
+        Held,
+    };
+
+    bool detectsHold() const;
+    bool detectsDoubleClick() const;
+    void emit(EventType type, Timestamp time);
+
+    ClassifierListener& _listener;
+    TriggerBehavior _behavior = TriggerBehavior::ClickAndHold;
+    bool _speculative = false;
+    bool _adaptive = false;
+    State _state = State::Idle;
+    Timestamp _firstDown = 0;
+    Timestamp _pressDown = 0;
+    bool _queued = false;
+    bool _lastSequenceWasClick = false;
+    TimingEstimator _doubleClickGaps;
+    TimingEstimator _clickDurations;
+};
+
+/*!
+ *  @struct PressTransition
+ *
+ *  @discussion One raw down or up transition of a recorded press trace, in host time.
+ *
+ */
+struct PressTransition
+{
+    Timestamp time = 0;
+    bool down = false;
+};
+
+/*!
+ *  @struct ClassifierTraceStats
+ *
+ *  @discussion Per EventType, how many events a trace produced and how long after the transition that completed them they
+ *              were decided. For a click that is the wait for the double click window, for a provisional click nothing.
+ *
+ */
+struct ClassifierTraceStats
+{
+    uint64_t counts[kEventTypeCount] = {};
+    Timestamp totalDelay[kEventTypeCount] = {};
+    Timestamp maxDelay[kEventTypeCount] = {};
+
+    Timestamp meanDelay(EventType type) const
+    {
+        return counts[(int)type] ? totalDelay[(int)type] / (Timestamp)counts[(int)type] : 0;
+    }
+};
+
+/*!
+ *  @struct ClassifierTraceOptions
+ *
+ *  @discussion How the classifier of runClassifierTrace is configured, see the Classifier setters of the same names.
+ *
+ */
+struct ClassifierTraceOptions
+{
+    TriggerBehavior behavior = TriggerBehavior::ClickAndHold;
+    bool speculative = false;
+    bool adaptive = false;
+};
+
+/*!
+ *  @struct ClassifiedSequence
+ *
+ *  @discussion The final event of one press sequence, identified by the time of its first down.
+ *
+ */
+struct ClassifiedSequence
+{
+    Timestamp start = 0;
+    EventType type = EventType::ButtonClick;
+};
+
+/*!
+ *  @method runClassifierTrace:transitions:count:sequences:
+ *
+ *  @discussion Runs a fresh classifier over a recorded press trace as a real time stream, resolving windows exactly when
+ *              they expire, and reports the decision delay of every event. No scheduler is involved, so a trace of any
+ *              length runs in a fraction of its duration. If <code>sequences</code> is given it receives the final
+ *              classification of every press sequence, in order.
+ *
+ */
+ClassifierTraceStats runClassifierTrace(const ClassifierTraceOptions& options, const PressTransition* transitions,
+                                        size_t count, std::vector<ClassifiedSequence>* sequences = nullptr);
+
+/*!
+ *  @method misclassificationRate:candidate:
+ *
+ *  @return The fraction of the <code>reference</code> sequences that <code>candidate</code> did not classify the same
+ *          way, e.g. a double click that an adaptive window split into two clicks.
+ *
+ */
+double misclassificationRate(const std::vector<ClassifiedSequence>& reference,
+                             const std::vector<ClassifiedSequence>& candidate);
+
+} // namespace flic
+} // namespace scl
+
+#endif // SCL_FLIC_CLASSIFIER_H
@@ -0,0 +1,247 @@
+//
+//  @file ConnectionScheduler.cpp
+//  @framework fliclib-core
+//
+//  Copyright (c) 2016-2026 Shortcut Labs. All rights reserved.
+//
+
+#include "ConnectionScheduler.h"
+
+#include <algorithm>
+#include <limits>
+
+#include "Button.h"
+
+namespace scl {
+namespace flic {
+
+ConnectionScheduler::ConnectionScheduler(Scheduler& scheduler)
+    : _scheduler(scheduler)
+{
+}
+
+ConnectionScheduler::~ConnectionScheduler()
+{
+    _scheduler.cancel(*this);
+}
+
+void ConnectionScheduler::setSlots(size_t slots)
+{
+    _slots = slots;
+    if (_slots == 0)
+    {
+        _scheduler.cancel(*this);
+        for (Entry& entry : _entries)
+        {
+            entry.since = _scheduler.now();
+            entry.button->setParked(false);
+        }
+        return;
+    }
+    tick();
+    arm();
+}
+
+void ConnectionScheduler::addButton(Button& button)
+{
+    _entries.push_back(Entry { &button, _scheduler.now() });
+    if (_slots != 0)
+    {
+        // Parked before its first connect, the next tick decides whether it gets a slot.
+        button.setParked(true);
+        arm();
+    }
+}
+
+void ConnectionScheduler::removeButton(Button& button)
+{
+    auto it = std::find_if(_entries.begin(), _entries.end(), [&button](const Entry& entry)
+    {
+        return entry.button == &button;
+    });
+    if (it == _entries.end())
+    {
+        return;
+    }
+    *it = _entries.back();
+    _entries.pop_back();
+    if (_entries.empty())
+    {
+        _scheduler.cancel(*this);
+    }
+}
+
+void ConnectionScheduler::fire()
+{
+    tick();
+    arm();
+}
+
+void ConnectionScheduler::arm()
+{
+    if (_slots != 0 && !_entries.empty() && !isScheduled())
+    {
+        _scheduler.schedule(*this, _scheduler.now() + _parameters.tickInterval);
+    }
+}
+
+Timestamp ConnectionScheduler::idleSince(const Entry& entry) const
+{
+    return entry.button->lastActivity();
+}
+
+Timestamp ConnectionScheduler::waitingRank(const Button& button, Timestamp since, Timestamp now) const
+{
+    if (button.transport().isAdvertising())
+    {
+        return std::numeric_limits<Timestamp>::max();
+    }
+    Timestamp rank = now - since;
+    Timestamp activity = button.lastActivity();
+    if (activity != 0 && now - activity < _parameters.activityWindow)
+    {
+        rank += _parameters.activityWindow - (now - activity);
+    }
+    int rssi = button.lastRSSI();
+    if (rssi < 0 && rssi > -100)
+    {
+        rank += (Timestamp)(rssi + 100) * _parameters.rssiWeight;
+    }
+    return rank;
+}
+
+void ConnectionScheduler::tick()
+{
+    if (_slots == 0)
+    {
+        return;
+    }
+    Timestamp now = _scheduler.now();
+    size_t occupied = 0;
+    _waiting.clear();
+    _evictable.clear();
+    for (size_t i = 0; i < _entries.size(); i++)
+    {
+        const Entry& entry = _entries[i];
+        const Button& button = *entry.button;
+        if (button.isParked())
+        {
+            if (button.wantsConnection())
+            {
+                _waiting.push_back(Candidate { i, waitingRank(button, entry.since, now), false, false });
+            }
+            continue;
+        }
+        if (button.connectionState() != ConnectionState::Disconnected)
+        {
+            occupied++;
+        }
+        if (!button.wantsConnection())
+        {
+            continue;
+        }
+        if (!button.isReady())
+        {
+            // A pending connection that does not complete is most likely a flic out of range, it goes first.
+            bool timedOut = now - entry.since >= _parameters.connectTimeout;
+            _evictable.push_back(Candidate { i, std::numeric_limits<Timestamp>::min(), timedOut, timedOut });
+        }
+        else
+        {
+            // An advertising flic may take the slot of a button that has been quiet for a moment, anything else only that
+            // of one that has gone idle.
+            Timestamp quiet = now - std::max(idleSince(entry), entry.since);
+            bool preemptible = now - entry.since >= _parameters.minimumDwell && quiet >= _parameters.minimumDwell;
+            bool idle = preemptible && now - idleSince(entry) >= _parameters.idleTimeout;
+            _evictable.push_back(Candidate { i, idleSince(entry), preemptible, idle });
+        }
+    }
+
+    // Preemptible buttons come first, the longest idle (or a pending connection) first among them.
+    std::sort(_evictable.begin(), _evictable.end(), [](const Candidate& a, const Candidate& b)
+    {
+        return a.preemptible != b.preemptible ? a.preemptible : a.rank < b.rank;
+    });
+    std::sort(_waiting.begin(), _waiting.end(), [](const Candidate& a, const Candidate& b) { return a.rank > b.rank; });
+
+    // Over budget after the limit was lowered: park regardless of how long a button has had its slot.
+    size_t next = 0;
+    for (size_t over = occupied > _slots ? occupied - _slots : 0; over > 0 && next < _evictable.size(); over--, next++)
+    {
+        park(_entries[_evictable[next].index], false);
+    }
+
+    // Slots freed by parking only become available once the link is down, they are filled on a later tick.
+    size_t free = occupied < _slots ? _slots - occupied : 0;
+    size_t admitted = std::min(free, _waiting.size());
+    for (size_t i = 0; i < admitted; i++)
+    {
+        admit(_entries[_waiting[i].index]);
+    }
+
+    // Rotate for the remaining waiting buttons, as long as each outranks the button it displaces once that is parked.
+    for (size_t i = admitted; i < _waiting.size() && next < _evictable.size(); i++, next++)
+    {
+        const Candidate& candidate = _evictable[next];
+        bool advertising = _waiting[i].rank == std::numeric_limits<Timestamp>::max();
+        if (!(advertising ? candidate.preemptible : candidate.idle))
+        {
+            break;
+        }
+        Entry& evicted = _entries[candidate.index];
+        bool pending = !evicted.button->isReady();
+        if (!pending && _waiting[i].rank <= waitingRank(*evicted.button, now, now))
+        {
+            break;
+        }
+        park(evicted, pending);
+    }
+}
+
+void ConnectionScheduler::admit(Entry& entry)
+{
+    entry.since = _scheduler.now();
+    _admissions++;
+    entry.button->setParked(false);
+}
+
+void ConnectionScheduler::park(Entry& entry, bool timedOut)
+{
+    entry.since = _scheduler.now();
+    if (timedOut)
+    {
+        _timeouts++;
+    }
+    else
+    {
+        _rotations++;
+    }
+    entry.button->setParked(true);
+}
+
+ConnectionSlotStats ConnectionScheduler::stats() const
+{
+    ConnectionSlotStats stats;
+    stats.slots = _slots;
+    for (const Entry& entry : _entries)
+    {
+        const Button& button = *entry.button;
+        if (button.isParked())
+        {
+            stats.waiting += button.wantsConnection();
+            continue;
+        }
+        if (button.connectionState() != ConnectionState::Disconnected)
+        {
+            stats.occupied++;
+        }
+        stats.connected += button.isReady();
+    }
+    stats.admissions = _admissions;
+    stats.rotations = _rotations;
+    stats.timeouts = _timeouts;
+    return stats;
+}
+
+} // namespace flic
+} // namespace scl
@@ -0,0 +1,152 @@
+//
+//  @file ConnectionScheduler.h
+//  @framework fliclib-core
+//
+//  Copyright (c) 2016-2026 Shortcut Labs. All rights reserved.
+//
+
+#ifndef SCL_FLIC_CONNECTION_SCHEDULER_H
+#define SCL_FLIC_CONNECTION_SCHEDULER_H
+
+#include <vector>
+
+#include "Scheduler.h"
+
+namespace scl {
+namespace flic {
+
+class Button;
+
+/*!
+ *  @struct ConnectionSchedulerParameters
+ *
+ *  @discussion Tuning of a ConnectionScheduler.
+ *              <br/><br/>
+ *              <code>tickInterval</code> is how often slots are reassigned. A button gets to keep its slot for at least
+ *              <code>minimumDwell</code>, and as long as it has had a button event within the last
+ *              <code>minimumDwell</code>. After that an advertising flic may take its slot, other waiting buttons only
+ *              once it has had no button events for <code>idleTimeout</code>. A connection that has not become ready
+ *              within <code>connectTimeout</code> (typically a flic that is out of range) gives up its slot to any
+ *              waiting button.
+ *              <br/><br/>
+ *              Waiting buttons are ranked by how long they have been waiting, plus up to <code>activityWindow</code> for a
+ *              button event within that window (a recent event counting more) and <code>rssiWeight</code> for every dB
+ *              of the last RSSI reading above -100 dBm. A flic that is seen advertising always goes first.
+ *
+ */
+struct ConnectionSchedulerParameters
+{
+    Timestamp tickInterval = 100 * kNanosPerMilli;
+    Timestamp minimumDwell = 2 * kNanosPerSecond;
+    Timestamp idleTimeout = 15 * kNanosPerSecond;
+    Timestamp connectTimeout = 3 * kNanosPerSecond;
+    Timestamp activityWindow = 300 * kNanosPerSecond;
+    Timestamp rssiWeight = 50 * kNanosPerMilli;
+};
+
+/*!
+ *  @struct ConnectionSlotStats
+ *
+ *  @discussion Slot occupancy at the time of the query. <code>occupied</code> counts buttons holding a link or a pending
+ *              connection, <code>connected</code> the ready ones among them and <code>waiting</code> the parked buttons
+ *              that want a connection. The remaining fields are running totals: buttons given a slot, idle buttons
+ *              rotated off one and pending connections that timed out.
+ *
+ */
+struct ConnectionSlotStats
+{
+    size_t slots = 0;
+    size_t occupied = 0;
+    size_t connected = 0;
+    size_t waiting = 0;
+    uint64_t admissions = 0;
+    uint64_t rotations = 0;
+    uint64_t timeouts = 0;
+};
+
+/*!
+ *  @class ConnectionScheduler
+ *
+ *  @discussion Shares a limited number of connection slots among the buttons of a Manager, so that going past the
+ *              platform connection limit does not end in <code>Error::BluetoothErrorConnectionLimitReached</code> and
+ *              thrashing. Buttons without a slot are parked (see Button::setParked): they keep wanting a connection but
+ *              hold no link, and their flics queue events until they get one. Slots go to the highest ranked waiting
+ *              buttons, idle buttons are rotated off once others are waiting.
+ *              <br/><br/>
+ *              With no slot limit, the default, every button keeps its own pending connection as before. Only used from
+ *              the scheduler that drives the buttons.
+ *
+ */
+class ConnectionScheduler : private Timer
+{
+public:
+    explicit ConnectionScheduler(Scheduler& scheduler);
+    ~ConnectionScheduler() override;
+
+    ConnectionScheduler(const ConnectionScheduler&) = delete;
+    ConnectionScheduler& operator=(const ConnectionScheduler&) = delete;
+
+    /*!
+     *  @property slots
+     *
+     *  @discussion The number of buttons that may hold a link or pending connection at a time, 0 for no limit. Lowering
+     *              it parks the excess on the next tick, removing the limit unparks every button.
+     *
+     */
+    size_t slots() const { return _slots; }
+    void setSlots(size_t slots);
+
+    const ConnectionSchedulerParameters& parameters() const { return _parameters; }
+    void setParameters(const ConnectionSchedulerParameters& parameters) { _parameters = parameters; }
+
+    void addButton(Button& button);
+    void removeButton(Button& button);
+
+    /*!
+     *  @method tick
+     *
+     *  @discussion Reassigns slots right away instead of waiting for the next tick.
+     *
+     */
+    void tick();
+
+    ConnectionSlotStats stats() const;
+
+private:
+    struct Entry
+    {
+        Button* button;
+        /** When the button last got or gave up its slot. */
+        Timestamp since;
+    };
+
+    struct Candidate
+    {
+        size_t index;
+        Timestamp rank;
+        bool preemptible;
+        bool idle;
+    };
+
+    void fire() override;
+    void arm();
+    Timestamp idleSince(const Entry& entry) const;
+    Timestamp waitingRank(const Button& button, Timestamp since, Timestamp now) const;
+    void admit(Entry& entry);
+    void park(Entry& entry, bool timedOut);
+
+    Scheduler& _scheduler;
+    ConnectionSchedulerParameters _parameters;
+    size_t _slots = 0;
+    std::vector<Entry> _entries;
+    std::vector<Candidate> _waiting;
+    std::vector<Candidate> _evictable;
+    uint64_t _admissions = 0;
+    uint64_t _rotations = 0;
+    uint64_t _timeouts = 0;
+};
+
+} // namespace flic
+} // namespace scl
+
+#endif // SCL_FLIC_CONNECTION_SCHEDULER_H
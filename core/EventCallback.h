@@ -0,0 +1,86 @@
+//
+//  @file EventCallback.h
+//  @framework fliclib-core
+//
+//  Copyright (c) 2016-2026 Shortcut Labs. All rights reserved.
+//
+
+#ifndef SCL_FLIC_EVENT_CALLBACK_H
+#define SCL_FLIC_EVENT_CALLBACK_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*!
+ *  @enum SCLFlicButtonEventType
+ *
+ *  @discussion The values of SCLFlicButtonEventNotification <code>type</code>, the same as those of the C++ EventType.
+ *
+ */
+enum SCLFlicButtonEventType
+{
+    SCLFlicButtonEventTypeDown = 0,
+    SCLFlicButtonEventTypeUp = 1,
+    SCLFlicButtonEventTypeClick = 2,
+    SCLFlicButtonEventTypeDoubleClick = 3,
+    SCLFlicButtonEventTypeHold = 4,
+    SCLFlicButtonEventTypeProvisionalClick = 5,
+};
+
+/*!
+ *  @struct SCLFlicButtonEventNotification
+ *
+ *  @discussion A button event as handed to an SCLFlicEventCallback, plain C so that the callback can be written in C or
+ *              Objective-C. <code>buttonIndex</code> is Button::index, <code>type</code> an SCLFlicButtonEventType,
+ *              <code>queued</code> 1 for an event the flic kept while it was not connected and 0 otherwise.
+ *              <code>buttonTicks</code>, <code>eventTime</code> and <code>receivedTime</code> are the fields of the
+ *              EventTime of the event, the times in host nanoseconds.
+ *
+ */
+typedef struct SCLFlicButtonEventNotification
+{
+    uint32_t buttonIndex;
+    uint8_t type;
+    uint8_t queued;
+    uint32_t sequence;
+    uint32_t buttonTicks;
+    int64_t eventTime;
+    int64_t receivedTime;
+} SCLFlicButtonEventNotification;
+
+/*!
+ *  @typedef SCLFlicEventCallback
+ *
+ *  @discussion Takes <code>count</code> button events in the order they were produced, together with the context given
+ *              to Manager::setEventCallback. The array is only valid for the duration of the call.
+ *
+ */
+typedef void (*SCLFlicEventCallback)(void* context, const SCLFlicButtonEventNotification* events, size_t count);
+
+#ifdef __cplusplus
+#define SCL_FLIC_STATIC_ASSERT(condition, message) static_assert(condition, message)
+#else
+#define SCL_FLIC_STATIC_ASSERT(condition, message) _Static_assert(condition, message)
+#endif
+
+// The layout is the same whichever language includes this, with no padding that depends on the compiler.
+SCL_FLIC_STATIC_ASSERT(offsetof(SCLFlicButtonEventNotification, buttonIndex) == 0, "buttonIndex moved");
+SCL_FLIC_STATIC_ASSERT(offsetof(SCLFlicButtonEventNotification, type) == 4, "type moved");
+SCL_FLIC_STATIC_ASSERT(offsetof(SCLFlicButtonEventNotification, queued) == 5, "queued moved");
+SCL_FLIC_STATIC_ASSERT(offsetof(SCLFlicButtonEventNotification, sequence) == 8, "sequence moved");
+SCL_FLIC_STATIC_ASSERT(offsetof(SCLFlicButtonEventNotification, buttonTicks) == 12, "buttonTicks moved");
+SCL_FLIC_STATIC_ASSERT(offsetof(SCLFlicButtonEventNotification, eventTime) == 16, "eventTime moved");
+SCL_FLIC_STATIC_ASSERT(offsetof(SCLFlicButtonEventNotification, receivedTime) == 24, "receivedTime moved");
+SCL_FLIC_STATIC_ASSERT(sizeof(SCLFlicButtonEventNotification) == 32, "SCLFlicButtonEventNotification changed size");
+
+#undef SCL_FLIC_STATIC_ASSERT
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif // SCL_FLIC_EVENT_CALLBACK_H
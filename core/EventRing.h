@@ -0,0 +1,226 @@
+//
+//  @file EventRing.h
+//  @framework fliclib-core
+//
+//  Copyright (c) 2016-2026 Shortcut Labs. All rights reserved.
+//
+
+#ifndef SCL_FLIC_EVENT_RING_H
+#define SCL_FLIC_EVENT_RING_H
+
+#include <atomic>
+#include <memory>
+#include <thread>
+
+#include "Types.h"
+
+namespace scl {
+namespace flic {
+
+/*!
+ *  @enum OverflowPolicy
+ *
+ *  @discussion What an EventRing does when the producer finds it full.
+ *
+ */
+enum class OverflowPolicy : int
+{
+    /**
+     * The new element is discarded and counted in <code>dropped</code>. The producer never waits.
+     */
+    DropNewest = 0,
+    /**
+     * The producer yields until the consumer has made room, counted in <code>stalls</code>. Nothing is lost but the
+     * radio side is held up for as long as the delivery side is.
+     */
+    Block,
+};
+
+/*!
+ *  @struct EventRingCounters
+ *
+ *  @discussion A snapshot of the counters of an EventRing. The counters are updated with relaxed atomics and may be read
+ *              from any thread.
+ *
+ */
+struct EventRingCounters
+{
+    uint64_t pushed = 0;
+    uint64_t popped = 0;
+    uint64_t dropped = 0;
+    uint64_t stalls = 0;
+    /** The most elements the ring has held right after a push. */
+    uint64_t highWatermark = 0;
+};
+
+/*!
+ *  @class EventRing
+ *
+ *  @discussion A bounded single-producer/single-consumer ring buffer. All storage is allocated up front, pushing and
+ *              popping never lock or allocate. Exactly one thread may push and exactly one (other) thread may pop.
+ *
+ */
+template <typename T>
+class EventRing
+{
+public:
+    /*!
+     *  @discussion The capacity is rounded up to the next power of two.
+     *
+     */
+    explicit EventRing(size_t capacity, OverflowPolicy policy = OverflowPolicy::DropNewest)
+        : _policy(policy)
+    {
+        size_t rounded = 1;
+        while (rounded < capacity)
+        {
+            rounded <<= 1;
+        }
+        _mask = rounded - 1;
+        _slots.reset(new T[rounded]);
+    }
+
+    EventRing(const EventRing&) = delete;
+    EventRing& operator=(const EventRing&) = delete;
+
+    size_t capacity() const { return _mask + 1; }
+    OverflowPolicy policy() const { return _policy; }
+
+    /*!
+     *  @method push:
+     *
+     *  @discussion Producer side. Applies the overflow policy if the ring is full.
+     *
+     *  @return NO if the element was dropped.
+     *
+     */
+    bool push(const T& value)
+    {
+        return push(value, _policy);
+    }
+
+    /*!
+     *  @method push:policy:
+     *
+     *  @discussion Same as <code>push:</code> but with an explicit overflow policy, for elements that must never be dropped.
+     *
+     */
+    bool push(const T& value, OverflowPolicy policy)
+    {
+        size_t head = _head.load(std::memory_order_relaxed);
+        if (head - _cachedTail > _mask)
+        {
+            _cachedTail = _tail.load(std::memory_order_acquire);
+            if (head - _cachedTail > _mask)
+            {
+                if (policy == OverflowPolicy::DropNewest)
+                {
+                    _dropped.fetch_add(1, std::memory_order_relaxed);
+                    return false;
+                }
+                _stalls.fetch_add(1, std::memory_order_relaxed);
+                do
+                {
+                    std::this_thread::yield();
+                    _cachedTail = _tail.load(std::memory_order_acquire);
+                }
+                while (head - _cachedTail > _mask);
+            }
+        }
+
+        _slots[head & _mask] = value;
+        _head.store(head + 1, std::memory_order_release);
+
+        _pushed.fetch_add(1, std::memory_order_relaxed);
+        // The cached tail may lag behind the consumer and overstate the depth, a new high is checked against the real one.
+        uint64_t depth = head + 1 - _cachedTail;
+        if (depth > _highWatermark.load(std::memory_order_relaxed))
+        {
+            _cachedTail = _tail.load(std::memory_order_acquire);
+            depth = head + 1 - _cachedTail;
+            if (depth > _highWatermark.load(std::memory_order_relaxed))
+            {
+                _highWatermark.store(depth, std::memory_order_relaxed);
+            }
+        }
+        return true;
+    }
+
+    /*!
+     *  @method pop:
+     *
+     *  @discussion Consumer side.
+     *
+     *  @return NO if the ring was empty.
+     *
+     */
+    bool pop(T& value)
+    {
+        size_t tail = _tail.load(std::memory_order_relaxed);
+        if (tail == _cachedHead)
+        {
+            _cachedHead = _head.load(std::memory_order_acquire);
+            if (tail == _cachedHead)
+            {
+                return false;
+            }
+        }
+        value = _slots[tail & _mask];
+        _tail.store(tail + 1, std::memory_order_release);
+        _popped.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    /*!
+     *  @method full
+     *
+     *  @discussion Producer side. Whether a push would find the ring full right now.
+     *
+     */
+    bool full() const
+    {
+        return _head.load(std::memory_order_relaxed) - _tail.load(std::memory_order_acquire) > _mask;
+    }
+
+    bool empty() const
+    {
+        return _head.load(std::memory_order_acquire) == _tail.load(std::memory_order_acquire);
+    }
+
+    EventRingCounters counters() const
+    {
+        EventRingCounters counters;
+        counters.pushed = _pushed.load(std::memory_order_relaxed);
+        counters.popped = _popped.load(std::memory_order_relaxed);
+        counters.dropped = _dropped.load(std::memory_order_relaxed);
+        counters.stalls = _stalls.load(std::memory_order_relaxed);
+        counters.highWatermark = _highWatermark.load(std::memory_order_relaxed);
+        return counters;
+    }
+
+private:
+    static const size_t kCacheLine = 64;
+
+    // Producer owned.
+    alignas(kCacheLine) std::atomic<size_t> _head { 0 };
+    size_t _cachedTail = 0;
+
+    std::atomic<uint64_t> _pushed { 0 };
+    std::atomic<uint64_t> _dropped { 0 };
+    std::atomic<uint64_t> _stalls { 0 };
+    std::atomic<uint64_t> _highWatermark { 0 };
+
+    // Consumer owned.
+    alignas(kCacheLine) std::atomic<size_t> _tail { 0 };
+    size_t _cachedHead = 0;
+    std::atomic<uint64_t> _popped { 0 };
+
+    alignas(kCacheLine) OverflowPolicy _policy;
+    size_t _mask = 0;
+    std::unique_ptr<T[]> _slots;
+};
+
+} // namespace flic
+} // namespace scl
+
+#endif // SCL_FLIC_EVENT_RING_H
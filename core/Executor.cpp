@@ -0,0 +1,121 @@
+//
+//  @file Executor.cpp
+//  @framework fliclib-core
+//
+//  Copyright (c) 2016-2026 Shortcut Labs. All rights reserved.
+//
+
+#include "Executor.h"
+
+namespace scl {
+namespace flic {
+
+const size_t SerialExecutor::kInitialCapacity;
+
+SerialExecutor::SerialExecutor()
+{
+    _tasks.reserve(kInitialCapacity);
+    _running.reserve(kInitialCapacity);
+    _thread = std::thread(&SerialExecutor::run, this);
+}
+
+SerialExecutor::~SerialExecutor()
+{
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _stopping = true;
+    }
+    _condition.notify_one();
+    _thread.join();
+}
+
+void SerialExecutor::execute(std::function<void()> task)
+{
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _tasks.push_back(std::move(task));
+    }
+    _condition.notify_one();
+}
+
+void SerialExecutor::sync()
+{
+    if (runsOnCurrentThread())
+    {
+        // Called from a task, waiting would never end. The rest of the tasks the thread has taken go first, then whatever
+        // was submitted since, the task calling sync stays where it is.
+        while (_next < _running.size())
+        {
+            _running[_next++]();
+        }
+        std::vector<std::function<void()>> submitted;
+        while (true)
+        {
+            {
+                std::lock_guard<std::mutex> lock(_mutex);
+                if (_tasks.empty())
+                {
+                    // Hands back the capacity taken along with the tasks.
+                    _tasks.swap(submitted);
+                    return;
+                }
+                submitted.swap(_tasks);
+            }
+            for (std::function<void()>& task : submitted)
+            {
+                task();
+            }
+            submitted.clear();
+        }
+    }
+
+    struct Barrier
+    {
+        std::mutex mutex;
+        std::condition_variable condition;
+        bool done = false;
+    };
+    // Captures a single pointer, which std::function stores without allocating.
+    Barrier barrier;
+    Barrier* pointer = &barrier;
+    execute([pointer]
+    {
+        std::lock_guard<std::mutex> lock(pointer->mutex);
+        pointer->done = true;
+        pointer->condition.notify_one();
+    });
+    std::unique_lock<std::mutex> lock(barrier.mutex);
+    barrier.condition.wait(lock, [&barrier] { return barrier.done; });
+}
+
+void SerialExecutor::run()
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+    while (true)
+    {
+        _condition.wait(lock, [this] { return _stopping || !_tasks.empty(); });
+        if (_tasks.empty())
+        {
+            return;
+        }
+        // Swapping hands the thread every pending task and leaves both vectors with the capacity they had.
+        _running.swap(_tasks);
+        lock.unlock();
+        runTaken();
+        lock.lock();
+    }
+}
+
+void SerialExecutor::runTaken()
+{
+    // Indexed through a member, so that a sync from one of the tasks can run the ones after it.
+    while (_next < _running.size())
+    {
+        _running[_next++]();
+    }
+    _running.clear();
+    _next = 0;
+}
+
+} // namespace flic
+} // namespace scl
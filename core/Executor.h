@@ -0,0 +1,107 @@
+//
+//  @file Executor.h
+//  @framework fliclib-core
+//
+//  Copyright (c) 2016-2026 Shortcut Labs. All rights reserved.
+//
+
+#ifndef SCL_FLIC_EXECUTOR_H
+#define SCL_FLIC_EXECUTOR_H
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace scl {
+namespace flic {
+
+/*!
+ *  @class Executor
+ *
+ *  @discussion Where delegate callbacks are delivered. This is the portable counterpart of the dispatch queue that can be
+ *              passed to the manager configuration on iOS.
+ *
+ */
+class Executor
+{
+public:
+    virtual ~Executor() = default;
+
+    virtual void execute(std::function<void()> task) = 0;
+
+    /*!
+     *  @method runsOnCurrentThread
+     *
+     *  @discussion Whether tasks run on the calling thread, like <code>dispatch_get_specific</code> tells whether the
+     *              caller is on a given queue.
+     *
+     */
+    virtual bool runsOnCurrentThread() const = 0;
+
+    /*!
+     *  @method sync
+     *
+     *  @discussion Returns once every task that was submitted before the call has run. Called from the thread the tasks
+     *              run on, it runs them right away instead of waiting for them.
+     *
+     */
+    virtual void sync() = 0;
+};
+
+/*!
+ *  @class InlineExecutor
+ *
+ *  @discussion Runs tasks immediately on the calling thread.
+ *
+ */
+class InlineExecutor : public Executor
+{
+public:
+    void execute(std::function<void()> task) override { task(); }
+    bool runsOnCurrentThread() const override { return true; }
+    void sync() override {}
+};
+
+/*!
+ *  @class SerialExecutor
+ *
+ *  @discussion Runs tasks one at a time, in order, on a thread of its own. This is how the main queue or any other serial
+ *              dispatch queue behaves from the point of view of the core. The thread takes all pending tasks at once and
+ *              the queues keep their capacity, so once warmed up submitting a task that fits std::function without
+ *              allocating does not allocate.
+ *
+ */
+class SerialExecutor : public Executor
+{
+public:
+    static const size_t kInitialCapacity = 16;
+
+    SerialExecutor();
+    ~SerialExecutor() override;
+
+    SerialExecutor(const SerialExecutor&) = delete;
+    SerialExecutor& operator=(const SerialExecutor&) = delete;
+
+    void execute(std::function<void()> task) override;
+    bool runsOnCurrentThread() const override { return std::this_thread::get_id() == _thread.get_id(); }
+    void sync() override;
+
+private:
+    void run();
+    void runTaken();
+
+    std::mutex _mutex;
+    std::condition_variable _condition;
+    std::vector<std::function<void()>> _tasks;
+    std::vector<std::function<void()>> _running;
+    size_t _next = 0;
+    bool _stopping = false;
+    std::thread _thread;
+};
+
+} // namespace flic
+} // namespace scl
+
+#endif // SCL_FLIC_EXECUTOR_H
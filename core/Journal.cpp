@@ -0,0 +1,726 @@
+//
+//  @file Journal.cpp
+//  @framework fliclib-core
+//
+//  Copyright (c) 2016-2026 Shortcut Labs. All rights reserved.
+//
+
+#include "Journal.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace scl {
+namespace flic {
+
+const uint8_t StateJournal::kVersion;
+const uint8_t StateJournal::kOldestVersion;
+const size_t StateJournal::kHeaderSize;
+const size_t StateJournal::kCompactionThreshold;
+
+namespace {
+
+const uint8_t kMagic[4] = { 'F', 'L', 'J', 'N' };
+
+enum SettingsFlags : uint8_t
+{
+    kBehaviorMask = 0x03,
+    kLowLatency = 0x04,
+    kSpeculativeClicks = 0x08,
+    kAdaptiveTiming = 0x10,
+    kBatchesQueuedEvents = 0x20,
+    kWantsConnection = 0x40,
+    kProfileHigh = 0x80,
+};
+
+// Settings added after the flags byte ran out of bits go into an optional second byte, which is only written when one of
+// them is set. Older journals and readers that stop after the first byte see the defaults.
+enum ExtendedSettingsFlags : uint8_t
+{
+    kAdaptiveLatency = 0x01,
+    /** Followed by the event mask byte, left out when all events are delivered. */
+    kEventMask = 0x02,
+};
+
+// The connection profile takes the old low latency flag as its low bit, so journals written before profiles existed
+// restore a low latency button as Gaming.
+uint8_t encodeProfile(ConnectionProfile profile)
+{
+    int value = (int)profile;
+    return (uint8_t)((value & 1 ? kLowLatency : 0) | (value & 2 ? kProfileHigh : 0));
+}
+
+ConnectionProfile decodeProfile(uint8_t flags)
+{
+    return (ConnectionProfile)((flags & kLowLatency ? 1 : 0) | (flags & kProfileHigh ? 2 : 0));
+}
+
+uint32_t checksum(const uint8_t* data, size_t size)
+{
+    uint32_t hash = 0x811c9dc5u;
+    for (size_t i = 0; i < size; i++)
+    {
+        hash = (hash ^ data[i]) * 0x01000193u;
+    }
+    return hash;
+}
+
+void appendVarint(std::vector<uint8_t>& data, uint64_t value)
+{
+    while (value >= 0x80)
+    {
+        data.push_back((uint8_t)(value | 0x80));
+        value >>= 7;
+    }
+    data.push_back((uint8_t)value);
+}
+
+void appendString(std::vector<uint8_t>& data, const std::string& value)
+{
+    appendVarint(data, value.size());
+    data.insert(data.end(), value.begin(), value.end());
+}
+
+uint8_t encodeSettings(const ButtonSettings& settings)
+{
+    return (uint8_t)((int)settings.triggerBehavior & kBehaviorMask) | encodeProfile(settings.connectionProfile) |
+           (settings.speculativeClicks ? kSpeculativeClicks : 0) | (settings.adaptiveTiming ? kAdaptiveTiming : 0) |
+           (settings.batchesQueuedEvents ? kBatchesQueuedEvents : 0);
+}
+
+uint8_t encodeExtendedSettings(const ButtonSettings& settings)
+{
+    return (settings.adaptiveLatency ? kAdaptiveLatency : 0) | (settings.eventMask != kAllEvents ? kEventMask : 0);
+}
+
+void appendExtendedSettings(std::vector<uint8_t>& data, const ButtonSettings& settings)
+{
+    uint8_t flags = encodeExtendedSettings(settings);
+    if (flags)
+    {
+        data.push_back(flags);
+    }
+    if (flags & kEventMask)
+    {
+        data.push_back(settings.eventMask);
+    }
+}
+
+ButtonSettings decodeSettings(uint8_t flags)
+{
+    ButtonSettings settings;
+    settings.triggerBehavior = (TriggerBehavior)(flags & kBehaviorMask);
+    settings.connectionProfile = decodeProfile(flags);
+    settings.speculativeClicks = (flags & kSpeculativeClicks) != 0;
+    settings.adaptiveTiming = (flags & kAdaptiveTiming) != 0;
+    settings.batchesQueuedEvents = (flags & kBatchesQueuedEvents) != 0;
+    return settings;
+}
+
+class JournalReader
+{
+public:
+    JournalReader(const uint8_t* data, size_t size) : _data(data), _size(size) {}
+
+    size_t offset() const { return _offset; }
+    bool atEnd() const { return _offset == _size; }
+
+    bool readByte(uint8_t& value)
+    {
+        if (_offset == _size)
+        {
+            return false;
+        }
+        value = _data[_offset++];
+        return true;
+    }
+
+    bool readVarint(uint64_t& value)
+    {
+        value = 0;
+        for (unsigned shift = 0; shift < 64; shift += 7)
+        {
+            uint8_t byte;
+            if (!readByte(byte))
+            {
+                return false;
+            }
+            value |= (uint64_t)(byte & 0x7f) << shift;
+            if (!(byte & 0x80))
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    const uint8_t* readBytes(size_t count)
+    {
+        if (_size - _offset < count)
+        {
+            return nullptr;
+        }
+        const uint8_t* bytes = _data + _offset;
+        _offset += count;
+        return bytes;
+    }
+
+    bool readString(std::string& value)
+    {
+        uint64_t size;
+        const uint8_t* bytes;
+        if (!readVarint(size) || size > _size || !(bytes = readBytes((size_t)size)))
+        {
+            return false;
+        }
+        value.assign((const char*)bytes, (size_t)size);
+        return true;
+    }
+
+private:
+    const uint8_t* _data;
+    size_t _size;
+    size_t _offset = 0;
+};
+
+void decodeExtendedSettings(JournalReader& fields, ButtonSettings& settings)
+{
+    uint8_t flags;
+    if (!fields.readByte(flags))
+    {
+        return;
+    }
+    settings.adaptiveLatency = (flags & kAdaptiveLatency) != 0;
+    uint8_t mask;
+    if ((flags & kEventMask) && fields.readByte(mask))
+    {
+        settings.eventMask = mask & kAllEvents;
+    }
+}
+
+// Makes a rename in the directory of the given file durable.
+bool syncDirectory(const std::string& path)
+{
+    size_t slash = path.rfind('/');
+    std::string directory = slash == std::string::npos ? "." : slash == 0 ? "/" : path.substr(0, slash);
+    int fd = ::open(directory.c_str(), O_RDONLY);
+    if (fd < 0)
+    {
+        return false;
+    }
+    bool synced = fsync(fd) == 0;
+    ::close(fd);
+    return synced;
+}
+
+} // namespace
+
+StateJournal::~StateJournal()
+{
+    close();
+}
+
+bool StateJournal::open(const std::string& path, JournalState* restored)
+{
+    close();
+    _entries.clear();
+    _pending.clear();
+    _buffer.clear();
+    _needsCompaction = false;
+    _nextId = 1;
+    int fd = ::open(path.c_str(), O_RDWR | O_CREAT, 0644);
+    struct stat info;
+    if (fd < 0 || fstat(fd, &info) != 0)
+    {
+        if (fd >= 0)
+        {
+            ::close(fd);
+        }
+        return false;
+    }
+
+    size_t size = (size_t)info.st_size;
+    size_t valid = 0;
+    size_t records = 0;
+    if (size >= kHeaderSize)
+    {
+        void* mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapping == MAP_FAILED)
+        {
+            ::close(fd);
+            return false;
+        }
+        const uint8_t* data = (const uint8_t*)mapping;
+        uint8_t version = data[sizeof(kMagic)];
+        if (memcmp(data, kMagic, sizeof(kMagic)) != 0 || version < kOldestVersion || version > kVersion)
+        {
+            munmap(mapping, size);
+            ::close(fd);
+            return false;
+        }
+
+        // Buttons are looked up by id while reading, the map is keyed by identifier only once they are known.
+        std::unordered_map<uint64_t, Entry> byId;
+        JournalReader reader(data + kHeaderSize, size - kHeaderSize);
+        while (!reader.atEnd())
+        {
+            size_t start = reader.offset();
+            uint64_t length;
+            const uint8_t* body;
+            const uint8_t* stored;
+            if (!reader.readVarint(length) || length > size || !(body = reader.readBytes((size_t)length)) ||
+                !(stored = reader.readBytes(4)))
+            {
+                break;
+            }
+            uint32_t expected = (uint32_t)stored[0] | (uint32_t)stored[1] << 8 | (uint32_t)stored[2] << 16 |
+                                (uint32_t)stored[3] << 24;
+            if (checksum(body, (size_t)length) != expected)
+            {
+                break;
+            }
+
+            JournalReader fields(body, (size_t)length);
+            uint8_t kind;
+            uint64_t id;
+            if (!fields.readByte(kind) || !fields.readVarint(id))
+            {
+                break;
+            }
+            bool parsed = true;
+            if (kind == Added)
+            {
+                Entry entry;
+                entry.id = id;
+                entry.size = reader.offset() - start;
+                JournalButton& button = entry.button;
+                const uint8_t* key;
+                uint64_t pressCount;
+                uint8_t flags;
+                parsed = fields.readString(button.info.identifier) && fields.readString(button.info.publicKey) &&
+                         fields.readString(button.info.name) && fields.readString(button.info.userAssignedName) &&
+                         (key = fields.readBytes(ChaskeyKey::kKeySize)) && fields.readVarint(pressCount) &&
+                         fields.readByte(flags);
+                if (parsed)
+                {
+                    memcpy(button.info.longTermKey, key, ChaskeyKey::kKeySize);
+                    button.pressCount = (uint32_t)pressCount;
+                    button.settings = decodeSettings(flags);
+                    button.wantsConnection = (flags & kWantsConnection) != 0;
+                    decodeExtendedSettings(fields, button.settings);
+                    byId[id] = std::move(entry);
+                    _nextId = std::max(_nextId, id + 1);
+                }
+            }
+            else
+            {
+                auto it = byId.find(id);
+                uint8_t flags;
+                uint64_t pressCount;
+                if (it == byId.end())
+                {
+                    parsed = false;
+                }
+                else if (kind == Removed)
+                {
+                    byId.erase(it);
+                }
+                else if (kind == Settings && (parsed = fields.readByte(flags)))
+                {
+                    it->second.button.settings = decodeSettings(flags);
+                    decodeExtendedSettings(fields, it->second.button.settings);
+                }
+                else if (kind == PressCount && (parsed = fields.readVarint(pressCount)))
+                {
+                    it->second.button.pressCount = (uint32_t)pressCount;
+                }
+                else if (kind == WantsConnection && (parsed = fields.readByte(flags)))
+                {
+                    it->second.button.wantsConnection = flags != 0;
+                }
+            }
+            if (!parsed)
+            {
+                break;
+            }
+            records++;
+            valid = kHeaderSize + reader.offset();
+        }
+        munmap(mapping, size);
+
+        for (auto& item : byId)
+        {
+            std::string identifier = item.second.button.info.identifier;
+            _entries[identifier] = std::move(item.second);
+        }
+        if (valid < size && ftruncate(fd, (off_t)valid) != 0)
+        {
+            ::close(fd);
+            return false;
+        }
+        // What is appended from now on may use the encodings of the current version, which an older reader must reject.
+        if (version != kVersion && pwrite(fd, &kVersion, 1, sizeof(kMagic)) != 1)
+        {
+            ::close(fd);
+            return false;
+        }
+    }
+    else
+    {
+        // New, or torn while being created.
+        uint8_t header[kHeaderSize];
+        memcpy(header, kMagic, sizeof(kMagic));
+        header[sizeof(kMagic)] = kVersion;
+        if (ftruncate(fd, 0) != 0 || pwrite(fd, header, kHeaderSize, 0) != (ssize_t)kHeaderSize)
+        {
+            ::close(fd);
+            return false;
+        }
+        valid = kHeaderSize;
+    }
+
+    if (lseek(fd, (off_t)valid, SEEK_SET) < 0)
+    {
+        ::close(fd);
+        return false;
+    }
+    _fd = fd;
+    _path = path;
+    _fileSize = valid;
+    _liveSize = 0;
+    for (auto& item : _entries)
+    {
+        _liveSize += item.second.size;
+    }
+
+    if (restored)
+    {
+        restored->buttons.clear();
+        std::vector<const Entry*> ordered;
+        for (auto& item : _entries)
+        {
+            ordered.push_back(&item.second);
+        }
+        std::sort(ordered.begin(), ordered.end(), [](const Entry* a, const Entry* b) { return a->id < b->id; });
+        restored->buttons.reserve(ordered.size());
+        for (const Entry* entry : ordered)
+        {
+            restored->buttons.push_back(entry->button);
+        }
+        restored->records = records;
+        restored->truncated = valid < size;
+    }
+    return true;
+}
+
+void StateJournal::close()
+{
+    if (_fd >= 0)
+    {
+        flush();
+        ::close(_fd);
+        _fd = -1;
+        // What could not be written is lost with the descriptor.
+        _buffer.clear();
+        _needsCompaction = false;
+    }
+}
+
+const JournalButton* StateJournal::find(const std::string& identifier) const
+{
+    auto it = _entries.find(identifier);
+    return it == _entries.end() ? nullptr : &it->second.button;
+}
+
+bool StateJournal::recordButton(const JournalButton& button)
+{
+    encodePending();
+    auto it = _entries.find(button.info.identifier);
+    if (it == _entries.end())
+    {
+        Entry& entry = _entries[button.info.identifier];
+        entry.id = _nextId++;
+        entry.button = button;
+        size_t before = _buffer.size();
+        encodeAdded(entry);
+        entry.size = _buffer.size() - before;
+        _liveSize += entry.size;
+        return write();
+    }
+
+    Entry& entry = it->second;
+    if (button.settings != entry.button.settings)
+    {
+        entry.button.settings = button.settings;
+        beginRecord(Settings, entry.id);
+        _body.push_back(encodeSettings(button.settings));
+        appendExtendedSettings(_body, button.settings);
+        endRecord();
+    }
+    if (button.pressCount != entry.button.pressCount)
+    {
+        entry.button.pressCount = button.pressCount;
+        beginRecord(PressCount, entry.id);
+        appendVarint(_body, button.pressCount);
+        endRecord();
+    }
+    if (button.wantsConnection != entry.button.wantsConnection)
+    {
+        entry.button.wantsConnection = button.wantsConnection;
+        beginRecord(WantsConnection, entry.id);
+        _body.push_back(button.wantsConnection);
+        endRecord();
+    }
+    return write();
+}
+
+bool StateJournal::recordRemoved(const std::string& identifier)
+{
+    auto it = _entries.find(identifier);
+    if (it == _entries.end())
+    {
+        return true;
+    }
+    encodePending();
+    beginRecord(Removed, it->second.id);
+    endRecord();
+    _liveSize -= it->second.size;
+    if (it->second.pending)
+    {
+        _pending.erase(std::find(_pending.begin(), _pending.end(), &it->second));
+    }
+    _entries.erase(it);
+    return write();
+}
+
+bool StateJournal::recordSettings(const std::string& identifier, const ButtonSettings& settings)
+{
+    const JournalButton* current = find(identifier);
+    if (!current)
+    {
+        return false;
+    }
+    JournalButton button = *current;
+    button.settings = settings;
+    return recordButton(button);
+}
+
+bool StateJournal::recordPressCount(const std::string& identifier, uint32_t pressCount)
+{
+    auto it = _entries.find(identifier);
+    if (it == _entries.end())
+    {
+        return false;
+    }
+    if (it->second.button.pressCount == pressCount)
+    {
+        return true;
+    }
+    Entry& entry = it->second;
+    entry.button.pressCount = pressCount;
+    if (entry.pending)
+    {
+        _coalescedRecords++;
+        return true;
+    }
+    entry.pending = true;
+    _pending.push_back(&entry);
+    return true;
+}
+
+bool StateJournal::flush()
+{
+    encodePending();
+    return write();
+}
+
+bool StateJournal::recordWantsConnection(const std::string& identifier, bool wantsConnection)
+{
+    const JournalButton* current = find(identifier);
+    if (!current)
+    {
+        return false;
+    }
+    JournalButton button = *current;
+    button.wantsConnection = wantsConnection;
+    return recordButton(button);
+}
+
+void StateJournal::beginRecord(Kind kind, uint64_t id)
+{
+    _body.clear();
+    _body.push_back(kind);
+    appendVarint(_body, id);
+}
+
+void StateJournal::endRecord()
+{
+    appendVarint(_buffer, _body.size());
+    _buffer.insert(_buffer.end(), _body.begin(), _body.end());
+    uint32_t sum = checksum(_body.data(), _body.size());
+    for (size_t i = 0; i < 4; i++)
+    {
+        _buffer.push_back((uint8_t)(sum >> (i * 8)));
+    }
+    _recordsWritten++;
+}
+
+void StateJournal::encodeAdded(const Entry& entry)
+{
+    const JournalButton& button = entry.button;
+    beginRecord(Added, entry.id);
+    appendString(_body, button.info.identifier);
+    appendString(_body, button.info.publicKey);
+    appendString(_body, button.info.name);
+    appendString(_body, button.info.userAssignedName);
+    _body.insert(_body.end(), button.info.longTermKey, button.info.longTermKey + ChaskeyKey::kKeySize);
+    appendVarint(_body, button.pressCount);
+    _body.push_back(encodeSettings(button.settings) | (button.wantsConnection ? kWantsConnection : 0));
+    appendExtendedSettings(_body, button.settings);
+    endRecord();
+}
+
+void StateJournal::encodePending()
+{
+    // They stay pending until the write that carries them succeeds. After a failed one they are encoded again with
+    // their latest value, the copy still buffered from before is harmless as the last record wins.
+    for (Entry* entry : _pending)
+    {
+        beginRecord(PressCount, entry->id);
+        appendVarint(_body, entry->button.pressCount);
+        endRecord();
+    }
+}
+
+void StateJournal::clearPending()
+{
+    for (Entry* entry : _pending)
+    {
+        entry->pending = false;
+    }
+    _pending.clear();
+}
+
+bool StateJournal::write()
+{
+    if (_fd >= 0 && _needsCompaction)
+    {
+        // The file ends in a torn record that could not be cut off, only a rewrite from memory gets rid of it.
+        return compact();
+    }
+    if (_buffer.empty())
+    {
+        return true;
+    }
+    if (_fd < 0)
+    {
+        _buffer.clear();
+        return false;
+    }
+    ssize_t written = ::write(_fd, _buffer.data(), _buffer.size());
+    if (written == (ssize_t)_buffer.size())
+    {
+        _fileSize += (uint64_t)written;
+        _bytesWritten += (uint64_t)written;
+        _writes++;
+        _buffer.clear();
+        clearPending();
+        maybeCompact();
+        return true;
+    }
+
+    // A torn record would hide everything appended after it from the next load. It is cut off and the records stay
+    // buffered, they go out again with the next write.
+    if (written > 0 && (ftruncate(_fd, (off_t)_fileSize) != 0 || lseek(_fd, (off_t)_fileSize, SEEK_SET) < 0))
+    {
+        _needsCompaction = true;
+    }
+    return false;
+}
+
+void StateJournal::maybeCompact()
+{
+    if (_fileSize >= kCompactionThreshold && _fileSize > 2 * (_liveSize + kHeaderSize))
+    {
+        compact();
+    }
+}
+
+bool StateJournal::compact()
+{
+    if (_fd < 0)
+    {
+        return false;
+    }
+    std::vector<Entry*> ordered;
+    for (auto& item : _entries)
+    {
+        ordered.push_back(&item.second);
+    }
+    std::sort(ordered.begin(), ordered.end(), [](const Entry* a, const Entry* b) { return a->id < b->id; });
+
+    // Records that are still waiting to be written are superseded by the image, but have to be kept should it fail.
+    std::vector<uint8_t> retained;
+    retained.swap(_buffer);
+    _buffer.assign(kMagic, kMagic + sizeof(kMagic));
+    _buffer.push_back(kVersion);
+    std::vector<size_t> sizes;
+    sizes.reserve(ordered.size());
+    uint64_t liveSize = 0;
+    for (Entry* entry : ordered)
+    {
+        size_t before = _buffer.size();
+        encodeAdded(*entry);
+        sizes.push_back(_buffer.size() - before);
+        liveSize += sizes.back();
+    }
+
+    size_t imageSize = _buffer.size();
+
+    // The new file only replaces the journal once it is completely on storage, until then the old one stays valid. The
+    // descriptor it was written through follows it across the rename, so nothing can fail once it has replaced the
+    // journal, and the old descriptor is only let go of then.
+    std::string temporary = _path + ".compact";
+    int fd = ::open(temporary.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    bool written = fd >= 0 && ::write(fd, _buffer.data(), _buffer.size()) == (ssize_t)_buffer.size() && fsync(fd) == 0;
+    _buffer.clear();
+    if (!written || rename(temporary.c_str(), _path.c_str()) != 0)
+    {
+        if (fd >= 0)
+        {
+            ::close(fd);
+        }
+        unlink(temporary.c_str());
+        _buffer.swap(retained);
+        return false;
+    }
+    syncDirectory(_path);
+    ::close(_fd);
+    _fd = fd;
+    _needsCompaction = false;
+    _fileSize = imageSize;
+    _bytesWritten += imageSize;
+    for (size_t i = 0; i < ordered.size(); i++)
+    {
+        ordered[i]->size = sizes[i];
+    }
+    _liveSize = liveSize;
+    _compactions++;
+    _writes++;
+    // The compacted records hold the latest press counts.
+    clearPending();
+    return true;
+}
+
+bool StateJournal::sync()
+{
+    return _fd >= 0 && fsync(_fd) == 0;
+}
+
+} // namespace flic
+} // namespace scl
@@ -0,0 +1,226 @@
+//
+//  @file Journal.h
+//  @framework fliclib-core
+//
+//  Copyright (c) 2016-2026 Shortcut Labs. All rights reserved.
+//
+
+#ifndef SCL_FLIC_JOURNAL_H
+#define SCL_FLIC_JOURNAL_H
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "Button.h"
+
+namespace scl {
+namespace flic {
+
+/*!
+ *  @struct JournalButton
+ *
+ *  @discussion The persisted state of one button: what is needed to create it again and the state it had.
+ *
+ */
+struct JournalButton
+{
+    ButtonInfo info;
+    ButtonSettings settings;
+    uint32_t pressCount = 0;
+    bool wantsConnection = true;
+};
+
+/*!
+ *  @struct JournalState
+ *
+ *  @discussion The buttons found in a journal, in the order they were first recorded. <code>records</code> is the number
+ *              of records that were read and <code>truncated</code> tells whether a torn or corrupt tail, typically
+ *              from a crash during a write, was dropped.
+ *
+ */
+struct JournalState
+{
+    std::vector<JournalButton> buttons;
+    size_t records = 0;
+    bool truncated = false;
+};
+
+/*!
+ *  @class StateJournal
+ *
+ *  @discussion Append-only persistence of the state of a Manager. Every change is a small record appended to the file:
+ *              a few bytes for a press count or a settings change, a full record only when a button is added. Once the
+ *              file has grown past <code>kCompactionThreshold</code> and to more than twice the size of the live state
+ *              it is compacted into one record per button, written to a temporary file that then replaces the journal.
+ *              <br/><br/>
+ *              The file starts with the magic <code>FLJN</code> and a version byte. A journal of a version from
+ *              <code>kOldestVersion</code> on is loaded and its version byte brought up to <code>kVersion</code>, as its
+ *              records are valid in the newer version, any other version is rejected. Each record is an unsigned LEB128
+ *              body length, the body (a kind byte, the journal id of the button as a varint and a kind specific payload)
+ *              and a little endian FNV-1a checksum of the body. Loading maps the file into memory and stops at the first
+ *              record that is incomplete or fails its checksum, so a crash at any point loses at most the changes that
+ *              were being written.
+ *              <br/><br/>
+ *              Press counts change on every button event and are coalesced: <code>recordPressCount</code> only notes
+ *              the new value, and one record per button with the latest value is written by the next
+ *              <code>flush</code>, by any other change, which flushes pending press counts ahead of its own record, or
+ *              by <code>close</code>. Every other change is handed to the operating system as it is made, and
+ *              <code>sync</code> forces what has been written to storage, see Manager::flushJournal for when the manager
+ *              calls it. Compaction syncs the new file and the rename that puts it in place. After a crash a restored
+ *              press count is therefore never ahead of the button, at worst it is the value of the last flush.
+ *              <br/><br/>
+ *              A write that fails or is cut short is undone: the torn part is cut off the file and the records it
+ *              carried stay buffered and go out again ahead of the next change, or with the next <code>flush</code>. If
+ *              the torn part cannot be cut off the next write compacts the journal instead. A compaction that fails
+ *              leaves the journal as it was, with the pending press counts still pending.
+ *              <br/><br/>
+ *              Only used from the scheduler that drives the manager.
+ *
+ */
+class StateJournal
+{
+public:
+    /** Version 2 added connection profiles and the extended settings byte to the settings of a record. */
+    static const uint8_t kVersion = 2;
+    static const uint8_t kOldestVersion = 1;
+    static const size_t kHeaderSize = 5;
+    static const size_t kCompactionThreshold = 64 * 1024;
+
+    StateJournal() = default;
+    ~StateJournal();
+
+    StateJournal(const StateJournal&) = delete;
+    StateJournal& operator=(const StateJournal&) = delete;
+
+    /*!
+     *  @method open:restored:
+     *
+     *  @discussion Loads the journal at <code>path</code>, creating it if it does not exist, and keeps it open for
+     *              appending. A torn tail is cut off.
+     *
+     *  @return false if the file could not be read or created, or is not a journal.
+     *
+     */
+    bool open(const std::string& path, JournalState* restored = nullptr);
+    void close();
+    bool isOpen() const { return _fd >= 0; }
+
+    /*!
+     *  @method recordButton:
+     *
+     *  @discussion Records the full state of a button. For a button the journal already holds only the fields that differ
+     *              are written, if any.
+     *
+     */
+    bool recordButton(const JournalButton& button);
+    bool recordRemoved(const std::string& identifier);
+    bool recordSettings(const std::string& identifier, const ButtonSettings& settings);
+    bool recordWantsConnection(const std::string& identifier, bool wantsConnection);
+
+    /*!
+     *  @method recordPressCount:pressCount:
+     *
+     *  @discussion Notes the press count of a button, it is written by the next <code>flush</code>.
+     *
+     */
+    bool recordPressCount(const std::string& identifier, uint32_t pressCount);
+
+    /*!
+     *  @method flush
+     *
+     *  @discussion Writes the pending press counts, all in one write. If it fails they stay pending.
+     *
+     */
+    bool flush();
+    size_t pendingRecords() const { return _pending.size(); }
+
+    /*!
+     *  @method find:
+     *
+     *  @return The state the journal holds for the button, or nullptr.
+     *
+     */
+    const JournalButton* find(const std::string& identifier) const;
+    size_t buttonCount() const { return _entries.size(); }
+
+    /*!
+     *  @method compact
+     *
+     *  @discussion Rewrites the journal as one record per button. Happens automatically, see the class discussion.
+     *
+     */
+    bool compact();
+    bool sync();
+
+    uint64_t fileSize() const { return _fileSize; }
+
+    /*!
+     *  @property liveSize
+     *
+     *  @discussion The size of the records of the buttons the journal holds, what a compaction leaves without the header.
+     *              Exact after a compaction, an estimate in between.
+     *
+     */
+    uint64_t liveSize() const { return _liveSize; }
+    uint64_t bytesWritten() const { return _bytesWritten; }
+    uint64_t recordsWritten() const { return _recordsWritten; }
+    uint64_t compactions() const { return _compactions; }
+    uint64_t writes() const { return _writes; }
+
+    /*!
+     *  @property coalescedRecords
+     *
+     *  @discussion The number of press count changes that replaced one that was still pending, and so were never
+     *              written.
+     *
+     */
+    uint64_t coalescedRecords() const { return _coalescedRecords; }
+
+private:
+    enum Kind : uint8_t
+    {
+        Added = 1,
+        Removed,
+        Settings,
+        PressCount,
+        WantsConnection,
+    };
+
+    struct Entry
+    {
+        uint64_t id;
+        JournalButton button;
+        size_t size;
+        bool pending = false;
+    };
+
+    void beginRecord(Kind kind, uint64_t id);
+    void endRecord();
+    void encodeAdded(const Entry& entry);
+    void encodePending();
+    void clearPending();
+    bool write();
+    void maybeCompact();
+
+    std::string _path;
+    int _fd = -1;
+    uint64_t _nextId = 1;
+    std::unordered_map<std::string, Entry> _entries;
+    std::vector<uint8_t> _body;
+    std::vector<uint8_t> _buffer;
+    std::vector<Entry*> _pending;
+    bool _needsCompaction = false;
+    uint64_t _fileSize = 0;
+    uint64_t _liveSize = 0;
+    uint64_t _bytesWritten = 0;
+    uint64_t _recordsWritten = 0;
+    uint64_t _compactions = 0;
+    uint64_t _writes = 0;
+    uint64_t _coalescedRecords = 0;
+};
+
+} // namespace flic
+} // namespace scl
+
+#endif // SCL_FLIC_JOURNAL_H
@@ -0,0 +1,149 @@
+//
+//  @file Latency.cpp
+//  @framework fliclib-core
+//
+//  Copyright (c) 2016-2026 Shortcut Labs. All rights reserved.
+//
+
+#include "Latency.h"
+
+#include <cmath>
+#include <cstdio>
+
+namespace scl {
+namespace flic {
+
+const size_t LatencySnapshot::kBucketCount;
+const size_t LatencyHistogram::kBucketCount;
+
+const char* latencyStageName(LatencyStage stage)
+{
+    switch (stage)
+    {
+        case LatencyStage::Radio:
+            return "radio";
+        case LatencyStage::Verify:
+            return "verify";
+        case LatencyStage::Classify:
+            return "classify";
+        case LatencyStage::Deliver:
+            return "deliver";
+    }
+    return "unknown";
+}
+
+Timestamp LatencySnapshot::percentile(double fraction) const
+{
+    if (count == 0)
+    {
+        return 0;
+    }
+    uint64_t target = (uint64_t)std::ceil(fraction * (double)count);
+    if (target == 0)
+    {
+        target = 1;
+    }
+    uint64_t seen = 0;
+    for (size_t i = 0; i < kBucketCount; i++)
+    {
+        seen += counts[i];
+        if (seen >= target)
+        {
+            Timestamp bound = LatencyHistogram::bucketUpperBound(i);
+            return bound < max ? bound : max;
+        }
+    }
+    return max;
+}
+
+void LatencySnapshot::merge(const LatencySnapshot& other)
+{
+    for (size_t i = 0; i < kBucketCount; i++)
+    {
+        counts[i] += other.counts[i];
+    }
+    count += other.count;
+    sum += other.sum;
+    if (other.max > max)
+    {
+        max = other.max;
+    }
+}
+
+size_t LatencyHistogram::bucketIndex(Timestamp duration)
+{
+    if (duration < 4000)
+    {
+        return duration < 0 ? 0 : (size_t)(duration / 1000);
+    }
+    uint64_t micros = (uint64_t)duration / 1000;
+    size_t exponent = 63 - (size_t)__builtin_clzll(micros);
+    size_t index = 4 * (exponent - 1) + (size_t)((micros >> (exponent - 2)) & 3);
+    return index < kBucketCount ? index : kBucketCount - 1;
+}
+
+Timestamp LatencyHistogram::bucketUpperBound(size_t index)
+{
+    if (index < 4)
+    {
+        return (Timestamp)(index + 1) * 1000;
+    }
+    size_t exponent = index / 4 + 1;
+    return ((Timestamp)(5 + index % 4) << (exponent - 2)) * 1000;
+}
+
+void LatencyHistogram::record(Timestamp duration)
+{
+    if (duration < 0)
+    {
+        duration = 0;
+    }
+    // Single writer, so plain load/store pairs are enough and avoid locked read-modify-write instructions.
+    std::atomic<uint32_t>& bucket = _counts[bucketIndex(duration)];
+    bucket.store(bucket.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    _sum.store(_sum.load(std::memory_order_relaxed) + duration, std::memory_order_relaxed);
+    if (duration > _max.load(std::memory_order_relaxed))
+    {
+        _max.store(duration, std::memory_order_relaxed);
+    }
+}
+
+LatencySnapshot LatencyHistogram::snapshot() const
+{
+    LatencySnapshot snapshot;
+    for (size_t i = 0; i < kBucketCount; i++)
+    {
+        snapshot.counts[i] = _counts[i].load(std::memory_order_relaxed);
+        // Derived from the buckets so that a snapshot taken while the writer is busy is still self-consistent.
+        snapshot.count += snapshot.counts[i];
+    }
+    snapshot.sum = _sum.load(std::memory_order_relaxed);
+    snapshot.max = _max.load(std::memory_order_relaxed);
+    return snapshot;
+}
+
+void appendLatencyMetrics(const std::string& labels, const LatencySnapshot& snapshot, std::string& output)
+{
+    char line[64];
+    uint64_t cumulative = 0;
+    for (size_t i = 0; i < LatencySnapshot::kBucketCount; i++)
+    {
+        if (snapshot.counts[i] == 0)
+        {
+            continue;
+        }
+        cumulative += snapshot.counts[i];
+        snprintf(line, sizeof(line), "%.6f\"} %llu\n", (double)LatencyHistogram::bucketUpperBound(i) / kNanosPerSecond,
+                 (unsigned long long)cumulative);
+        output += "flic_event_latency_seconds_bucket{" + labels + ",le=\"" + line;
+    }
+    snprintf(line, sizeof(line), "+Inf\"} %llu\n", (unsigned long long)snapshot.count);
+    output += "flic_event_latency_seconds_bucket{" + labels + ",le=\"" + line;
+    snprintf(line, sizeof(line), "} %.9f\n", (double)snapshot.sum / kNanosPerSecond);
+    output += "flic_event_latency_seconds_sum{" + labels + line;
+    snprintf(line, sizeof(line), "} %llu\n", (unsigned long long)snapshot.count);
+    output += "flic_event_latency_seconds_count{" + labels + line;
+}
+
+} // namespace flic
+} // namespace scl
@@ -0,0 +1,166 @@
+//
+//  @file Latency.h
+//  @framework fliclib-core
+//
+//  Copyright (c) 2016-2026 Shortcut Labs. All rights reserved.
+//
+
+#ifndef SCL_FLIC_LATENCY_H
+#define SCL_FLIC_LATENCY_H
+
+#include <atomic>
+#include <chrono>
+#include <string>
+
+#include "Types.h"
+
+namespace scl {
+namespace flic {
+
+/*!
+ *  @enum LatencyStage
+ *
+ *  @discussion The stages a real time button event goes through between the physical press and the delegate callback.
+ *              Queued events are not recorded, their latency is the time the flic spent out of range.
+ *
+ */
+enum class LatencyStage : int
+{
+    /**
+     * From the moment the button was pressed or released to the moment its packet was received, on the scheduler clock.
+     * The event time is derived from the flic clock at send time, so this covers the time the packet waited on the flic
+     * (connection interval, retransmissions) but not the fixed air and host stack delay, which the host cannot observe.
+     */
+    Radio = 0,
+    /**
+     * Decoding and signature verification of a button event packet, on the monotonic clock.
+     */
+    Verify,
+    /**
+     * From the receipt of the last down or up packet to the click, double click or hold it resolved into, on the scheduler
+     * clock. This is where the double click and hold windows show up.
+     */
+    Classify,
+    /**
+     * From the moment an event was produced on the radio side to its delegate callback, on the monotonic clock. Includes
+     * the event ring and the delegate executor when they are in use.
+     */
+    Deliver,
+};
+
+static const size_t kLatencyStageCount = 4;
+
+const char* latencyStageName(LatencyStage stage);
+
+/*!
+ *  @method monotonicNow
+ *
+ *  @discussion Wall clock time used for the stages that measure work rather than waiting. Unlike the scheduler clock it
+ *              may be read from any thread, and it keeps moving in a simulation running in virtual time.
+ *
+ */
+inline Timestamp monotonicNow()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/*!
+ *  @struct LatencySnapshot
+ *
+ *  @discussion A plain copy of a LatencyHistogram that can be merged, queried and exported.
+ *
+ */
+struct LatencySnapshot
+{
+    static const size_t kBucketCount = 108;
+
+    uint64_t counts[kBucketCount] = {};
+    uint64_t count = 0;
+    Timestamp sum = 0;
+    Timestamp max = 0;
+
+    /*!
+     *  @method percentile:
+     *
+     *  @return The upper bound of the bucket holding the given fraction (0...1) of the samples, capped at
+     *          <code>max</code>. 0 if there are no samples.
+     *
+     */
+    Timestamp percentile(double fraction) const;
+    Timestamp mean() const { return count ? sum / (Timestamp)count : 0; }
+
+    void merge(const LatencySnapshot& other);
+};
+
+/*!
+ *  @class LatencyHistogram
+ *
+ *  @discussion A fixed size log-linear histogram of durations. Buckets are 1 us wide below 4 us and split every power of
+ *              two above that into four, so a bucket is never wider than a quarter of its lower bound. Durations above
+ *              roughly 268 seconds land in the last bucket.
+ *              <br/><br/>
+ *              Recording is a handful of relaxed atomic loads and stores and never allocates. Each histogram has exactly
+ *              one writer, while snapshots may be taken from any thread.
+ *
+ */
+class LatencyHistogram
+{
+public:
+    static const size_t kBucketCount = LatencySnapshot::kBucketCount;
+
+    static size_t bucketIndex(Timestamp duration);
+
+    /*!
+     *  @method bucketUpperBound:
+     *
+     *  @return The exclusive upper bound of the bucket in nanoseconds.
+     *
+     */
+    static Timestamp bucketUpperBound(size_t index);
+
+    LatencyHistogram() = default;
+    LatencyHistogram(const LatencyHistogram&) = delete;
+    LatencyHistogram& operator=(const LatencyHistogram&) = delete;
+
+    void record(Timestamp duration);
+    LatencySnapshot snapshot() const;
+
+private:
+    std::atomic<uint32_t> _counts[kBucketCount] = {};
+    std::atomic<int64_t> _sum { 0 };
+    std::atomic<int64_t> _max { 0 };
+};
+
+/*!
+ *  @class LatencyStats
+ *
+ *  @discussion One histogram per LatencyStage. Every Button keeps one, the radio side stages are written on the scheduler
+ *              that drives the button and the Deliver stage on whichever thread delivers its events.
+ *
+ */
+class LatencyStats
+{
+public:
+    void record(LatencyStage stage, Timestamp duration) { _histograms[(int)stage].record(duration); }
+    const LatencyHistogram& histogram(LatencyStage stage) const { return _histograms[(int)stage]; }
+    LatencySnapshot snapshot(LatencyStage stage) const { return _histograms[(int)stage].snapshot(); }
+
+private:
+    LatencyHistogram _histograms[kLatencyStageCount];
+};
+
+/*!
+ *  @method appendLatencyMetrics:labels:snapshot:output:
+ *
+ *  @discussion Appends one histogram in the Prometheus text exposition format, as metric
+ *              <code>flic_event_latency_seconds</code> with the given label set (e.g. <code>button="B0",stage="radio"</code>).
+ *              Only buckets that hold samples are written, followed by <code>+Inf</code>, the sum and the count. The
+ *              <code># TYPE</code> line is left to the caller so that several histograms can share it.
+ *
+ */
+void appendLatencyMetrics(const std::string& labels, const LatencySnapshot& snapshot, std::string& output);
+
+} // namespace flic
+} // namespace scl
+
+#endif // SCL_FLIC_LATENCY_H
@@ -0,0 +1,736 @@
+//
+//  @file Manager.cpp
+//  @framework fliclib-core
+//
+//  Copyright (c) 2016-2026 Shortcut Labs. All rights reserved.
+//
+
+#include "Manager.h"
+
+#include <algorithm>
+
+namespace scl {
+namespace flic {
+
+const size_t Manager::kDefaultEventRingCapacity;
+const Timestamp Manager::kDefaultJournalFlushInterval;
+const size_t Manager::kEventPoolSize;
+
+static_assert(SCLFlicButtonEventTypeDown == (int)EventType::ButtonDown &&
+                  SCLFlicButtonEventTypeUp == (int)EventType::ButtonUp &&
+                  SCLFlicButtonEventTypeClick == (int)EventType::ButtonClick &&
+                  SCLFlicButtonEventTypeDoubleClick == (int)EventType::ButtonDoubleClick &&
+                  SCLFlicButtonEventTypeHold == (int)EventType::ButtonHold &&
+                  SCLFlicButtonEventTypeProvisionalClick == (int)EventType::ButtonProvisionalClick &&
+                  kEventTypeCount == 6,
+              "SCLFlicButtonEventType must follow EventType");
+
+namespace {
+
+JournalButton journalButton(const Button& button)
+{
+    JournalButton persisted;
+    persisted.info = button.info();
+    persisted.settings = button.settings();
+    persisted.pressCount = (uint32_t)button.pressCount();
+    persisted.wantsConnection = button.wantsConnection();
+    return persisted;
+}
+
+} // namespace
+
+Manager::Manager(Scheduler& scheduler, ManagerDelegate* delegate, ButtonDelegate* defaultButtonDelegate,
+                 Executor* delegateExecutor)
+    : _scheduler(scheduler),
+      _delegateExecutor(delegateExecutor),
+      _delegate(delegate),
+      _defaultButtonDelegate(defaultButtonDelegate),
+      _journalFlushTimer(*this),
+      _connectionScheduler(scheduler)
+{
+    _registry.setObserver(this);
+    if (_delegateExecutor)
+    {
+        enableEventRing(kDefaultEventRingCapacity, OverflowPolicy::Block, [this]
+        {
+            _delegateExecutor->execute([this] { deliverEvents(); });
+        });
+    }
+}
+
+Manager::~Manager()
+{
+    if (_delegateExecutor)
+    {
+        _delegateExecutor->sync();
+    }
+    flushJournal();
+    if (!_ring)
+    {
+        return;
+    }
+    ButtonEventRecord record;
+    while (_ring->pop(record))
+    {
+        if (record.kind == ButtonEventRecord::Kind::Release)
+        {
+            delete record.button;
+        }
+    }
+}
+
+Button* Manager::addButton(const ButtonInfo& info, Transport& transport)
+{
+    if (_registry.withIdentifier(info.identifier) || _dormant.count(info.identifier))
+    {
+        notifyDelegate([this](ManagerDelegate& delegate)
+        {
+            delegate.didGrabButton(*this, nullptr, Error::ButtonAlreadyGrabbed);
+        });
+        return nullptr;
+    }
+
+    Button* button = createButton(info, transport);
+    if (_enabled)
+    {
+        button->connect();
+    }
+    if (_journal)
+    {
+        _journal->recordButton(journalButton(*button));
+    }
+    notifyDelegate([this, button](ManagerDelegate& delegate)
+    {
+        delegate.didGrabButton(*this, button, Error::None);
+    });
+    return button;
+}
+
+Button* Manager::createButton(const ButtonInfo& info, Transport& transport)
+{
+    Button* button = _registry.add(std::unique_ptr<Button>(new Button(info, transport, _scheduler)));
+    button->setDelegate(_defaultButtonDelegate);
+    button->setIndex((uint32_t)_buttonsByIndex.size());
+    _buttonsByIndex.push_back(button);
+    if (_ring || _eventCallback)
+    {
+        button->setEventSink(this);
+    }
+    _connectionScheduler.addButton(*button);
+    return button;
+}
+
+size_t Manager::restoreState(const JournalState& state,
+                             const std::function<Transport*(const ButtonInfo&)>& transportForButton, bool lazily)
+{
+    size_t restored = 0;
+    for (const JournalButton& persisted : state.buttons)
+    {
+        if (_registry.withIdentifier(persisted.info.identifier) || _dormant.count(persisted.info.identifier))
+        {
+            continue;
+        }
+        if (lazily)
+        {
+            _dormant.emplace(persisted.info.identifier, persisted);
+            restored++;
+            continue;
+        }
+        Transport* transport = transportForButton(persisted.info);
+        if (transport)
+        {
+            restoreButton(persisted, *transport);
+            restored++;
+        }
+    }
+    if (!_dormant.empty())
+    {
+        _transportForButton = transportForButton;
+    }
+    notifyDelegate([this](ManagerDelegate& delegate)
+    {
+        delegate.didRestoreState(*this);
+    });
+    return restored;
+}
+
+Button* Manager::restoreButton(const JournalButton& persisted, Transport& transport)
+{
+    // The journal already holds this state, nothing is recorded until the button has been set up.
+    StateJournal* journal = _journal;
+    _journal = nullptr;
+    Button* button = createButton(persisted.info, transport);
+    button->setSettings(persisted.settings);
+    button->restorePressCount((int)persisted.pressCount);
+    if (persisted.wantsConnection && _enabled)
+    {
+        button->connect();
+    }
+    _journal = journal;
+    return button;
+}
+
+Button* Manager::restoreDormantButton(const std::string& identifier)
+{
+    auto it = _dormant.find(identifier);
+    if (it == _dormant.end())
+    {
+        return nullptr;
+    }
+    JournalButton persisted = std::move(it->second);
+    _dormant.erase(it);
+    Transport* transport = _transportForButton(persisted.info);
+    Button* button = transport ? restoreButton(persisted, *transport) : nullptr;
+    if (_dormant.empty())
+    {
+        _transportForButton = nullptr;
+    }
+    return button;
+}
+
+void Manager::restoreDormantButtons()
+{
+    while (!_dormant.empty())
+    {
+        restoreDormantButton(_dormant.begin()->first);
+    }
+}
+
+void Manager::setJournal(StateJournal* journal)
+{
+    flushJournal();
+    _journal = journal;
+    if (!_journal)
+    {
+        return;
+    }
+    for (Button* button : _registry.all())
+    {
+        _journal->recordButton(journalButton(*button));
+    }
+}
+
+void Manager::buttonDidChangeSettings(Button& button)
+{
+    if (_journal)
+    {
+        _journal->recordSettings(button.buttonIdentifier(), button.settings());
+    }
+}
+
+void Manager::buttonDidUpdatePressCount(Button& button)
+{
+    if (_journal)
+    {
+        _journal->recordPressCount(button.buttonIdentifier(), (uint32_t)button.pressCount());
+        if (_journalFlushInterval == 0)
+        {
+            _journal->flush();
+        }
+        else if (!_journalFlushTimer.isScheduled())
+        {
+            _scheduler.schedule(_journalFlushTimer, _scheduler.now() + _journalFlushInterval);
+        }
+    }
+}
+
+void Manager::setJournalFlushInterval(Timestamp interval)
+{
+    _journalFlushInterval = interval;
+    if (interval == 0)
+    {
+        writeJournal();
+    }
+    else if (_journalFlushTimer.isScheduled())
+    {
+        _scheduler.schedule(_journalFlushTimer, std::min(_journalFlushTimer.deadline(), _scheduler.now() + interval));
+    }
+}
+
+void Manager::flushJournal()
+{
+    writeJournal();
+    if (_journal)
+    {
+        _journal->sync();
+    }
+}
+
+void Manager::writeJournal()
+{
+    _scheduler.cancel(_journalFlushTimer);
+    if (_journal)
+    {
+        _journal->flush();
+    }
+}
+
+void Manager::buttonDidChangeWantsConnection(Button& button)
+{
+    if (_journal)
+    {
+        _journal->recordWantsConnection(button.buttonIdentifier(), button.wantsConnection());
+    }
+}
+
+std::unordered_map<std::string, Button*> Manager::knownButtons()
+{
+    restoreDormantButtons();
+    std::unordered_map<std::string, Button*> buttons;
+    for (Button* button : _registry.all())
+    {
+        buttons[button->buttonIdentifier()] = button;
+    }
+    return buttons;
+}
+
+Button* Manager::buttonWithIdentifier(const std::string& identifier)
+{
+    Button* button = _registry.withIdentifier(identifier);
+    return button ? button : restoreDormantButton(identifier);
+}
+
+const ButtonRegistry& Manager::registry()
+{
+    restoreDormantButtons();
+    return _registry;
+}
+
+void Manager::forgetButton(Button& button)
+{
+    std::string identifier = button.buttonIdentifier();
+    if (_registry.withIdentifier(identifier) != &button)
+    {
+        notifyDelegate([this, identifier](ManagerDelegate& delegate)
+        {
+            delegate.didForgetButton(*this, identifier, Error::CouldNotForgetButton);
+        });
+        return;
+    }
+
+    if (_journal)
+    {
+        _journal->recordRemoved(identifier);
+    }
+    _connectionScheduler.removeButton(button);
+    button.disconnect();
+    std::unique_ptr<Button> forgotten = _registry.remove(button);
+    _buttonsByIndex[button.index()] = nullptr;
+    cancelRSSIReads(button);
+    if (_ring)
+    {
+        // Records of this button may still be in the ring, the consumer frees it once it gets to them.
+        forgotten->invalidate();
+        ButtonEventRecord record;
+        record.button = forgotten.release();
+        record.kind = ButtonEventRecord::Kind::Release;
+        pushRecord(record, OverflowPolicy::Block);
+    }
+    notifyDelegate([this, identifier](ManagerDelegate& delegate)
+    {
+        delegate.didForgetButton(*this, identifier, Error::None);
+    });
+}
+
+Button* Manager::buttonAtIndex(uint32_t index) const
+{
+    return index < _buttonsByIndex.size() ? _buttonsByIndex[index] : nullptr;
+}
+
+uint32_t Manager::readRSSI(ButtonView buttons)
+{
+    RSSIReadRequest request;
+    request.id = _nextRSSIRequest++;
+    request.readings.resize(buttons.size());
+    request.pending.resize(_buttonsByIndex.size());
+    Timestamp now = _scheduler.now();
+    for (size_t i = 0; i < buttons.size(); i++)
+    {
+        Button* button = buttons[i];
+        request.readings[i].button = button;
+        if (button->connectionState() != ConnectionState::Connected)
+        {
+            request.readings[i].error = Error::CouldNotUpdateRSSI;
+            continue;
+        }
+        uint32_t& pending = request.pending[button->index()];
+        if (pending != 0)
+        {
+            request.duplicates.emplace_back(i, pending - 1);
+            continue;
+        }
+        pending = (uint32_t)i + 1;
+        request.remaining++;
+        if (_rssiReadWindow != 0)
+        {
+            _rssiReadSchedule.emplace_back(now + button->untilNextConnectionEvent(), button->index());
+            std::push_heap(_rssiReadSchedule.begin(), _rssiReadSchedule.end(),
+                           std::greater<std::pair<Timestamp, uint32_t>>());
+        }
+    }
+
+    uint32_t id = request.id;
+    bool completes = request.remaining == 0;
+    _rssiRequests.push_back(std::move(request));
+    // Without a window there is nothing to wait for, every reading is asked for right away.
+    if (_rssiReadWindow == 0)
+    {
+        for (Button* button : buttons)
+        {
+            if (!button->isReadingRSSIForObserver() && isRSSIReadPending(button->index()))
+            {
+                _rssiReadsOutstanding++;
+                button->readRSSIForObserver();
+            }
+        }
+    }
+    if (completes || !_rssiReadSchedule.empty())
+    {
+        pumpRSSIReads();
+    }
+    return id;
+}
+
+void Manager::setRSSIReadWindow(size_t window)
+{
+    _rssiReadWindow = window;
+    pumpRSSIReads();
+}
+
+void Manager::pumpRSSIReads()
+{
+    // Readings that come back right away and delegates that ask for more land here again, the loop below picks them up.
+    if (_pumpingRSSIReads)
+    {
+        return;
+    }
+    _pumpingRSSIReads = true;
+    std::greater<std::pair<Timestamp, uint32_t>> later;
+    bool completed = true;
+    while (completed)
+    {
+        while (!_rssiReadSchedule.empty() && (_rssiReadWindow == 0 || _rssiReadsOutstanding < _rssiReadWindow))
+        {
+            std::pop_heap(_rssiReadSchedule.begin(), _rssiReadSchedule.end(), later);
+            std::pair<Timestamp, uint32_t> next = _rssiReadSchedule.back();
+            _rssiReadSchedule.pop_back();
+            Button* button = buttonAtIndex(next.second);
+            // Entries of buttons that were forgotten, have their reading or have one on its way are dropped here.
+            if (!button || button->isReadingRSSIForObserver() || !isRSSIReadPending(next.second))
+            {
+                continue;
+            }
+            // While the place waited the connection event went by, the button goes back in line behind its next one.
+            Timestamp now = _scheduler.now();
+            if (next.first < now)
+            {
+                _rssiReadSchedule.emplace_back(now + button->untilNextConnectionEvent(), next.second);
+                std::push_heap(_rssiReadSchedule.begin(), _rssiReadSchedule.end(), later);
+                continue;
+            }
+            _rssiReadsOutstanding++;
+            button->readRSSIForObserver();
+        }
+
+        completed = false;
+        for (size_t i = 0; i < _rssiRequests.size();)
+        {
+            RSSIReadRequest& request = _rssiRequests[i];
+            if (request.remaining > 0)
+            {
+                i++;
+                continue;
+            }
+            for (const std::pair<size_t, size_t>& duplicate : request.duplicates)
+            {
+                request.readings[duplicate.first] = request.readings[duplicate.second];
+            }
+            uint32_t id = request.id;
+            std::vector<RSSIReading> readings = std::move(request.readings);
+            _rssiRequests.erase(_rssiRequests.begin() + (ptrdiff_t)i);
+            notifyDelegate([this, id, readings = std::move(readings)](ManagerDelegate& delegate)
+            {
+                delegate.didReadRSSI(*this, id, readings.data(), readings.size());
+            });
+            completed = true;
+        }
+    }
+    if (_rssiRequests.empty())
+    {
+        _rssiReadSchedule.clear();
+    }
+    _pumpingRSSIReads = false;
+}
+
+bool Manager::isRSSIReadPending(uint32_t index) const
+{
+    for (const RSSIReadRequest& request : _rssiRequests)
+    {
+        if (index < request.pending.size() && request.pending[index] != 0)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+void Manager::buttonDidReadRSSI(Button& button, int rssi, Error error)
+{
+    if (_rssiReadsOutstanding > 0)
+    {
+        _rssiReadsOutstanding--;
+    }
+    uint32_t index = button.index();
+    bool completes = false;
+    for (RSSIReadRequest& request : _rssiRequests)
+    {
+        if (index >= request.pending.size() || request.pending[index] == 0)
+        {
+            continue;
+        }
+        RSSIReading& reading = request.readings[request.pending[index] - 1];
+        reading.rssi = rssi;
+        reading.error = error;
+        request.pending[index] = 0;
+        completes |= --request.remaining == 0;
+    }
+    // The next reading in line takes the place of this one.
+    if (completes || !_rssiReadSchedule.empty())
+    {
+        pumpRSSIReads();
+    }
+}
+
+void Manager::cancelRSSIReads(Button& button)
+{
+    // The button no longer reports to the manager, a reading on its way is given up.
+    if (button.isReadingRSSIForObserver() && _rssiReadsOutstanding > 0)
+    {
+        _rssiReadsOutstanding--;
+    }
+    uint32_t index = button.index();
+    for (RSSIReadRequest& request : _rssiRequests)
+    {
+        if (index < request.pending.size() && request.pending[index] != 0)
+        {
+            request.readings[request.pending[index] - 1].error = Error::CouldNotUpdateRSSI;
+            request.pending[index] = 0;
+            request.remaining--;
+        }
+    }
+    pumpRSSIReads();
+}
+
+void Manager::notifyDelegate(std::function<void(ManagerDelegate&)> callback)
+{
+    if (!_delegateExecutor)
+    {
+        if (_delegate)
+        {
+            callback(*_delegate);
+        }
+        return;
+    }
+    _delegateExecutor->execute([this, callback = std::move(callback)]
+    {
+        if (_delegate)
+        {
+            callback(*_delegate);
+        }
+    });
+}
+
+void Manager::disable()
+{
+    _enabled = false;
+    for (Button* button : _registry.all())
+    {
+        button->disconnect();
+    }
+}
+
+void Manager::enable()
+{
+    _enabled = true;
+}
+
+void Manager::enableEventRing(size_t capacity, OverflowPolicy policy, std::function<void()> wakeup)
+{
+    if (_ring)
+    {
+        return;
+    }
+    _ring.reset(new EventRing<ButtonEventRecord>(capacity, policy));
+    _wakeup = std::move(wakeup);
+    for (Button* button : _registry.all())
+    {
+        button->setEventSink(this);
+    }
+}
+
+void Manager::setEventCallback(EventCallback callback, void* context)
+{
+    _eventCallback = callback;
+    _eventCallbackContext = context;
+    if (_ring)
+    {
+        return;
+    }
+    // Without a ring the manager only takes the records of the buttons to hand their events to the callback.
+    for (Button* button : _registry.all())
+    {
+        button->setEventSink(callback ? this : nullptr);
+    }
+}
+
+void Manager::poolEvent(const ButtonEventRecord& record)
+{
+    record.button->recordDeliveryLatency(record);
+    ButtonEventNotification& event = _eventPool[_pooledEvents++];
+    event.buttonIndex = record.button->index();
+    event.type = (uint8_t)record.type;
+    event.queued = record.queued ? 1 : 0;
+    event.sequence = record.sequence;
+    event.buttonTicks = record.time.buttonTicks;
+    event.eventTime = record.time.eventTime;
+    event.receivedTime = record.time.receivedTime;
+    if (_pooledEvents == kEventPoolSize)
+    {
+        flushEventPool();
+    }
+}
+
+void Manager::flushEventPool()
+{
+    if (_pooledEvents == 0)
+    {
+        return;
+    }
+    size_t count = _pooledEvents;
+    _pooledEvents = 0;
+    if (_eventCallback)
+    {
+        _eventCallback(_eventCallbackContext, _eventPool, count);
+    }
+}
+
+void Manager::buttonDidProduceEvent(const ButtonEventRecord& record)
+{
+    if (!_ring)
+    {
+        if (record.kind == ButtonEventRecord::Kind::Event)
+        {
+            poolEvent(record);
+            flushEventPool();
+        }
+        else
+        {
+            record.button->deliver(record);
+        }
+        return;
+    }
+
+    // Only button events are subject to the overflow policy, losing the end of a queued batch would hold back the batch.
+    pushRecord(record, record.kind == ButtonEventRecord::Kind::Event ? _ring->policy() : OverflowPolicy::Block);
+}
+
+void Manager::pushRecord(const ButtonEventRecord& record, OverflowPolicy policy)
+{
+    // On the thread of the executor the consumer cannot run before this returns, so blocking would never end. It is the
+    // only thread that delivers, so the waiting records can be delivered right here.
+    if (_ring->full() && _delegateExecutor && _delegateExecutor->runsOnCurrentThread())
+    {
+        deliverEvents();
+    }
+    if (_ring->push(record, policy))
+    {
+        wakeConsumer();
+    }
+}
+
+void Manager::wakeConsumer()
+{
+    if (_consumerIdle.exchange(false) && _wakeup)
+    {
+        _wakeup();
+    }
+}
+
+size_t Manager::deliverEvents(size_t limit)
+{
+    if (!_ring)
+    {
+        return 0;
+    }
+    size_t delivered = 0;
+    ButtonEventRecord record;
+    while (true)
+    {
+        while (delivered < limit && _ring->pop(record))
+        {
+            delivered++;
+            if (record.kind == ButtonEventRecord::Kind::Event && _eventCallback)
+            {
+                poolEvent(record);
+                continue;
+            }
+            // The events pooled so far go first, to keep them in order with the other callbacks.
+            flushEventPool();
+            if (record.kind == ButtonEventRecord::Kind::Release)
+            {
+                delete record.button;
+            }
+            else
+            {
+                record.button->deliver(record);
+            }
+        }
+        flushEventPool();
+        if (delivered >= limit)
+        {
+            // Still busy, the caller is expected to come back without a wakeup.
+            return delivered;
+        }
+
+        // Going idle. A producer that pushed after the last pop either sees the flag and wakes us, or already cleared it
+        // and we keep going.
+        _consumerIdle.store(true);
+        if (_ring->empty() || !_consumerIdle.exchange(false))
+        {
+            return delivered;
+        }
+    }
+}
+
+EventRingCounters Manager::eventRingCounters() const
+{
+    return _ring ? _ring->counters() : EventRingCounters();
+}
+
+LatencySnapshot Manager::latencySnapshot(LatencyStage stage) const
+{
+    LatencySnapshot merged;
+    for (Button* button : _registry.all())
+    {
+        merged.merge(button->latencyStats().snapshot(stage));
+    }
+    return merged;
+}
+
+std::string Manager::exportLatencyMetrics() const
+{
+    std::string output = "# TYPE flic_event_latency_seconds histogram\n";
+    for (Button* button : _registry.all())
+    {
+        for (size_t stage = 0; stage < kLatencyStageCount; stage++)
+        {
+            std::string labels = "button=\"" + button->buttonIdentifier() + "\",stage=\"" +
+                                 latencyStageName((LatencyStage)stage) + "\"";
+            appendLatencyMetrics(labels, button->latencyStats().snapshot((LatencyStage)stage), output);
+        }
+    }
+    return output;
+}
+
+} // namespace flic
+} // namespace scl
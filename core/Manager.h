@@ -0,0 +1,466 @@
+//
+//  @file Manager.h
+//  @framework fliclib-core
+//
+//  Copyright (c) 2016-2026 Shortcut Labs. All rights reserved.
+//
+
+#ifndef SCL_FLIC_MANAGER_H
+#define SCL_FLIC_MANAGER_H
+
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "Button.h"
+#include "ButtonRegistry.h"
+#include "ConnectionScheduler.h"
+#include "EventCallback.h"
+#include "EventRing.h"
+#include "Executor.h"
+#include "Journal.h"
+
+namespace scl {
+namespace flic {
+
+class Manager;
+
+/*!
+ *  @struct RSSIReading
+ *
+ *  @discussion One result of Manager::readRSSI. <code>button</code> identifies the button the reading was asked for and
+ *              must not be used if the button has been forgotten since.
+ *
+ */
+struct RSSIReading
+{
+    Button* button = nullptr;
+    int rssi = 0;
+    Error error = Error::None;
+};
+
+/*!
+ *  @typedef ButtonEventNotification
+ *
+ *  @discussion A button event as handed to an EventCallback, the C struct SCLFlicButtonEventNotification of
+ *              EventCallback.h.
+ *
+ */
+typedef SCLFlicButtonEventNotification ButtonEventNotification;
+
+/*!
+ *  @typedef EventCallback
+ *
+ *  @discussion The C function pointer type SCLFlicEventCallback of EventCallback.h.
+ *
+ */
+typedef SCLFlicEventCallback EventCallback;
+
+/*!
+ *  @protocol ManagerDelegate
+ *
+ *  @discussion The C++ counterpart of SCLFlicManagerDelegate.
+ *
+ */
+class ManagerDelegate
+{
+public:
+    virtual ~ManagerDelegate() = default;
+
+    virtual void didGrabButton(Manager& manager, Button* button, Error error) {}
+    virtual void didForgetButton(Manager& manager, const std::string& buttonIdentifier, Error error) {}
+
+    /*!
+     *  @method didRestoreState:
+     *
+     *  @discussion Counterpart of <code>flicManagerDidRestoreState:</code>, called once Manager::restoreState has created
+     *              the restored buttons.
+     *
+     */
+    virtual void didRestoreState(Manager& manager) {}
+
+    /*!
+     *  @method didReadRSSI:request:readings:count:
+     *
+     *  @discussion Completes a Manager::readRSSI with one reading per button, in the order the buttons were given. The
+     *              array is only valid for the duration of the callback.
+     *
+     */
+    virtual void didReadRSSI(Manager& manager, uint32_t request, const RSSIReading* readings, size_t count) {}
+};
+
+/*!
+ *  @class Manager
+ *
+ *  @discussion The core behind SCLFlicManager. It owns the Button instances, hands them the default delegate and keeps
+ *              track of which of them should have a pending connection, sharing a limited number of connection slots
+ *              between them if asked to.
+ *
+ */
+class Manager : private ButtonEventSink, private ButtonStateObserver
+{
+public:
+    static const size_t kDefaultEventRingCapacity = 1024;
+    static const Timestamp kDefaultJournalFlushInterval = 2 * kNanosPerSecond;
+    static const size_t kEventPoolSize = 64;
+
+    /*!
+     *  @method Manager:delegate:defaultButtonDelegate:delegateExecutor:
+     *
+     *  @discussion Counterpart of <code>configureWithDelegate:defaultButtonDelegate:appID:appSecret:backgroundExecution:</code>.
+     *              <br/><br/>
+     *              Without a <code>delegateExecutor</code> all delegate callbacks are made directly on the scheduler that
+     *              drives the buttons. With one, every manager and button delegate callback is delivered on that executor
+     *              instead: button callbacks travel through an event ring of <code>kDefaultEventRingCapacity</code> that
+     *              blocks when full, and the executor is only given one task per burst of events.
+     *              <br/><br/>
+     *              A full ring holds up the scheduler until the executor has caught up. When the executor runs its tasks
+     *              on the scheduler thread, see Executor::runsOnCurrentThread, the manager delivers the waiting callbacks
+     *              right there instead, which may nest them inside a delegate callback that is producing events. An
+     *              executor on another thread whose tasks wait for the scheduler thread deadlocks on a full ring, so
+     *              delegate callbacks must never block on the scheduler.
+     *              <br/><br/>
+     *              The executor must outlive the manager. The destructor calls Executor::sync, so that no task of the
+     *              manager is left to run once it is gone, and must not be called from a delegate callback.
+     *
+     */
+    Manager(Scheduler& scheduler, ManagerDelegate* delegate, ButtonDelegate* defaultButtonDelegate,
+            Executor* delegateExecutor = nullptr);
+    ~Manager();
+
+    Manager(const Manager&) = delete;
+    Manager& operator=(const Manager&) = delete;
+
+    ManagerDelegate* delegate() const { return _delegate; }
+    void setDelegate(ManagerDelegate* delegate) { _delegate = delegate; }
+
+    ButtonDelegate* defaultButtonDelegate() const { return _defaultButtonDelegate; }
+    void setDefaultButtonDelegate(ButtonDelegate* delegate) { _defaultButtonDelegate = delegate; }
+
+    /*!
+     *  @method addButton:transport:
+     *
+     *  @discussion Creates the Button for a grabbed flic and connects it, like a successful grab from the Flic app. The
+     *              result is reported through ManagerDelegate::didGrabButton as well as returned.
+     *
+     *  @return     The new button, or nullptr with <code>Error::ButtonAlreadyGrabbed</code> reported if a button with the
+     *              same identifier is already known.
+     *
+     */
+    Button* addButton(const ButtonInfo& info, Transport& transport);
+
+    /*!
+     *  @method knownButtons
+     *
+     *  @return A map of all buttons that have not been forgotten, keyed by buttonIdentifier. The map is built on every
+     *          call, <code>registry</code> offers the same buttons without copying. Restores any dormant buttons first.
+     *
+     */
+    std::unordered_map<std::string, Button*> knownButtons();
+
+    /*!
+     *  @method buttonWithIdentifier:
+     *
+     *  @discussion Restores the button first if it is dormant. This is how the platform layer hands a button its first
+     *              connection or event after a lazy restoration.
+     *
+     */
+    Button* buttonWithIdentifier(const std::string& identifier);
+
+    /*!
+     *  @property registry
+     *
+     *  @discussion All buttons that have not been forgotten, indexed by identifier, public key, user assigned name and
+     *              connection state. Restores any dormant buttons first.
+     *
+     */
+    const ButtonRegistry& registry();
+
+    void forgetButton(Button& button);
+
+    /*!
+     *  @method buttonAtIndex:
+     *
+     *  @return The button with the given Button::index, or nullptr if it has been forgotten. Indexes are handed out in the
+     *          order the buttons are created and are not reused for the lifetime of the manager.
+     *
+     */
+    Button* buttonAtIndex(uint32_t index) const;
+
+    /*!
+     *  @method restoreState:transportForButton:lazily:
+     *
+     *  @discussion Creates the buttons of a journal loaded with StateJournal::open, with their settings, press count and
+     *              pending connection as they were persisted, then calls ManagerDelegate::didRestoreState. Buttons that
+     *              are already known, or for which <code>transportForButton</code> returns nullptr, are skipped. Nothing
+     *              is written to the journal while restoring.
+     *              <br/><br/>
+     *              With <code>lazily</code> the buttons are left dormant instead and didRestoreState is called right
+     *              away. A dormant button is only created, and asks for its transport and reconnects, once it is looked
+     *              up through <code>buttonWithIdentifier</code>, typically because the system woke the app for it, or when
+     *              <code>knownButtons</code>, <code>registry</code> or <code>restoreDormantButtons</code> is called. In
+     *              that case <code>transportForButton</code> is kept until then.
+     *
+     *  @return The number of buttons that were created or left dormant.
+     *
+     */
+    size_t restoreState(const JournalState& state, const std::function<Transport*(const ButtonInfo&)>& transportForButton,
+                        bool lazily = false);
+
+    /*!
+     *  @method restoreDormantButtons
+     *
+     *  @discussion Creates every button that is still dormant after a lazy restoration.
+     *
+     */
+    void restoreDormantButtons();
+    size_t dormantButtonCount() const { return _dormant.size(); }
+    bool isDormant(const std::string& identifier) const { return _dormant.count(identifier) != 0; }
+
+    /*!
+     *  @property journal
+     *
+     *  @discussion When set, every added or forgotten button and every change of the settings, press count or pending
+     *              connection of a known button is recorded in the journal. Attaching a journal records the current state
+     *              of all known buttons, only what differs from what the journal holds is written. Buttons the journal
+     *              knows but the manager does not are left alone. The journal must stay open while attached.
+     *              <br/><br/>
+     *              Press counts, which change with every button event, are coalesced by the journal and flushed once
+     *              <code>journalFlushInterval</code> after the first change since the last flush, so a burst of clicks
+     *              costs one write. Detaching the journal or destroying the manager flushes it.
+     *
+     */
+    StateJournal* journal() const { return _journal; }
+    void setJournal(StateJournal* journal);
+
+    /*!
+     *  @property journalFlushInterval
+     *
+     *  @discussion The longest a press count stays unwritten, <code>kDefaultJournalFlushInterval</code> by default. 0
+     *              writes every change as it happens.
+     *
+     */
+    Timestamp journalFlushInterval() const { return _journalFlushInterval; }
+    void setJournalFlushInterval(Timestamp interval);
+
+    /*!
+     *  @method flushJournal
+     *
+     *  @discussion Writes the pending press counts now and forces the journal to storage with StateJournal::sync. Call
+     *              it when the app moves to the background or is about to be suspended, so nothing is left to a timer
+     *              that may not get to run. The manager does the same when the journal is detached and when the manager
+     *              is destroyed. In between, changes are only handed to the operating system, and the flushes of the
+     *              <code>journalFlushInterval</code> timer do not sync.
+     *
+     */
+    void flushJournal();
+
+    /*!
+     *  @method disable
+     *
+     *  @discussion Disconnects all buttons and cancels their pending connections until <code>enable</code> is called.
+     *
+     */
+    void disable();
+    void enable();
+    bool isEnabled() const { return _enabled; }
+
+    /*!
+     *  @property connectionSlots
+     *
+     *  @discussion The number of buttons that may have a link or pending connection at the same time, 0 (the default)
+     *              for no limit. Set it to stay below the platform connection limit with many buttons, see
+     *              ConnectionScheduler for how the slots are shared.
+     *
+     */
+    size_t connectionSlots() const { return _connectionScheduler.slots(); }
+    void setConnectionSlots(size_t slots) { _connectionScheduler.setSlots(slots); }
+
+    const ConnectionSchedulerParameters& connectionSchedulerParameters() const { return _connectionScheduler.parameters(); }
+    void setConnectionSchedulerParameters(const ConnectionSchedulerParameters& parameters)
+    {
+        _connectionScheduler.setParameters(parameters);
+    }
+
+    ConnectionSlotStats connectionSlotStats() const { return _connectionScheduler.stats(); }
+
+    /*!
+     *  @method readRSSI:
+     *
+     *  @discussion Reads the RSSI of all the given buttons as one request, e.g.
+     *              <code>readRSSI(registry().withConnectionState(ConnectionState::Connected))</code>, and reports the
+     *              readings together through ManagerDelegate::didReadRSSI instead of one ButtonDelegate callback each.
+     *              Buttons that are not connected get <code>Error::CouldNotUpdateRSSI</code> without touching the
+     *              radio. The others are asked in the order their next connection events come up, so that within the
+     *              <code>rssiReadWindow</code> a place goes to the reading that will be in soonest. Requests overlap: a
+     *              reading counts for every request still waiting for that button, so a button that already has a
+     *              reading on its way shares it. Apart from setting up a request nothing is allocated per reading.
+     *              <br/><br/>
+     *              When none of the buttons needs the radio the request completes right away: without a delegate
+     *              executor didReadRSSI is called before this returns, with one it has been handed to the executor.
+     *
+     *  @return The request, handed back with the readings.
+     *
+     */
+    uint32_t readRSSI(ButtonView buttons);
+
+    /*!
+     *  @property rssiReadWindow
+     *
+     *  @discussion The most readings of readRSSI requests that are asked for at the same time, 0 (the default) for no
+     *              limit. Set it for a platform that queues link commands and gets slow with many of them outstanding.
+     *
+     */
+    size_t rssiReadWindow() const { return _rssiReadWindow; }
+    void setRSSIReadWindow(size_t window);
+
+    Scheduler& scheduler() const { return _scheduler; }
+    Executor* delegateExecutor() const { return _delegateExecutor; }
+
+    /*!
+     *  @method enableEventRing:policy:wakeup:
+     *
+     *  @discussion Routes the button events of all buttons through a bounded single-producer/single-consumer ring. Events
+     *              are pushed on the scheduler that drives the buttons and only reach the button delegates when
+     *              <code>deliverEvents</code> is called, typically from another thread. <code>wakeup</code> is called on
+     *              the producer side whenever events become available while the consumer is idle, so the consumer is
+     *              woken once per burst rather than once per event. Can only be enabled once.
+     *
+     */
+    void enableEventRing(size_t capacity, OverflowPolicy policy, std::function<void()> wakeup);
+    bool hasEventRing() const { return _ring != nullptr; }
+
+    /*!
+     *  @method deliverEvents:
+     *
+     *  @discussion Consumer side of the event ring. Delivers up to <code>limit</code> events to the button delegates.
+     *
+     *  @return The number of records taken from the ring.
+     *
+     */
+    size_t deliverEvents(size_t limit = SIZE_MAX);
+
+    EventRingCounters eventRingCounters() const;
+
+    /*!
+     *  @method setEventCallback:context:
+     *
+     *  @discussion Hands the button events of all buttons to <code>callback</code> instead of their delegates, as
+     *              ButtonEventNotification values copied into a pool of <code>kEventPoolSize</code> that the manager
+     *              holds, so delivering an event never allocates. Connection, RSSI and all other callbacks still go to the
+     *              delegates, in order with the events. The callback is made where the delegate callbacks would be: right
+     *              away with one event per call on the scheduler, or from <code>deliverEvents</code> with every event
+     *              taken from the ring in one pass, up to the size of the pool per call. Queued events are never collected
+     *              into a QueuedEventBatch, the <code>queued</code> flag tells them apart. nullptr goes back to the
+     *              delegates.
+     *              <br/><br/>
+     *              With an event ring the callback must be set before the buttons produce events.
+     *
+     */
+    void setEventCallback(EventCallback callback, void* context);
+    EventCallback eventCallback() const { return _eventCallback; }
+
+    /*!
+     *  @method latencySnapshot:
+     *
+     *  @discussion The given stage merged across all known buttons. Per button histograms are available through
+     *              Button::latencyStats.
+     *
+     */
+    LatencySnapshot latencySnapshot(LatencyStage stage) const;
+
+    /*!
+     *  @method exportLatencyMetrics
+     *
+     *  @return The latency histograms of all known buttons in the Prometheus text exposition format, one
+     *          <code>flic_event_latency_seconds</code> histogram per button and stage labelled with <code>button</code>
+     *          and <code>stage</code>.
+     *
+     */
+    std::string exportLatencyMetrics() const;
+
+private:
+    class JournalFlushTimer : public Timer
+    {
+    public:
+        explicit JournalFlushTimer(Manager& manager) : _manager(manager) {}
+        void fire() override { _manager.writeJournal(); }
+
+    private:
+        Manager& _manager;
+    };
+
+    struct RSSIReadRequest
+    {
+        uint32_t id = 0;
+        std::vector<RSSIReading> readings;
+        /** Per button index, one plus the index of the reading still to come for that button, 0 for none. */
+        std::vector<uint32_t> pending;
+        size_t remaining = 0;
+        /** Buttons given more than once are read once, as the index of a reading and the index it is copied from. */
+        std::vector<std::pair<size_t, size_t>> duplicates;
+    };
+
+    void writeJournal();
+    Button* createButton(const ButtonInfo& info, Transport& transport);
+    Button* restoreButton(const JournalButton& persisted, Transport& transport);
+    Button* restoreDormantButton(const std::string& identifier);
+
+    // ButtonStateObserver
+    void buttonDidChangeConnectionState(Button& button, ConnectionState previous) override {}
+    void buttonDidChangeSettings(Button& button) override;
+    void buttonDidUpdatePressCount(Button& button) override;
+    void buttonDidChangeWantsConnection(Button& button) override;
+    void buttonDidReadRSSI(Button& button, int rssi, Error error) override;
+
+    void pumpRSSIReads();
+    bool isRSSIReadPending(uint32_t index) const;
+    void cancelRSSIReads(Button& button);
+    void buttonDidProduceEvent(const ButtonEventRecord& record) override;
+    void pushRecord(const ButtonEventRecord& record, OverflowPolicy policy);
+    void wakeConsumer();
+    void poolEvent(const ButtonEventRecord& record);
+    void flushEventPool();
+    void notifyDelegate(std::function<void(ManagerDelegate&)> callback);
+
+    Scheduler& _scheduler;
+    Executor* _delegateExecutor;
+    ManagerDelegate* _delegate;
+    ButtonDelegate* _defaultButtonDelegate;
+    bool _enabled = true;
+    StateJournal* _journal = nullptr;
+    Timestamp _journalFlushInterval = kDefaultJournalFlushInterval;
+    JournalFlushTimer _journalFlushTimer;
+
+    ButtonRegistry _registry;
+    std::vector<Button*> _buttonsByIndex;
+    std::unordered_map<std::string, JournalButton> _dormant;
+    std::function<Transport*(const ButtonInfo&)> _transportForButton;
+    ConnectionScheduler _connectionScheduler;
+
+    std::deque<RSSIReadRequest> _rssiRequests;
+    /** Min-heap of the buttons to read by when their next connection event was due, as of when it was looked up. */
+    std::vector<std::pair<Timestamp, uint32_t>> _rssiReadSchedule;
+    size_t _rssiReadsOutstanding = 0;
+    size_t _rssiReadWindow = 0;
+    uint32_t _nextRSSIRequest = 1;
+    bool _pumpingRSSIReads = false;
+
+    std::unique_ptr<EventRing<ButtonEventRecord>> _ring;
+    std::function<void()> _wakeup;
+    std::atomic<bool> _consumerIdle { true };
+
+    EventCallback _eventCallback = nullptr;
+    void* _eventCallbackContext = nullptr;
+    ButtonEventNotification _eventPool[kEventPoolSize];
+    size_t _pooledEvents = 0;
+};
+
+} // namespace flic
+} // namespace scl
+
+#endif // SCL_FLIC_MANAGER_H
@@ -0,0 +1,394 @@
+//
+//  @file Packet.cpp
+//  @framework fliclib-core
+//
+//  Copyright (c) 2016-2026 Shortcut Labs. All rights reserved.
+//
+
+#include "Packet.h"
+
+#include <cstring>
+
+namespace scl {
+namespace flic {
+
+namespace {
+
+const uint8_t kEventFlagDown = 0x01;
+const uint8_t kEventFlagQueued = 0x02;
+const uint8_t kEventFlagAckRequested = 0x04;
+
+const uint8_t kLabelProof = 'V';
+const uint8_t kLabelSessionKey = 'S';
+const uint8_t kLabelTicketId = 'T';
+const uint8_t kLabelResumptionSecret = 'R';
+
+inline void put24(uint8_t* p, uint32_t value)
+{
+    p[0] = (uint8_t)value;
+    p[1] = (uint8_t)(value >> 8);
+    p[2] = (uint8_t)(value >> 16);
+}
+
+inline void put32(uint8_t* p, uint32_t value)
+{
+    put24(p, value);
+    p[3] = (uint8_t)(value >> 24);
+}
+
+inline uint32_t get24(const uint8_t* p)
+{
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16);
+}
+
+inline uint32_t get32(const uint8_t* p)
+{
+    return get24(p) | ((uint32_t)p[3] << 24);
+}
+
+// Body sizes, i.e. without the signature.
+size_t bodySize(Opcode opcode)
+{
+    switch (opcode)
+    {
+        case Opcode::VerifyRequest:
+            return 1 + kNonceSize;
+        case Opcode::IndicateLED:
+            return 2;
+        case Opcode::EventAck:
+            return 4;
+        case Opcode::ResumeRequest:
+            return 1 + kTicketIdSize + kNonceSize;
+        case Opcode::VerifyResponse:
+            return 1 + kNonceSize + kProofSize;
+        case Opcode::ButtonEvent:
+            return 13;
+        case Opcode::QueueDrained:
+            return 1;
+        case Opcode::ResumeResponse:
+            return 2 + kNonceSize;
+        case Opcode::ResumeRejected:
+            return 1;
+    }
+    return 0;
+}
+
+bool isKnownOpcode(uint8_t value)
+{
+    switch ((Opcode)value)
+    {
+        case Opcode::VerifyRequest:
+        case Opcode::IndicateLED:
+        case Opcode::EventAck:
+        case Opcode::ResumeRequest:
+        case Opcode::VerifyResponse:
+        case Opcode::ButtonEvent:
+        case Opcode::QueueDrained:
+        case Opcode::ResumeResponse:
+        case Opcode::ResumeRejected:
+            return true;
+    }
+    return false;
+}
+
+void handshakeMac(const ChaskeyKey& key, uint8_t label, const uint8_t hostNonce[kNonceSize],
+                  const uint8_t buttonNonce[kNonceSize], uint8_t* out, size_t outSize)
+{
+    uint8_t message[1 + 2 * kNonceSize];
+    message[0] = label;
+    memcpy(message + 1, hostNonce, kNonceSize);
+    memcpy(message + 1 + kNonceSize, buttonNonce, kNonceSize);
+    key.mac(message, sizeof(message), out, outSize);
+}
+
+} // namespace
+
+bool isSignedOpcode(Opcode opcode)
+{
+    switch (opcode)
+    {
+        case Opcode::VerifyRequest:
+        case Opcode::VerifyResponse:
+        case Opcode::ResumeRequest:
+        case Opcode::ResumeRejected:
+            return false;
+        default:
+            return true;
+    }
+}
+
+void encodeVerifyRequest(Packet& packet, const uint8_t hostNonce[kNonceSize], uint8_t ackWindow)
+{
+    packet.bytes[0] = (uint8_t)Opcode::VerifyRequest;
+    memcpy(packet.bytes + 1, hostNonce, kNonceSize);
+    packet.size = (uint8_t)bodySize(Opcode::VerifyRequest);
+    if (ackWindow > 1)
+    {
+        packet.bytes[packet.size++] = ackWindow;
+    }
+}
+
+void encodeVerifyResponse(Packet& packet, const uint8_t buttonNonce[kNonceSize], const uint8_t proof[kProofSize],
+                          uint8_t ackWindow)
+{
+    packet.bytes[0] = (uint8_t)Opcode::VerifyResponse;
+    memcpy(packet.bytes + 1, buttonNonce, kNonceSize);
+    memcpy(packet.bytes + 1 + kNonceSize, proof, kProofSize);
+    packet.size = (uint8_t)bodySize(Opcode::VerifyResponse);
+    if (ackWindow > 1)
+    {
+        packet.bytes[packet.size++] = ackWindow;
+    }
+}
+
+void encodeResumeRequest(Packet& packet, const uint8_t ticketId[kTicketIdSize], const uint8_t hostNonce[kNonceSize],
+                         uint8_t ackWindow)
+{
+    packet.bytes[0] = (uint8_t)Opcode::ResumeRequest;
+    memcpy(packet.bytes + 1, ticketId, kTicketIdSize);
+    memcpy(packet.bytes + 1 + kTicketIdSize, hostNonce, kNonceSize);
+    packet.size = (uint8_t)bodySize(Opcode::ResumeRequest);
+    if (ackWindow > 1)
+    {
+        packet.bytes[packet.size++] = ackWindow;
+    }
+}
+
+void encodeResumeResponse(Packet& packet, const uint8_t buttonNonce[kNonceSize], uint8_t ackWindow)
+{
+    packet.bytes[0] = (uint8_t)Opcode::ResumeResponse;
+    packet.bytes[1] = ackWindow;
+    memcpy(packet.bytes + 2, buttonNonce, kNonceSize);
+    packet.size = (uint8_t)bodySize(Opcode::ResumeResponse);
+}
+
+void encodeResumeRejected(Packet& packet)
+{
+    packet.bytes[0] = (uint8_t)Opcode::ResumeRejected;
+    packet.size = (uint8_t)bodySize(Opcode::ResumeRejected);
+}
+
+void encodeIndicateLED(Packet& packet, uint8_t count)
+{
+    packet.bytes[0] = (uint8_t)Opcode::IndicateLED;
+    packet.bytes[1] = count;
+    packet.size = (uint8_t)bodySize(Opcode::IndicateLED);
+}
+
+void encodeEventAck(Packet& packet, uint32_t pressCounter)
+{
+    packet.bytes[0] = (uint8_t)Opcode::EventAck;
+    put24(packet.bytes + 1, pressCounter);
+    packet.size = (uint8_t)bodySize(Opcode::EventAck);
+}
+
+void encodeButtonEvent(Packet& packet, const ButtonEventPayload& event)
+{
+    packet.bytes[0] = (uint8_t)Opcode::ButtonEvent;
+    put24(packet.bytes + 1, event.pressCounter);
+    packet.bytes[4] = (event.down ? kEventFlagDown : 0) | (event.queued ? kEventFlagQueued : 0) |
+                      (event.ackRequested ? kEventFlagAckRequested : 0);
+    put32(packet.bytes + 5, event.eventTicks);
+    put32(packet.bytes + 9, event.sentTicks);
+    packet.size = (uint8_t)bodySize(Opcode::ButtonEvent);
+}
+
+void encodeQueueDrained(Packet& packet)
+{
+    packet.bytes[0] = (uint8_t)Opcode::QueueDrained;
+    packet.size = (uint8_t)bodySize(Opcode::QueueDrained);
+}
+
+Error decodePacket(const uint8_t* data, size_t size, DecodedPacket& out)
+{
+    if (size == 0)
+    {
+        return Error::MissingData;
+    }
+    if (!isKnownOpcode(data[0]))
+    {
+        return Error::UnknownDataReceived;
+    }
+    Opcode opcode = (Opcode)data[0];
+    size_t expected = bodySize(opcode) + (isSignedOpcode(opcode) ? kSignatureSize : 0);
+    // The handshake may carry an ack window as an optional trailing byte.
+    bool hasAckWindow = !isSignedOpcode(opcode) && size == expected + 1;
+    if (size != expected && !hasAckWindow)
+    {
+        return Error::MissingData;
+    }
+
+    out.opcode = opcode;
+    out.ackWindow = hasAckWindow && data[expected] > 1 ? data[expected] : 1;
+    switch (opcode)
+    {
+        case Opcode::VerifyRequest:
+            memcpy(out.nonce, data + 1, kNonceSize);
+            break;
+        case Opcode::IndicateLED:
+            out.ledCount = data[1];
+            break;
+        case Opcode::EventAck:
+            out.ackCounter = get24(data + 1);
+            break;
+        case Opcode::ResumeRequest:
+            memcpy(out.ticketId, data + 1, kTicketIdSize);
+            memcpy(out.nonce, data + 1 + kTicketIdSize, kNonceSize);
+            break;
+        case Opcode::ResumeResponse:
+            out.ackWindow = data[1] > 1 ? data[1] : 1;
+            memcpy(out.nonce, data + 2, kNonceSize);
+            break;
+        case Opcode::ResumeRejected:
+            break;
+        case Opcode::VerifyResponse:
+            memcpy(out.nonce, data + 1, kNonceSize);
+            memcpy(out.proof, data + 1 + kNonceSize, kProofSize);
+            break;
+        case Opcode::ButtonEvent:
+            out.event.pressCounter = get24(data + 1);
+            out.event.down = (data[4] & kEventFlagDown) != 0;
+            out.event.queued = (data[4] & kEventFlagQueued) != 0;
+            out.event.ackRequested = (data[4] & kEventFlagAckRequested) != 0;
+            out.event.eventTicks = get32(data + 5);
+            out.event.sentTicks = get32(data + 9);
+            break;
+        case Opcode::QueueDrained:
+            break;
+    }
+    return Error::None;
+}
+
+void PacketSigner::reset(const uint8_t sessionKey[kSessionKeySize])
+{
+    _key.setKey(sessionKey);
+    _txCounter = 0;
+    _rxCounter = 0;
+}
+
+void PacketSigner::tag(uint64_t counter, bool fromHost, const uint8_t* body, size_t size,
+                       uint8_t out[kSignatureSize]) const
+{
+    uint8_t message[8 + kMaxPacketSize];
+    uint64_t directed = counter | (fromHost ? 0 : (1ull << 63));
+    for (int i = 0; i < 8; i++)
+    {
+        message[i] = (uint8_t)(directed >> (i * 8));
+    }
+    memcpy(message + 8, body, size);
+    _key.mac(message, 8 + size, out, kSignatureSize);
+}
+
+void PacketSigner::sign(Packet& packet)
+{
+    tag(_txCounter++, _host, packet.bytes, packet.size, packet.bytes + packet.size);
+    packet.size += kSignatureSize;
+}
+
+bool PacketSigner::verify(const uint8_t* data, size_t size)
+{
+    if (size < 1 + kSignatureSize)
+    {
+        return false;
+    }
+    uint8_t expected[kSignatureSize];
+    tag(_rxCounter, !_host, data, size - kSignatureSize, expected);
+    uint8_t diff = 0;
+    for (size_t i = 0; i < kSignatureSize; i++)
+    {
+        diff |= expected[i] ^ data[size - kSignatureSize + i];
+    }
+    if (diff != 0)
+    {
+        return false;
+    }
+    _rxCounter++;
+    return true;
+}
+
+size_t PacketSigner::verifyBatch(const uint8_t* const* data, const size_t* sizes, size_t count)
+{
+    const size_t lanes = ChaskeyKey::kChaskeyLanes;
+    size_t verified = 0;
+    while (verified < count)
+    {
+        size_t batch = count - verified < lanes ? count - verified : lanes;
+        uint8_t messages[lanes][8 + kMaxPacketSize];
+        const uint8_t* pointers[lanes];
+        size_t messageSizes[lanes];
+        for (size_t i = 0; i < batch; i++)
+        {
+            size_t size = sizes[verified + i];
+            if (size < 1 + kSignatureSize || size > kMaxPacketSize)
+            {
+                batch = i;
+                break;
+            }
+            uint64_t directed = (_rxCounter + i) | (_host ? (1ull << 63) : 0);
+            for (int j = 0; j < 8; j++)
+            {
+                messages[i][j] = (uint8_t)(directed >> (j * 8));
+            }
+            memcpy(messages[i] + 8, data[verified + i], size - kSignatureSize);
+            pointers[i] = messages[i];
+            messageSizes[i] = 8 + size - kSignatureSize;
+        }
+
+        uint8_t expected[lanes][kSignatureSize];
+        _key.macBatch(pointers, messageSizes, batch, expected[0], kSignatureSize);
+        for (size_t i = 0; i < batch; i++)
+        {
+            const uint8_t* signature = data[verified] + sizes[verified] - kSignatureSize;
+            uint8_t diff = 0;
+            for (size_t j = 0; j < kSignatureSize; j++)
+            {
+                diff |= expected[i][j] ^ signature[j];
+            }
+            if (diff != 0)
+            {
+                return verified;
+            }
+            _rxCounter++;
+            verified++;
+        }
+        if (batch < lanes && verified < count)
+        {
+            // Stopped at a packet too short to carry a signature.
+            return verified;
+        }
+    }
+    return verified;
+}
+
+void computeVerificationProof(const ChaskeyKey& longTermKey, const uint8_t hostNonce[kNonceSize],
+                              const uint8_t buttonNonce[kNonceSize], uint8_t proof[kProofSize])
+{
+    handshakeMac(longTermKey, kLabelProof, hostNonce, buttonNonce, proof, kProofSize);
+}
+
+void deriveSessionKey(const ChaskeyKey& longTermKey, const uint8_t hostNonce[kNonceSize],
+                      const uint8_t buttonNonce[kNonceSize], uint8_t sessionKey[kSessionKeySize])
+{
+    handshakeMac(longTermKey, kLabelSessionKey, hostNonce, buttonNonce, sessionKey, kSessionKeySize);
+}
+
+void deriveResumptionTicket(const ChaskeyKey& longTermKey, const uint8_t hostNonce[kNonceSize],
+                            const uint8_t buttonNonce[kNonceSize], Timestamp issued, ResumptionTicket& ticket)
+{
+    handshakeMac(longTermKey, kLabelTicketId, hostNonce, buttonNonce, ticket.id, kTicketIdSize);
+    handshakeMac(longTermKey, kLabelResumptionSecret, hostNonce, buttonNonce, ticket.secret, kSessionKeySize);
+    ticket.issued = issued;
+    ticket.valid = true;
+}
+
+void deriveResumedSession(ResumptionTicket& ticket, const uint8_t hostNonce[kNonceSize],
+                          const uint8_t buttonNonce[kNonceSize], uint8_t sessionKey[kSessionKeySize])
+{
+    ChaskeyKey secret(ticket.secret);
+    handshakeMac(secret, kLabelSessionKey, hostNonce, buttonNonce, sessionKey, kSessionKeySize);
+    // The lifetime of a chain of resumptions is that of the verification it started with.
+    deriveResumptionTicket(secret, hostNonce, buttonNonce, ticket.issued, ticket);
+}
+
+} // namespace flic
+} // namespace scl
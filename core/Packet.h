@@ -0,0 +1,260 @@
+//
+//  @file Packet.h
+//  @framework fliclib-core
+//
+//  Copyright (c) 2016-2026 Shortcut Labs. All rights reserved.
+//
+
+#ifndef SCL_FLIC_PACKET_H
+#define SCL_FLIC_PACKET_H
+
+#include "Chaskey.h"
+#include "Types.h"
+
+namespace scl {
+namespace flic {
+
+/*!
+ *  @discussion A packet always fits in a single notification/write without long attribute procedures.
+ *
+ */
+static const size_t kMaxPacketSize = 20;
+static const size_t kSignatureSize = 5;
+static const size_t kNonceSize = 8;
+static const size_t kProofSize = 8;
+static const size_t kSessionKeySize = ChaskeyKey::kKeySize;
+
+/*!
+ *  @discussion The largest number of unacknowledged events a flic may have in flight. Firmware without cumulative acks
+ *              has a window of 1 and waits for the ack of every event before it sends the next.
+ *
+ */
+static const uint8_t kMaxAckWindow = 64;
+
+static const size_t kTicketIdSize = 4;
+
+/*!
+ *  @discussion How long after the full verification it was issued with a resumption ticket is accepted, by either side.
+ *
+ */
+static const Timestamp kResumptionTicketLifetime = 60 * kNanosPerSecond;
+
+/*!
+ *  @enum Opcode
+ *
+ *  @discussion First byte of every packet. Opcodes with the high bit set are sent by the flic, the others by the host.
+ *              Everything except the verification handshake, the resume request and its rejection is signed with the
+ *              session key. A resume response is signed with the key of the session it resumes.
+ *
+ */
+enum class Opcode : uint8_t
+{
+    VerifyRequest = 0x01,
+    IndicateLED = 0x02,
+    EventAck = 0x03,
+    ResumeRequest = 0x04,
+    VerifyResponse = 0x81,
+    ButtonEvent = 0x82,
+    QueueDrained = 0x83,
+    ResumeResponse = 0x84,
+    ResumeRejected = 0x85,
+};
+
+bool isSignedOpcode(Opcode opcode);
+
+/*!
+ *  @struct Packet
+ *
+ *  @discussion Fixed size packet buffer. Encoding and decoding never touch the heap.
+ *
+ */
+struct Packet
+{
+    uint8_t bytes[kMaxPacketSize];
+    uint8_t size = 0;
+};
+
+/*!
+ *  @struct ButtonEventPayload
+ *
+ *  @discussion A raw up/down transition as recorded by the flic. <code>pressCounter</code> is the 24 bit counter that backs
+ *              SCLFlicButton.pressCount, <code>eventTicks</code> is the flic clock when the transition happened and
+ *              <code>sentTicks</code> the flic clock when the packet was sent, which together give the event age.
+ *              <code>ackRequested</code> is set by a flic that streams with an ack window on the events the host should
+ *              acknowledge, the others are covered by the cumulative ack of a later one.
+ *
+ */
+struct ButtonEventPayload
+{
+    uint32_t pressCounter = 0;
+    bool down = false;
+    bool queued = false;
+    bool ackRequested = false;
+    uint32_t eventTicks = 0;
+    uint32_t sentTicks = 0;
+};
+
+/*!
+ *  @struct DecodedPacket
+ *
+ *  @discussion The result of decodePacket. Only the fields belonging to <code>opcode</code> are valid.
+ *              <code>ackWindow</code> is the window offered by the host in a verify request or granted by the flic in a
+ *              verify response, 1 for a peer that does not know about ack windows.
+ *
+ */
+struct DecodedPacket
+{
+    Opcode opcode = Opcode::VerifyRequest;
+    ButtonEventPayload event;
+    uint8_t nonce[kNonceSize] = {};
+    uint8_t proof[kProofSize] = {};
+    uint8_t ledCount = 0;
+    uint32_t ackCounter = 0;
+    uint8_t ackWindow = 1;
+    uint8_t ticketId[kTicketIdSize] = {};
+};
+
+/*!
+ *  @struct ResumptionTicket
+ *
+ *  @discussion Issued to both sides by a full verification. Within <code>kResumptionTicketLifetime</code> a reconnect can
+ *              resume with it: the host sends its id and a fresh nonce, the flic answers with a fresh nonce of its own,
+ *              and both sides derive the session key from the secret and both nonces without the computations of a
+ *              full verification. A ticket is used once, resuming replaces it on both sides with one derived the same
+ *              way, which keeps the <code>issued</code> time of the verification that started the chain. A recorded
+ *              resume request is therefore rejected, and even a flic that still held the ticket would answer it with
+ *              a nonce the recorded host packets were not signed for. <code>issued</code> is on the clock of the side
+ *              that holds the ticket.
+ *
+ */
+struct ResumptionTicket
+{
+    uint8_t id[kTicketIdSize] = {};
+    uint8_t secret[kSessionKeySize] = {};
+    Timestamp issued = 0;
+    bool valid = false;
+
+    bool isValidAt(Timestamp now) const { return valid && now - issued < kResumptionTicketLifetime; }
+};
+
+/*!
+ *  @method encodeVerifyRequest:hostNonce:ackWindow:
+ *
+ *  @discussion A window larger than 1 is appended as an optional trailing byte, which firmware that does not know about
+ *              ack windows ignores. The verify response carries the granted window the same way.
+ *
+ */
+void encodeVerifyRequest(Packet& packet, const uint8_t hostNonce[kNonceSize], uint8_t ackWindow = 1);
+void encodeVerifyResponse(Packet& packet, const uint8_t buttonNonce[kNonceSize], const uint8_t proof[kProofSize],
+                          uint8_t ackWindow = 1);
+void encodeResumeRequest(Packet& packet, const uint8_t ticketId[kTicketIdSize], const uint8_t hostNonce[kNonceSize],
+                         uint8_t ackWindow = 1);
+void encodeResumeResponse(Packet& packet, const uint8_t buttonNonce[kNonceSize], uint8_t ackWindow);
+void encodeResumeRejected(Packet& packet);
+void encodeIndicateLED(Packet& packet, uint8_t count);
+/*!
+ *  @method encodeEventAck:pressCounter:
+ *
+ *  @discussion Acknowledges the event with the given counter and, within an ack window, every event before it.
+ *
+ */
+void encodeEventAck(Packet& packet, uint32_t pressCounter);
+void encodeButtonEvent(Packet& packet, const ButtonEventPayload& event);
+void encodeQueueDrained(Packet& packet);
+
+/*!
+ *  @method decodePacket
+ *
+ *  @discussion Parses a packet. For signed opcodes <code>size</code> must include the trailing signature, which has to be
+ *              checked separately with PacketSigner::verify before the result is trusted.
+ *
+ *  @return     <code>Error::None</code>, <code>Error::UnknownDataReceived</code> for an unknown opcode or
+ *              <code>Error::MissingData</code> if the size does not match the opcode.
+ *
+ */
+Error decodePacket(const uint8_t* data, size_t size, DecodedPacket& out);
+
+/*!
+ *  @class PacketSigner
+ *
+ *  @discussion Signs outgoing and verifies incoming packets of one session. Each direction has its own implicit packet
+ *              counter that is mixed into the MAC, which prevents both replay and reflection of packets.
+ *
+ */
+class PacketSigner
+{
+public:
+    explicit PacketSigner(bool host) : _host(host) {}
+
+    void reset(const uint8_t sessionKey[kSessionKeySize]);
+
+    /*!
+     *  @method sign:
+     *
+     *  @discussion Appends the signature to the packet.
+     *
+     */
+    void sign(Packet& packet);
+
+    /*!
+     *  @method verify:size:
+     *
+     *  @discussion Checks the trailing signature of a received packet and advances the receive counter if it is valid.
+     *
+     */
+    bool verify(const uint8_t* data, size_t size);
+
+    /*!
+     *  @method verifyBatch:sizes:count:
+     *
+     *  @discussion Checks the signatures of <code>count</code> packets received one after the other, computing their MACs
+     *              together with ChaskeyKey::macBatch. Gives the same result as calling <code>verify</code> on each packet
+     *              in turn until one fails.
+     *
+     *  @return The number of leading packets that are valid, the receive counter is advanced by as many.
+     *
+     */
+    size_t verifyBatch(const uint8_t* const* data, const size_t* sizes, size_t count);
+
+    uint64_t txCounter() const { return _txCounter; }
+    uint64_t rxCounter() const { return _rxCounter; }
+
+private:
+    void tag(uint64_t counter, bool fromHost, const uint8_t* body, size_t size, uint8_t out[kSignatureSize]) const;
+
+    bool _host;
+    ChaskeyKey _key;
+    uint64_t _txCounter = 0;
+    uint64_t _rxCounter = 0;
+};
+
+/*!
+ *  @method computeVerificationProof
+ *
+ *  @discussion The proof the flic returns in the verification handshake, keyed with the long term key that was handed
+ *              over when the button was grabbed from the Flic app.
+ *
+ */
+void computeVerificationProof(const ChaskeyKey& longTermKey, const uint8_t hostNonce[kNonceSize],
+                              const uint8_t buttonNonce[kNonceSize], uint8_t proof[kProofSize]);
+
+void deriveSessionKey(const ChaskeyKey& longTermKey, const uint8_t hostNonce[kNonceSize],
+                      const uint8_t buttonNonce[kNonceSize], uint8_t sessionKey[kSessionKeySize]);
+
+void deriveResumptionTicket(const ChaskeyKey& longTermKey, const uint8_t hostNonce[kNonceSize],
+                            const uint8_t buttonNonce[kNonceSize], Timestamp issued, ResumptionTicket& ticket);
+
+/*!
+ *  @method deriveResumedSession:hostNonce:buttonNonce:sessionKey:
+ *
+ *  @discussion Derives the session key of a resumption from the ticket and the nonces of both sides, and replaces the
+ *              ticket with the one for the next resumption.
+ *
+ */
+void deriveResumedSession(ResumptionTicket& ticket, const uint8_t hostNonce[kNonceSize],
+                          const uint8_t buttonNonce[kNonceSize], uint8_t sessionKey[kSessionKeySize]);
+
+} // namespace flic
+} // namespace scl
+
+#endif // SCL_FLIC_PACKET_H
@@ -0,0 +1,66 @@
+//
+//  @file RSSIFilter.cpp
+//  @framework fliclib-core
+//
+//  Copyright (c) 2016-2026 Shortcut Labs. All rights reserved.
+//
+
+#include "RSSIFilter.h"
+
+#include <cmath>
+
+namespace scl {
+namespace flic {
+
+const Timestamp RSSISubscription::kMinInterval;
+
+double RSSIFilter::add(int rssi, Timestamp time)
+{
+    double reading = rssi;
+    if (_samples++ == 0)
+    {
+        _estimate = reading;
+        _variance = _subscription.measurementNoise;
+        _lastTime = time;
+        return _estimate;
+    }
+
+    if (_subscription.filter == RSSIFilterKind::EWMA)
+    {
+        _estimate += _subscription.smoothing * (reading - _estimate);
+    }
+    else
+    {
+        double elapsed = (double)(time - _lastTime) / kNanosPerSecond;
+        _variance += _subscription.processNoise * (elapsed > 0 ? elapsed : 0);
+        double gain = _variance / (_variance + _subscription.measurementNoise);
+        _estimate += gain * (reading - _estimate);
+        _variance *= 1 - gain;
+    }
+    _lastTime = time;
+    return _estimate;
+}
+
+bool RSSIFilter::shouldReport()
+{
+    if (_samples == 0 || (_hasReported && std::fabs(_estimate - _reported) < _subscription.threshold))
+    {
+        return false;
+    }
+    _hasReported = true;
+    _reported = _estimate;
+    return true;
+}
+
+void RSSIFilter::reset()
+{
+    _estimate = 0;
+    _variance = 0;
+    _lastTime = 0;
+    _samples = 0;
+    _hasReported = false;
+    _reported = 0;
+}
+
+} // namespace flic
+} // namespace scl
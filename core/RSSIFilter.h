@@ -0,0 +1,113 @@
+//
+//  @file RSSIFilter.h
+//  @framework fliclib-core
+//
+//  Copyright (c) 2016-2026 Shortcut Labs. All rights reserved.
+//
+
+#ifndef SCL_FLIC_RSSI_FILTER_H
+#define SCL_FLIC_RSSI_FILTER_H
+
+#include "Types.h"
+
+namespace scl {
+namespace flic {
+
+/*!
+ *  @enum RSSIFilterKind
+ *
+ *  @discussion How the readings of an RSSI subscription are smoothed.
+ *
+ */
+enum class RSSIFilterKind : int
+{
+    /**
+     * A one dimensional Kalman filter with a random walk model: it trusts a new reading more the longer it has been since
+     * the last one, and settles on a weight that balances <code>processNoise</code> against <code>measurementNoise</code>.
+     */
+    Kalman = 0,
+    /**
+     * An exponentially weighted moving average with a fixed weight of <code>smoothing</code> for each new reading.
+     */
+    EWMA,
+};
+
+/*!
+ *  @struct RSSISubscription
+ *
+ *  @discussion What an RSSI subscription samples and reports. The link is read every <code>interval</code> and the
+ *              readings go through the filter, but only a filtered value that has moved at least <code>threshold</code>
+ *              dB from the last one reported makes a callback. The first filtered value of a connection is always
+ *              reported.
+ *
+ */
+struct RSSISubscription
+{
+    static const Timestamp kMinInterval = 100 * kNanosPerMilli;
+    /** Button::subscribeRSSI raises smaller noise variances and weights to these, and caps <code>smoothing</code> at 1. */
+    static constexpr double kMinNoise = 1e-3;
+    static constexpr double kMinSmoothing = 1e-3;
+
+    Timestamp interval = kNanosPerSecond;
+    double threshold = 3;
+    RSSIFilterKind filter = RSSIFilterKind::Kalman;
+    /** Variance of a single reading around the true value, in dB². Readings of a still flic vary by some 4 dB. */
+    double measurementNoise = 16;
+    /** How fast the true value is expected to drift, in dB² per second. */
+    double processNoise = 2;
+    /** Weight of a new reading for the EWMA filter. */
+    double smoothing = 0.25;
+};
+
+/*!
+ *  @class RSSIFilter
+ *
+ *  @discussion The filter behind an RSSI subscription. Fixed size, it never allocates.
+ *
+ */
+class RSSIFilter
+{
+public:
+    RSSIFilter() = default;
+    explicit RSSIFilter(const RSSISubscription& subscription) : _subscription(subscription) {}
+
+    /*!
+     *  @method add:time:
+     *
+     *  @discussion Folds in a reading taken at <code>time</code> on the scheduler clock.
+     *
+     *  @return The new estimate in dBm.
+     *
+     */
+    double add(int rssi, Timestamp time);
+
+    /*!
+     *  @method shouldReport
+     *
+     *  @discussion Tells whether the estimate has moved far enough from the last reported one to be reported, and if so
+     *              takes it as the new last reported value.
+     *
+     */
+    bool shouldReport();
+
+    void reset();
+    bool hasEstimate() const { return _samples > 0; }
+    double estimate() const { return _estimate; }
+    double variance() const { return _variance; }
+    uint64_t samples() const { return _samples; }
+    const RSSISubscription& subscription() const { return _subscription; }
+
+private:
+    RSSISubscription _subscription;
+    double _estimate = 0;
+    double _variance = 0;
+    Timestamp _lastTime = 0;
+    uint64_t _samples = 0;
+    bool _hasReported = false;
+    double _reported = 0;
+};
+
+} // namespace flic
+} // namespace scl
+
+#endif // SCL_FLIC_RSSI_FILTER_H
@@ -0,0 +1,46 @@
+//
+//  @file Random.h
+//  @framework fliclib-core
+//
+//  Copyright (c) 2016-2026 Shortcut Labs. All rights reserved.
+//
+
+#ifndef SCL_FLIC_RANDOM_H
+#define SCL_FLIC_RANDOM_H
+
+#include <string>
+
+#include "Types.h"
+
+namespace scl {
+namespace flic {
+
+/*!
+ *  @method splitMix64
+ *
+ *  @discussion Small deterministic generator used for handshake nonces and by the simulation, so that a run with the same
+ *              seed always produces the same packets. Nonces only need to be unique per session, not secret.
+ *
+ */
+inline uint64_t splitMix64(uint64_t& state)
+{
+    uint64_t z = (state += 0x9e3779b97f4a7c15ull);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+    return z ^ (z >> 31);
+}
+
+inline uint64_t hashString(const std::string& value)
+{
+    uint64_t hash = 0xcbf29ce484222325ull;
+    for (unsigned char c : value)
+    {
+        hash = (hash ^ c) * 0x100000001b3ull;
+    }
+    return hash;
+}
+
+} // namespace flic
+} // namespace scl
+
+#endif // SCL_FLIC_RANDOM_H
@@ -0,0 +1,147 @@
+//
+//  @file Scheduler.cpp
+//  @framework fliclib-core
+//
+//  Copyright (c) 2016-2026 Shortcut Labs. All rights reserved.
+//
+
+#include "Scheduler.h"
+
+namespace scl {
+namespace flic {
+
+void ManualScheduler::schedule(Timer& timer, Timestamp deadline)
+{
+    if (timer.isScheduled())
+    {
+        removeAt((size_t)timer._heapIndex);
+    }
+    timer._deadline = deadline;
+    timer._sequence = _sequence++;
+    _heap.push_back(&timer);
+    place(&timer, _heap.size() - 1);
+    siftUp(_heap.size() - 1);
+}
+
+void ManualScheduler::cancel(Timer& timer)
+{
+    if (timer.isScheduled())
+    {
+        removeAt((size_t)timer._heapIndex);
+    }
+}
+
+void ManualScheduler::advanceTo(Timestamp time)
+{
+    while (!_heap.empty() && _heap.front()->_deadline <= time)
+    {
+        step();
+    }
+    if (time > _now)
+    {
+        _now = time;
+    }
+}
+
+void ManualScheduler::runUntilIdle()
+{
+    while (step())
+    {
+    }
+}
+
+bool ManualScheduler::step()
+{
+    if (_heap.empty())
+    {
+        return false;
+    }
+    Timer* timer = _heap.front();
+    removeAt(0);
+    if (timer->_deadline > _now)
+    {
+        _now = timer->_deadline;
+    }
+    timer->fire();
+    return true;
+}
+
+bool ManualScheduler::before(const Timer* a, const Timer* b) const
+{
+    if (a->_deadline != b->_deadline)
+    {
+        return a->_deadline < b->_deadline;
+    }
+    return a->_sequence < b->_sequence;
+}
+
+void ManualScheduler::place(Timer* timer, size_t index)
+{
+    _heap[index] = timer;
+    timer->_heapIndex = (long)index;
+}
+
+void ManualScheduler::siftUp(size_t index)
+{
+    Timer* timer = _heap[index];
+    while (index > 0)
+    {
+        size_t parent = (index - 1) / 2;
+        if (!before(timer, _heap[parent]))
+        {
+            break;
+        }
+        place(_heap[parent], index);
+        index = parent;
+    }
+    place(timer, index);
+}
+
+void ManualScheduler::siftDown(size_t index)
+{
+    Timer* timer = _heap[index];
+    size_t count = _heap.size();
+    while (true)
+    {
+        size_t child = index * 2 + 1;
+        if (child >= count)
+        {
+            break;
+        }
+        if (child + 1 < count && before(_heap[child + 1], _heap[child]))
+        {
+            child++;
+        }
+        if (!before(_heap[child], timer))
+        {
+            break;
+        }
+        place(_heap[child], index);
+        index = child;
+    }
+    place(timer, index);
+}
+
+void ManualScheduler::removeAt(size_t index)
+{
+    Timer* removed = _heap[index];
+    Timer* last = _heap.back();
+    _heap.pop_back();
+    removed->_heapIndex = -1;
+    if (last == removed)
+    {
+        return;
+    }
+    place(last, index);
+    if (index > 0 && before(last, _heap[(index - 1) / 2]))
+    {
+        siftUp(index);
+    }
+    else
+    {
+        siftDown(index);
+    }
+}
+
+} // namespace flic
+} // namespace scl
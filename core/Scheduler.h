@@ -0,0 +1,128 @@
+//
+//  @file Scheduler.h
+//  @framework fliclib-core
+//
+//  Copyright (c) 2016-2026 Shortcut Labs. All rights reserved.
+//
+
+#ifndef SCL_FLIC_SCHEDULER_H
+#define SCL_FLIC_SCHEDULER_H
+
+#include <vector>
+
+#include "Types.h"
+
+namespace scl {
+namespace flic {
+
+/*!
+ *  @class Timer
+ *
+ *  @discussion An intrusive timer node. Objects that need deadlines (the trigger behavior classifier, in-flight packets of
+ *              the simulated link) embed or derive from a Timer so that arming it never allocates.
+ *
+ */
+class Timer
+{
+public:
+    virtual ~Timer() = default;
+
+    /*!
+     *  @method fire
+     *
+     *  @discussion Called by the scheduler once the deadline has been reached. The timer is no longer scheduled when this
+     *              is called and may be re-armed from within the callback.
+     *
+     */
+    virtual void fire() = 0;
+
+    bool isScheduled() const { return _heapIndex >= 0; }
+    Timestamp deadline() const { return _deadline; }
+
+private:
+    friend class ManualScheduler;
+
+    Timestamp _deadline = 0;
+    uint64_t _sequence = 0;
+    long _heapIndex = -1;
+};
+
+/*!
+ *  @class Scheduler
+ *
+ *  @discussion The source of time and deadlines for the core. On iOS this is backed by the Core Bluetooth queue, on Linux
+ *              the ManualScheduler below runs the whole core in virtual time.
+ *
+ */
+class Scheduler
+{
+public:
+    virtual ~Scheduler() = default;
+
+    virtual Timestamp now() const = 0;
+
+    /*!
+     *  @method schedule:deadline:
+     *
+     *  @discussion Arms the timer. If it is already scheduled it is moved to the new deadline. Timers with equal deadlines
+     *              fire in the order they were scheduled.
+     *
+     */
+    virtual void schedule(Timer& timer, Timestamp deadline) = 0;
+
+    virtual void cancel(Timer& timer) = 0;
+};
+
+/*!
+ *  @class ManualScheduler
+ *
+ *  @discussion A deterministic, single threaded scheduler running in virtual time. Time only moves when one of the
+ *              advance/run methods is called, which lets a simulation run much faster than real time.
+ *
+ */
+class ManualScheduler : public Scheduler
+{
+public:
+    explicit ManualScheduler(Timestamp start = 0) : _now(start) {}
+
+    Timestamp now() const override { return _now; }
+    void schedule(Timer& timer, Timestamp deadline) override;
+    void cancel(Timer& timer) override;
+
+    /*!
+     *  @method advanceTo:
+     *
+     *  @discussion Fires every timer with a deadline up to and including <code>time</code>, then sets the clock to it.
+     *
+     */
+    void advanceTo(Timestamp time);
+    void advanceBy(Timestamp delta) { advanceTo(_now + delta); }
+
+    /*!
+     *  @method runUntilIdle
+     *
+     *  @discussion Fires timers until none are left, moving the clock along with them.
+     *
+     */
+    void runUntilIdle();
+
+    bool step();
+
+    size_t pendingTimers() const { return _heap.size(); }
+
+private:
+    bool before(const Timer* a, const Timer* b) const;
+    void siftUp(size_t index);
+    void siftDown(size_t index);
+    void place(Timer* timer, size_t index);
+    void removeAt(size_t index);
+
+    Timestamp _now;
+    uint64_t _sequence = 0;
+    std::vector<Timer*> _heap;
+};
+
+} // namespace flic
+} // namespace scl
+
+#endif // SCL_FLIC_SCHEDULER_H
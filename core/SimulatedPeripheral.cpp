@@ -0,0 +1,692 @@
+//
+//  @file SimulatedPeripheral.cpp
+//  @framework fliclib-core
+//
+//  Copyright (c) 2016-2026 Shortcut Labs. All rights reserved.
+//
+
+#include "SimulatedPeripheral.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include "Button.h"
+#include "Random.h"
+
+namespace scl {
+namespace flic {
+
+const size_t SimulatedPeripheral::kMaxQueuedEvents;
+const size_t SimulatedLink::kMaxBurst;
+
+namespace {
+
+// Connection intervals are multiples of 1.25 ms, and a parameter update takes effect a few connection events after it
+// was agreed on.
+const Timestamp kIntervalUnit = 1250 * 1000;
+const uint64_t kParameterUpdateEvents = 6;
+
+} // namespace
+
+SimulatedPeripheral::SimulatedPeripheral(Scheduler& scheduler, const uint8_t longTermKey[ChaskeyKey::kKeySize],
+                                         uint64_t seed)
+    : _scheduler(scheduler),
+      _longTermKey(longTermKey),
+      _signer(false),
+      _random(seed),
+      _rssiRandom(~seed),
+      _verificationTimer(*this)
+{
+    _tickOffset = (uint32_t)splitMix64(_random);
+}
+
+SimulatedPeripheral::~SimulatedPeripheral()
+{
+    _scheduler.cancel(_verificationTimer);
+}
+
+uint32_t SimulatedPeripheral::ticks() const
+{
+    return nanosToButtonTicks(_scheduler.now()) + _tickOffset;
+}
+
+int SimulatedPeripheral::sampleRSSI()
+{
+    if (_rssiNoise <= 0)
+    {
+        return _rssi;
+    }
+    // The sum of four uniform draws is close enough to a normal distribution, and has a variance of 4/3.
+    double sum = 0;
+    for (int i = 0; i < 4; i++)
+    {
+        sum += (double)(splitMix64(_rssiRandom) >> 11) / (double)(1ull << 53) * 2 - 1;
+    }
+    return (int)std::lround(_rssi + sum * _rssiNoise * 0.8660254037844386);
+}
+
+void SimulatedPeripheral::press()
+{
+    record(true);
+}
+
+void SimulatedPeripheral::release()
+{
+    record(false);
+}
+
+void SimulatedPeripheral::record(bool down)
+{
+    _pressCounter = (_pressCounter + 1) & 0xffffff;
+    if (_pending.size() == kMaxQueuedEvents)
+    {
+        _pending.pop_front();
+        _inFlight -= _inFlight > 0;
+    }
+    _pending.push_back(Record { _pressCounter, down, !_verified, ticks() });
+    trySend();
+}
+
+void SimulatedPeripheral::setInRange(bool inRange)
+{
+    if (_inRange == inRange)
+    {
+        return;
+    }
+    _inRange = inRange;
+    if (_attachedLink)
+    {
+        if (inRange)
+        {
+            _attachedLink->peripheralDidEnterRange();
+        }
+        else
+        {
+            _attachedLink->peripheralDidLeaveRange();
+        }
+    }
+}
+
+void SimulatedPeripheral::completeVerification()
+{
+    send(_verifyResponse);
+    _signer.reset(_sessionKey);
+    startSession();
+}
+
+void SimulatedPeripheral::startSession()
+{
+    _verified = true;
+    _draining = true;
+    _inFlight = 0;
+    trySend();
+}
+
+void SimulatedPeripheral::trySend()
+{
+    if (!_verified)
+    {
+        return;
+    }
+    Packet packet;
+    if (_pending.empty())
+    {
+        if (_draining)
+        {
+            _draining = false;
+            encodeQueueDrained(packet);
+            send(packet);
+        }
+        return;
+    }
+
+    size_t half = (_ackWindow + 1) / 2;
+    while (_inFlight < _ackWindow && _inFlight < _pending.size())
+    {
+        const Record& next = _pending[_inFlight++];
+        ButtonEventPayload event;
+        event.pressCounter = next.pressCounter;
+        event.down = next.down;
+        event.queued = next.queued;
+        event.eventTicks = next.ticks;
+        event.sentTicks = ticks();
+        // The last event in flight always asks, or nothing would be acked.
+        event.ackRequested = _inFlight % half == 0 || _inFlight == _ackWindow || _inFlight == _pending.size();
+        encodeButtonEvent(packet, event);
+        send(packet);
+    }
+}
+
+void SimulatedPeripheral::send(Packet& packet)
+{
+    if (isSignedOpcode((Opcode)packet.bytes[0]))
+    {
+        _signer.sign(packet);
+    }
+    if (_link)
+    {
+        _link->peripheralDidSend(packet.bytes, packet.size);
+    }
+}
+
+void SimulatedPeripheral::linkDidConnect(SimulatedLink& link)
+{
+    _link = &link;
+    _verified = false;
+    _inFlight = 0;
+    _scheduler.cancel(_verificationTimer);
+}
+
+void SimulatedPeripheral::linkDidDisconnect()
+{
+    _link = nullptr;
+    _verified = false;
+    _inFlight = 0;
+    _scheduler.cancel(_verificationTimer);
+    _draining = false;
+}
+
+void SimulatedPeripheral::linkDidReceive(const uint8_t* data, size_t size)
+{
+    DecodedPacket packet;
+    if (decodePacket(data, size, packet) != Error::None)
+    {
+        _rejectedPackets++;
+        return;
+    }
+
+    if (packet.opcode == Opcode::VerifyRequest)
+    {
+        uint8_t buttonNonce[kNonceSize];
+        uint64_t value = splitMix64(_random);
+        memcpy(buttonNonce, &value, kNonceSize);
+
+        uint8_t proof[kProofSize];
+        computeVerificationProof(_longTermKey, packet.nonce, buttonNonce, proof);
+        deriveSessionKey(_longTermKey, packet.nonce, buttonNonce, _sessionKey);
+        deriveResumptionTicket(_longTermKey, packet.nonce, buttonNonce, _scheduler.now(), _ticket);
+        _ackWindow = std::min(packet.ackWindow, kMaxAckWindow);
+        encodeVerifyResponse(_verifyResponse, buttonNonce, proof, _ackWindow);
+        _fullVerifications++;
+        if (_verificationTime > 0)
+        {
+            _scheduler.schedule(_verificationTimer, _scheduler.now() + _verificationTime);
+        }
+        else
+        {
+            completeVerification();
+        }
+        return;
+    }
+
+    if (packet.opcode == Opcode::ResumeRequest)
+    {
+        Packet response;
+        if (!_ticket.isValidAt(_scheduler.now()) || memcmp(packet.ticketId, _ticket.id, kTicketIdSize) != 0)
+        {
+            encodeResumeRejected(response);
+            send(response);
+            return;
+        }
+        uint8_t buttonNonce[kNonceSize];
+        uint64_t value = splitMix64(_random);
+        memcpy(buttonNonce, &value, kNonceSize);
+        uint8_t sessionKey[kSessionKeySize];
+        deriveResumedSession(_ticket, packet.nonce, buttonNonce, sessionKey);
+        _signer.reset(sessionKey);
+        _ackWindow = std::min(packet.ackWindow, kMaxAckWindow);
+        encodeResumeResponse(response, buttonNonce, _ackWindow);
+        send(response);
+        _resumptions++;
+        startSession();
+        return;
+    }
+
+    if (!_verified || !isSignedOpcode(packet.opcode) || !_signer.verify(data, size))
+    {
+        _rejectedPackets++;
+        return;
+    }
+
+    switch (packet.opcode)
+    {
+        case Opcode::EventAck:
+            // Cumulative: everything in flight up to the acked event is done.
+            for (size_t i = 0; i < _inFlight; i++)
+            {
+                if (_pending[i].pressCounter == packet.ackCounter)
+                {
+                    _pending.erase(_pending.begin(), _pending.begin() + (long)(i + 1));
+                    _inFlight -= i + 1;
+                    trySend();
+                    break;
+                }
+            }
+            break;
+        case Opcode::IndicateLED:
+            _ledIndications += packet.ledCount;
+            break;
+        default:
+            _rejectedPackets++;
+            break;
+    }
+}
+
+SimulatedLink::SimulatedLink(Scheduler& scheduler, SimulatedPeripheral& peripheral, const LinkParameters& parameters)
+    : _scheduler(scheduler),
+      _peripheral(peripheral),
+      _parameters(parameters)
+{
+    _peripheral._attachedLink = this;
+}
+
+SimulatedLink::~SimulatedLink()
+{
+    for (auto& delivery : _deliveries)
+    {
+        _scheduler.cancel(*delivery);
+    }
+    if (_connected)
+    {
+        _peripheral.linkDidDisconnect();
+    }
+    if (_peripheral._attachedLink == this)
+    {
+        _peripheral._attachedLink = nullptr;
+    }
+}
+
+SimulatedLink::Delivery& SimulatedLink::post(Kind kind, Timestamp delay)
+{
+    Delivery* delivery;
+    if (_freeDeliveries.empty())
+    {
+        _deliveries.emplace_back(new Delivery());
+        delivery = _deliveries.back().get();
+        delivery->link = this;
+    }
+    else
+    {
+        delivery = _freeDeliveries.back();
+        _freeDeliveries.pop_back();
+    }
+    delivery->kind = kind;
+    delivery->generation = _generation;
+    delivery->error = Error::None;
+    delivery->count = 0;
+    _scheduler.schedule(*delivery, _scheduler.now() + delay);
+    return *delivery;
+}
+
+void SimulatedLink::Delivery::fire()
+{
+    link->deliver(*this);
+}
+
+void SimulatedLink::deliver(Delivery& delivery)
+{
+    // The callbacks below may post new deliveries, so everything is copied out and the delivery returned to the pool first.
+    Kind kind = delivery.kind;
+    Error error = delivery.error;
+    bool current = delivery.generation == _generation;
+    size_t count = delivery.count;
+    uint8_t data[kMaxBurst][kMaxPacketSize];
+    ReceivedPacket packets[kMaxBurst];
+    for (size_t i = 0; i < count; i++)
+    {
+        memcpy(data[i], delivery.data[i], delivery.sizes[i]);
+        packets[i] = { data[i], delivery.sizes[i] };
+    }
+    if (_burst == &delivery)
+    {
+        _burst = nullptr;
+    }
+    _freeDeliveries.push_back(&delivery);
+
+    TransportListener* target = listener();
+    switch (kind)
+    {
+        case Kind::Connected:
+            _connecting = false;
+            if (!_pendingConnect || !_peripheral.inRange())
+            {
+                break;
+            }
+        {
+            _pendingConnect = false;
+            _connected = true;
+            linkDidComeUp();
+            _peripheral.linkDidConnect(*this);
+            Timestamp roundTrip = 2 * _parameters.latency;
+            Timestamp setup = 0;
+            if (_cachedAttributeLayout == 0 || _cachedAttributeLayout != _peripheral.attributeLayout())
+            {
+                setup += _parameters.discoveryRoundTrips * roundTrip;
+                _discoveries++;
+            }
+            _attributeLayout = _peripheral.attributeLayout();
+            if (!_pipelinesSetup)
+            {
+                setup += _parameters.subscriptionRoundTrips * roundTrip;
+            }
+            if (setup > 0)
+            {
+                post(Kind::SetUp, setup);
+            }
+            else if (target)
+            {
+                target->transportDidConnect();
+            }
+            break;
+        }
+        case Kind::ParametersUpdated:
+            if (current && _connected)
+            {
+                applyRequestedParameters();
+            }
+            break;
+        case Kind::SetUp:
+            if (current && _connected && target)
+            {
+                target->transportDidConnect();
+            }
+            break;
+        case Kind::Disconnected:
+            if (target)
+            {
+                target->transportDidDisconnect(error);
+            }
+            break;
+        case Kind::ToPeripheral:
+            if (current && _connected)
+            {
+                _packetsToPeripheral++;
+                _peripheral.linkDidReceive(packets[0].data, packets[0].size);
+            }
+            break;
+        case Kind::ToHost:
+            if (current && _connected && target)
+            {
+                _packetsToHost += count;
+                target->transportDidReceivePackets(packets, count);
+            }
+            break;
+        case Kind::RSSI:
+            // Like Core Bluetooth, a link that went down takes its pending reads with it.
+            if (!target || !current)
+            {
+                break;
+            }
+            if (_connected)
+            {
+                target->transportDidReadRSSI(_peripheral.sampleRSSI(), Error::None);
+            }
+            else
+            {
+                target->transportDidReadRSSI(0, Error::BluetoothErrorNotConnected);
+            }
+            break;
+    }
+}
+
+void SimulatedLink::connect()
+{
+    if (_connected)
+    {
+        return;
+    }
+    _pendingConnect = true;
+    tryConnect();
+}
+
+void SimulatedLink::tryConnect()
+{
+    if (_pendingConnect && !_connecting && !_connected && _peripheral.inRange())
+    {
+        _connecting = true;
+        post(Kind::Connected, _parameters.connectDelay);
+    }
+}
+
+void SimulatedLink::disconnect()
+{
+    _pendingConnect = false;
+    if (_connected)
+    {
+        linkDidGoDown();
+        _peripheral.linkDidDisconnect();
+    }
+    post(Kind::Disconnected, _parameters.latency).error = Error::None;
+}
+
+void SimulatedLink::dropLink(Error error)
+{
+    if (!_connected)
+    {
+        return;
+    }
+    linkDidGoDown();
+    _peripheral.linkDidDisconnect();
+    post(Kind::Disconnected, _parameters.latency).error = error;
+}
+
+void SimulatedLink::linkDidComeUp()
+{
+    _interval = _parameters.initialConnectionInterval;
+    _peripheralLatency = 0;
+    _anchor = _scheduler.now();
+    _accountedEvents = 0;
+    _connectedSince = _scheduler.now();
+}
+
+void SimulatedLink::linkDidGoDown()
+{
+    _radioOnTime = radioOnTime();
+    _connectedTime = connectedTime();
+    _connected = false;
+    _generation++;
+}
+
+Timestamp SimulatedLink::untilConnectionEvent(uint64_t everyEvents) const
+{
+    if (!_parameters.modelsConnectionEvents || !_connected || _interval == 0)
+    {
+        return 0;
+    }
+    Timestamp period = _interval * (Timestamp)everyEvents;
+    Timestamp sinceEvent = (_scheduler.now() - _anchor) % period;
+    return sinceEvent == 0 ? 0 : period - sinceEvent;
+}
+
+uint64_t SimulatedLink::attendedIdleEvents() const
+{
+    // An idle flic attends the anchor event and then one in every peripheral latency plus one.
+    Timestamp period = _interval * (_peripheralLatency + 1);
+    return (uint64_t)((_scheduler.now() - _anchor) / period) + 1;
+}
+
+Timestamp SimulatedLink::radioOnTime() const
+{
+    if (!_connected || _interval == 0)
+    {
+        return _radioOnTime;
+    }
+    return _radioOnTime + (Timestamp)(attendedIdleEvents() - _accountedEvents) * _parameters.connectionEventDuration;
+}
+
+Timestamp SimulatedLink::connectedTime() const
+{
+    return _connectedTime + (_connected ? _scheduler.now() - _connectedSince : 0);
+}
+
+void SimulatedLink::requestConnectionParameters(const ConnectionParameters& parameters)
+{
+    if (!_connected)
+    {
+        return;
+    }
+    // Applied by the ParametersUpdated delivery, a later request replaces one that is still under way. Without a model of
+    // connection events the new interval would not change anything, so it is applied right away.
+    _requestedParameters = parameters;
+    if (!_parameters.modelsConnectionEvents)
+    {
+        applyRequestedParameters();
+        return;
+    }
+    post(Kind::ParametersUpdated, 2 * _parameters.latency + (Timestamp)kParameterUpdateEvents * _interval);
+}
+
+void SimulatedLink::applyRequestedParameters()
+{
+    // The host grants the shortest interval it allows within the requested range.
+    _radioOnTime = radioOnTime();
+    _interval = std::max(_requestedParameters.minInterval, _parameters.minConnectionInterval);
+    _interval = (_interval + kIntervalUnit - 1) / kIntervalUnit * kIntervalUnit;
+    _peripheralLatency = _requestedParameters.peripheralLatency;
+    _anchor = _scheduler.now();
+    _accountedEvents = 0;
+}
+
+void SimulatedLink::write(const uint8_t* data, size_t size)
+{
+    if (!_connected || size > kMaxPacketSize)
+    {
+        return;
+    }
+    // Waits for a connection event the flic listens to, with peripheral latency it may sleep through the others.
+    _radioOnTime += _parameters.packetAirTime;
+    Delivery& delivery = post(Kind::ToPeripheral, untilConnectionEvent(_peripheralLatency + 1) + _parameters.latency);
+    memcpy(delivery.data[0], data, size);
+    delivery.sizes[0] = (uint8_t)size;
+    delivery.count = 1;
+}
+
+void SimulatedLink::readRSSI()
+{
+    // The controller measures on the next packet it receives, i.e. the next connection event the flic attends.
+    post(Kind::RSSI, untilConnectionEvent(_peripheralLatency + 1) + 2 * _parameters.latency);
+}
+
+bool SimulatedLink::isAdvertising() const
+{
+    return !_connected && _peripheral.inRange() && !_peripheral._pending.empty();
+}
+
+void SimulatedLink::peripheralDidSend(const uint8_t* data, size_t size)
+{
+    // Joins the packets already sent at this time on the current connection.
+    if (!_burst || _burstSentAt != _scheduler.now() || _burst->generation != _generation || _burst->count == kMaxBurst)
+    {
+        // A flic with something to send can use the next connection event, attended or not.
+        _burst = &post(Kind::ToHost, untilConnectionEvent(1) + _parameters.latency);
+        _burstSentAt = _scheduler.now();
+        _radioOnTime += _parameters.connectionEventDuration;
+    }
+    _radioOnTime += _parameters.packetAirTime;
+    memcpy(_burst->data[_burst->count], data, size);
+    _burst->sizes[_burst->count] = (uint8_t)size;
+    _burst->count++;
+}
+
+void SimulatedLink::peripheralDidLeaveRange()
+{
+    dropLink(Error::BluetoothErrorConnectionLost);
+}
+
+void SimulatedLink::peripheralDidEnterRange()
+{
+    tryConnect();
+}
+
+namespace {
+
+// Pairs every delivered down and up with the time of the transition that produced it.
+class TransitionLatencyDelegate : public ButtonDelegate
+{
+public:
+    TransitionLatencyDelegate(Timestamp fixedLatency, ConnectionTraceStats& stats)
+        : _fixedLatency(fixedLatency), _stats(stats)
+    {
+    }
+
+    void didReceiveButtonDown(Button& button, bool queued, long age) override { delivered(button, queued); }
+    void didReceiveButtonUp(Button& button, bool queued, long age) override { delivered(button, queued); }
+
+    std::deque<Timestamp> pending;
+
+private:
+    void delivered(Button& button, bool queued)
+    {
+        if (pending.empty())
+        {
+            return;
+        }
+        Timestamp transition = pending.front();
+        pending.pop_front();
+        if (queued)
+        {
+            return;
+        }
+        Timestamp added = std::max<Timestamp>(0, button.scheduler().now() - transition - _fixedLatency);
+        _stats.transitions++;
+        _stats.addedLatency += added;
+        _stats.maxAddedLatency = std::max(_stats.maxAddedLatency, added);
+    }
+
+    Timestamp _fixedLatency;
+    ConnectionTraceStats& _stats;
+};
+
+} // namespace
+
+ConnectionTraceStats runConnectionTrace(const ConnectionTraceOptions& options, const PressTransition* transitions,
+                                        size_t count)
+{
+    ConnectionTraceStats stats;
+    ManualScheduler scheduler;
+    ButtonInfo info;
+    info.identifier = "trace";
+    SimulatedPeripheral peripheral(scheduler, info.longTermKey);
+    LinkParameters parameters = options.link;
+    parameters.modelsConnectionEvents = true;
+    SimulatedLink link(scheduler, peripheral, parameters);
+    Button button(info, link, scheduler);
+    TransitionLatencyDelegate delegate(parameters.latency, stats);
+    button.setDelegate(&delegate);
+    button.setConnectionProfile(options.profile);
+    button.setAdaptiveLatency(options.adaptiveLatency);
+    button.setAdaptiveIdleTimeout(options.adaptiveIdleTimeout);
+    button.connect();
+    // The trace starts a second after the connection, once the parameters of the profile are in effect.
+    scheduler.advanceBy(kNanosPerSecond);
+    if (count == 0 || !button.isReady())
+    {
+        return stats;
+    }
+
+    Timestamp radioBefore = link.radioOnTime();
+    Timestamp connectedBefore = link.connectedTime();
+    Timestamp offset = scheduler.now() - transitions[0].time;
+    for (size_t i = 0; i < count; i++)
+    {
+        scheduler.advanceTo(std::max(scheduler.now(), transitions[i].time + offset));
+        delegate.pending.push_back(scheduler.now());
+        if (transitions[i].down)
+        {
+            peripheral.press();
+        }
+        else
+        {
+            peripheral.release();
+        }
+    }
+    scheduler.advanceBy(kNanosPerSecond);
+    stats.radioOnTime = link.radioOnTime() - radioBefore;
+    stats.connectedTime = link.connectedTime() - connectedBefore;
+    button.setDelegate(nullptr);
+    return stats;
+}
+
+} // namespace flic
+} // namespace scl
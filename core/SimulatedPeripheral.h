@@ -0,0 +1,395 @@
+//
+//  @file SimulatedPeripheral.h
+//  @framework fliclib-core
+//
+//  Copyright (c) 2016-2026 Shortcut Labs. All rights reserved.
+//
+
+#ifndef SCL_FLIC_SIMULATED_PERIPHERAL_H
+#define SCL_FLIC_SIMULATED_PERIPHERAL_H
+
+#include <deque>
+#include <memory>
+#include <vector>
+
+#include "Classifier.h"
+#include "Packet.h"
+#include "Scheduler.h"
+#include "Transport.h"
+
+namespace scl {
+namespace flic {
+
+class SimulatedLink;
+
+/*!
+ *  @class SimulatedPeripheral
+ *
+ *  @discussion An in-process model of the flic firmware. It keeps the press counter and the flic clock, queues events while
+ *              it has no verified connection and answers the verification handshake. It grants the ack window the host
+ *              offers, up to <code>kMaxAckWindow</code>, and keeps up to that many events in flight, asking for an ack
+ *              halfway through the window and on the last event it has, so that the backlog keeps streaming while acks
+ *              are on their way. With a window of 1 it sends one event at a time and waits for its ack.
+ *              <br/><br/>
+ *              The SimulatedLink attached to a peripheral must be destroyed before the peripheral.
+ *
+ */
+class SimulatedPeripheral
+{
+public:
+    static const size_t kMaxQueuedEvents = 1024;
+
+    SimulatedPeripheral(Scheduler& scheduler, const uint8_t longTermKey[ChaskeyKey::kKeySize], uint64_t seed = 0);
+    ~SimulatedPeripheral();
+
+    SimulatedPeripheral(const SimulatedPeripheral&) = delete;
+    SimulatedPeripheral& operator=(const SimulatedPeripheral&) = delete;
+
+    void press();
+    void release();
+
+    /*!
+     *  @method setInRange:
+     *
+     *  @discussion Moving the peripheral out of range drops an active link with a connection lost error. Moving it back
+     *              lets a pending connection complete.
+     *
+     */
+    void setInRange(bool inRange);
+    bool inRange() const { return _inRange; }
+
+    void setRSSI(int rssi) { _rssi = rssi; }
+    int rssi() const { return _rssi; }
+
+    /*!
+     *  @property rssiNoise
+     *
+     *  @discussion Standard deviation in dB of the readings around <code>rssi</code>, 0 by default. The noise is
+     *              roughly normal and follows the seed of the peripheral.
+     *
+     */
+    double rssiNoise() const { return _rssiNoise; }
+    void setRSSINoise(double noise) { _rssiNoise = noise; }
+
+    /*!
+     *  @method sampleRSSI
+     *
+     *  @return What a reading of the link gives right now.
+     *
+     */
+    int sampleRSSI();
+
+    /*!
+     *  @property attributeLayout
+     *
+     *  @discussion Stands in for the GATT layout of the firmware, change it to model a firmware update.
+     *
+     */
+    uint64_t attributeLayout() const { return _attributeLayout; }
+    void setAttributeLayout(uint64_t layout) { _attributeLayout = layout; }
+
+    /*!
+     *  @property verificationTime
+     *
+     *  @discussion How long the firmware takes to answer a full verification, 0 by default. Resuming a session with a
+     *              ticket is answered right away.
+     *
+     */
+    Timestamp verificationTime() const { return _verificationTime; }
+    void setVerificationTime(Timestamp time) { _verificationTime = time; }
+
+    /*!
+     *  @method forgetTicket
+     *
+     *  @discussion Drops the resumption ticket, like a reboot of the flic does.
+     *
+     */
+    void forgetTicket() { _ticket.valid = false; }
+
+    unsigned fullVerifications() const { return _fullVerifications; }
+    unsigned resumptions() const { return _resumptions; }
+
+    uint32_t ticks() const;
+
+    /*!
+     *  @property pressCounter
+     *
+     *  @discussion The counter of the last recorded event, 24 bits wide. Set it to stand in for a flic that was pressed
+     *              before, whose host restores the press count it persisted.
+     *
+     */
+    uint32_t pressCounter() const { return _pressCounter; }
+    void setPressCounter(uint32_t counter) { _pressCounter = counter & 0xffffff; }
+    size_t queuedEvents() const { return _pending.size(); }
+    bool isVerified() const { return _verified; }
+    unsigned ledIndications() const { return _ledIndications; }
+    unsigned rejectedPackets() const { return _rejectedPackets; }
+
+private:
+    friend class SimulatedLink;
+
+    struct Record
+    {
+        uint32_t pressCounter;
+        bool down;
+        bool queued;
+        uint32_t ticks;
+    };
+
+    class VerificationTimer : public Timer
+    {
+    public:
+        explicit VerificationTimer(SimulatedPeripheral& peripheral) : _peripheral(peripheral) {}
+        void fire() override { _peripheral.completeVerification(); }
+
+    private:
+        SimulatedPeripheral& _peripheral;
+    };
+
+    void record(bool down);
+    void completeVerification();
+    void startSession();
+    void trySend();
+    void send(Packet& packet);
+
+    void linkDidConnect(SimulatedLink& link);
+    void linkDidDisconnect();
+    void linkDidReceive(const uint8_t* data, size_t size);
+
+    Scheduler& _scheduler;
+    ChaskeyKey _longTermKey;
+    PacketSigner _signer;
+    uint64_t _random;
+    uint32_t _tickOffset;
+
+    SimulatedLink* _link = nullptr;
+    SimulatedLink* _attachedLink = nullptr;
+    bool _inRange = true;
+    bool _verified = false;
+    size_t _inFlight = 0;
+    uint8_t _ackWindow = 1;
+    bool _draining = false;
+    int _rssi = -60;
+    double _rssiNoise = 0;
+    uint64_t _rssiRandom;
+    uint64_t _attributeLayout = 1;
+    Timestamp _verificationTime = 0;
+    VerificationTimer _verificationTimer;
+    Packet _verifyResponse;
+    uint8_t _sessionKey[kSessionKeySize] = {};
+    ResumptionTicket _ticket;
+    unsigned _fullVerifications = 0;
+    unsigned _resumptions = 0;
+
+    uint32_t _pressCounter = 0;
+    std::deque<Record> _pending;
+    unsigned _ledIndications = 0;
+    unsigned _rejectedPackets = 0;
+};
+
+/*!
+ *  @struct LinkParameters
+ *
+ *  @discussion Timing of a SimulatedLink. <code>latency</code> is the one way delay of every packet and
+ *              <code>connectDelay</code> the time from a connect request to an established link while in range. Once the
+ *              link is up, service discovery takes <code>discoveryRoundTrips</code> and subscribing to notifications
+ *              <code>subscriptionRoundTrips</code> round trips before the transport reports the connection; both are 0
+ *              by default, a real flic needs 2 and 1.
+ *
+ */
+struct LinkParameters
+{
+    Timestamp latency = 15 * kNanosPerMilli;
+    Timestamp connectDelay = 50 * kNanosPerMilli;
+    unsigned discoveryRoundTrips = 0;
+    unsigned subscriptionRoundTrips = 0;
+
+    /** The interval a link starts with and the shortest one the host grants. */
+    Timestamp initialConnectionInterval = 30 * kNanosPerMilli;
+    Timestamp minConnectionInterval = 15 * kNanosPerMilli;
+
+    /**
+     * When set packets wait for the next connection event the receiving side attends, as do RSSI readings, and
+     * <code>latency</code> is only the air and host stack delay on top of that. Otherwise the connection interval is negotiated and reported but does
+     * not affect timing.
+     */
+    bool modelsConnectionEvents = false;
+
+    /** Radio on time of a connection event without data and the added time per packet, for SimulatedLink::radioOnTime. */
+    Timestamp connectionEventDuration = 250 * 1000;
+    Timestamp packetAirTime = 300 * 1000;
+};
+
+/*!
+ *  @class SimulatedLink
+ *
+ *  @discussion A Transport that connects a Button to a SimulatedPeripheral through the scheduler, with configurable delay.
+ *              Packets are delivered in order and packets and RSSI readings that are in flight when the link goes down
+ *              are lost, just like on a real connection. Packets the peripheral sends at the same time arrive together, up to
+ *              <code>kMaxBurst</code> of them, the way notifications queued for one connection event do.
+ *
+ */
+class SimulatedLink : public Transport
+{
+public:
+    SimulatedLink(Scheduler& scheduler, SimulatedPeripheral& peripheral, const LinkParameters& parameters = LinkParameters());
+    ~SimulatedLink() override;
+
+    void connect() override;
+    void disconnect() override;
+    void write(const uint8_t* data, size_t size) override;
+    void readRSSI() override;
+    bool isAdvertising() const override;
+    uint64_t attributeLayout() const override { return _attributeLayout; }
+    void setCachedAttributeLayout(uint64_t layout) override { _cachedAttributeLayout = layout; }
+    void setPipelinesSetup(bool pipelines) override { _pipelinesSetup = pipelines; }
+    void requestConnectionParameters(const ConnectionParameters& parameters) override;
+    Timestamp connectionInterval() const override { return _connected ? _interval : 0; }
+    uint16_t peripheralLatency() const override { return _connected ? _peripheralLatency : 0; }
+    Timestamp untilNextConnectionEvent() const override { return untilConnectionEvent(_peripheralLatency + 1); }
+
+    bool isConnected() const { return _connected; }
+    const LinkParameters& parameters() const { return _parameters; }
+    void setParameters(const LinkParameters& parameters) { _parameters = parameters; }
+
+    uint64_t packetsToPeripheral() const { return _packetsToPeripheral; }
+    uint64_t packetsToHost() const { return _packetsToHost; }
+    uint64_t discoveries() const { return _discoveries; }
+
+    /*!
+     *  @property radioOnTime
+     *
+     *  @discussion Estimated time the radio of the flic has been on for this link, counting the connection events it
+     *              attended and the packets it sent and received. Compare with <code>connectedTime</code> for its duty
+     *              cycle.
+     *
+     */
+    Timestamp radioOnTime() const;
+    Timestamp connectedTime() const;
+
+private:
+    friend class SimulatedPeripheral;
+
+    static const size_t kMaxBurst = 16;
+
+    enum class Kind
+    {
+        Connected,
+        SetUp,
+        ParametersUpdated,
+        Disconnected,
+        ToPeripheral,
+        ToHost,
+        RSSI,
+    };
+
+    class Delivery : public Timer
+    {
+    public:
+        void fire() override;
+
+        SimulatedLink* link = nullptr;
+        Kind kind = Kind::ToHost;
+        uint64_t generation = 0;
+        Error error = Error::None;
+        uint8_t count = 0;
+        uint8_t sizes[kMaxBurst];
+        uint8_t data[kMaxBurst][kMaxPacketSize];
+    };
+
+    Delivery& post(Kind kind, Timestamp delay);
+    void deliver(Delivery& delivery);
+    void tryConnect();
+    void dropLink(Error error);
+
+    void linkDidComeUp();
+    void linkDidGoDown();
+    void applyRequestedParameters();
+    Timestamp untilConnectionEvent(uint64_t everyEvents) const;
+    uint64_t attendedIdleEvents() const;
+
+    void peripheralDidSend(const uint8_t* data, size_t size);
+    void peripheralDidLeaveRange();
+    void peripheralDidEnterRange();
+
+    Scheduler& _scheduler;
+    SimulatedPeripheral& _peripheral;
+    LinkParameters _parameters;
+
+    bool _pendingConnect = false;
+    bool _connecting = false;
+    bool _connected = false;
+    bool _pipelinesSetup = false;
+    uint64_t _attributeLayout = 0;
+    uint64_t _cachedAttributeLayout = 0;
+    uint64_t _discoveries = 0;
+    Timestamp _interval = 0;
+    uint16_t _peripheralLatency = 0;
+    ConnectionParameters _requestedParameters;
+    Timestamp _anchor = 0;
+    uint64_t _accountedEvents = 0;
+    Timestamp _radioOnTime = 0;
+    Timestamp _connectedSince = 0;
+    Timestamp _connectedTime = 0;
+    uint64_t _generation = 0;
+    uint64_t _packetsToPeripheral = 0;
+    uint64_t _packetsToHost = 0;
+
+    std::vector<std::unique_ptr<Delivery>> _deliveries;
+    std::vector<Delivery*> _freeDeliveries;
+    Delivery* _burst = nullptr;
+    Timestamp _burstSentAt = 0;
+};
+
+/*!
+ *  @struct ConnectionTraceOptions
+ *
+ *  @discussion The connection settings a press trace is run with by runConnectionTrace. The link always models
+ *              connection events, <code>link.latency</code> is the fixed air and host stack delay.
+ *
+ */
+struct ConnectionTraceOptions
+{
+    ConnectionProfile profile = ConnectionProfile::Balanced;
+    bool adaptiveLatency = false;
+    Timestamp adaptiveIdleTimeout = 10 * kNanosPerSecond;
+    LinkParameters link;
+};
+
+/*!
+ *  @struct ConnectionTraceStats
+ *
+ *  @discussion What a press trace cost with the given connection settings. <code>addedLatency</code> sums, over the
+ *              down and up transitions that were delivered in real time, how long each waited for a connection event,
+ *              i.e. its delivery latency beyond the fixed link latency. <code>radioOnTime</code> and
+ *              <code>connectedTime</code> are those of SimulatedLink over the trace.
+ *
+ */
+struct ConnectionTraceStats
+{
+    size_t transitions = 0;
+    Timestamp addedLatency = 0;
+    Timestamp maxAddedLatency = 0;
+    Timestamp radioOnTime = 0;
+    Timestamp connectedTime = 0;
+
+    Timestamp averageAddedLatency() const { return transitions ? addedLatency / (Timestamp)transitions : 0; }
+    double dutyCycle() const { return connectedTime ? (double)radioOnTime / (double)connectedTime : 0; }
+};
+
+/*!
+ *  @method runConnectionTrace:transitions:count:
+ *
+ *  @discussion Replays the down and up transitions of a press trace, recorded or made up, on a simulated flic that is
+ *              connected for the whole trace, in virtual time. Meant for comparing connection profiles and adaptive
+ *              latency settings on real click patterns, see pressTransitionsFromTrace for getting them out of a
+ *              TraceRecorder trace.
+ *
+ */
+ConnectionTraceStats runConnectionTrace(const ConnectionTraceOptions& options, const PressTransition* transitions,
+                                        size_t count);
+
+} // namespace flic
+} // namespace scl
+
+#endif // SCL_FLIC_SIMULATED_PERIPHERAL_H
@@ -0,0 +1,379 @@
+//
+//  @file Trace.cpp
+//  @framework fliclib-core
+//
+//  Copyright (c) 2016-2026 Shortcut Labs. All rights reserved.
+//
+
+#include "Trace.h"
+
+#include <algorithm>
+#include <cstdio>
+
+namespace scl {
+namespace flic {
+
+const uint8_t TraceRecorder::kVersion;
+const uint8_t TraceRecorder::kOldestVersion;
+const size_t TraceRecorder::kHeaderSize;
+
+namespace {
+
+const uint8_t kMagic[4] = { 'F', 'L', 'T', 'R' };
+
+void appendLittleEndian(std::vector<uint8_t>& data, uint64_t value)
+{
+    for (size_t i = 0; i < 8; i++)
+    {
+        data.push_back((uint8_t)(value >> (i * 8)));
+    }
+}
+
+uint64_t readLittleEndian(const uint8_t* data)
+{
+    uint64_t value = 0;
+    for (size_t i = 0; i < 8; i++)
+    {
+        value |= (uint64_t)data[i] << (i * 8);
+    }
+    return value;
+}
+
+// Errors range from -1 to a few hundred, stored offset by one so that they fit a byte.
+uint8_t encodeError(Error error)
+{
+    return (uint8_t)((int)error + 1);
+}
+
+Error decodeError(uint8_t value)
+{
+    return (Error)((int)value - 1);
+}
+
+class TraceReader
+{
+public:
+    TraceReader(const uint8_t* data, size_t size) : _data(data), _size(size) {}
+
+    bool atEnd() const { return _offset == _size; }
+
+    bool readByte(uint8_t& value)
+    {
+        if (_offset == _size)
+        {
+            return false;
+        }
+        value = _data[_offset++];
+        return true;
+    }
+
+    bool readVarint(uint64_t& value)
+    {
+        value = 0;
+        for (unsigned shift = 0; shift < 64; shift += 7)
+        {
+            uint8_t byte;
+            if (!readByte(byte))
+            {
+                return false;
+            }
+            value |= (uint64_t)(byte & 0x7f) << shift;
+            if (!(byte & 0x80))
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    const uint8_t* readBytes(size_t count)
+    {
+        if (_size - _offset < count)
+        {
+            return nullptr;
+        }
+        const uint8_t* bytes = _data + _offset;
+        _offset += count;
+        return bytes;
+    }
+
+private:
+    const uint8_t* _data;
+    size_t _size;
+    size_t _offset = 0;
+};
+
+} // namespace
+
+void TraceRecorder::begin(Timestamp time, uint64_t nonceState)
+{
+    if (hasStarted())
+    {
+        return;
+    }
+    _data.insert(_data.end(), kMagic, kMagic + sizeof(kMagic));
+    _data.push_back(kVersion);
+    appendLittleEndian(_data, (uint64_t)time);
+    appendLittleEndian(_data, nonceState);
+    _lastTime = time;
+}
+
+void TraceRecorder::appendRecord(Kind kind, Timestamp time)
+{
+    _data.push_back(kind);
+    uint64_t delta = time > _lastTime ? (uint64_t)(time - _lastTime) : 0;
+    _lastTime += (Timestamp)delta;
+    while (delta >= 0x80)
+    {
+        _data.push_back((uint8_t)(delta | 0x80));
+        delta >>= 7;
+    }
+    _data.push_back((uint8_t)delta);
+}
+
+void TraceRecorder::recordConnected(Timestamp time)
+{
+    appendRecord(Connected, time);
+}
+
+void TraceRecorder::recordFailedToConnect(Timestamp time, Error error)
+{
+    appendRecord(FailedToConnect, time);
+    _data.push_back(encodeError(error));
+}
+
+void TraceRecorder::recordDisconnected(Timestamp time, Error error)
+{
+    appendRecord(Disconnected, time);
+    _data.push_back(encodeError(error));
+}
+
+void TraceRecorder::recordReceived(Timestamp time, const uint8_t* data, size_t size)
+{
+    if (size > kMaxPacketSize)
+    {
+        size = kMaxPacketSize;
+    }
+    appendRecord(Received, time);
+    _data.push_back((uint8_t)size);
+    _data.insert(_data.end(), data, data + size);
+}
+
+void TraceRecorder::recordRSSI(Timestamp time, int rssi, Error error, bool requested)
+{
+    appendRecord(requested ? ReadRSSI : SampledRSSI, time);
+    _data.push_back((uint8_t)(int8_t)rssi);
+    _data.push_back(encodeError(error));
+}
+
+bool TraceRecorder::saveToFile(const std::string& path) const
+{
+    FILE* file = fopen(path.c_str(), "wb");
+    if (!file)
+    {
+        return false;
+    }
+    bool written = fwrite(_data.data(), 1, _data.size(), file) == _data.size();
+    return fclose(file) == 0 && written;
+}
+
+bool loadTraceFile(const std::string& path, std::vector<uint8_t>& data)
+{
+    FILE* file = fopen(path.c_str(), "rb");
+    if (!file)
+    {
+        return false;
+    }
+    data.clear();
+    uint8_t buffer[4096];
+    size_t read;
+    while ((read = fread(buffer, 1, sizeof(buffer), file)) > 0)
+    {
+        data.insert(data.end(), buffer, buffer + read);
+    }
+    bool failed = ferror(file) != 0;
+    fclose(file);
+    return !failed;
+}
+
+Error TraceReplay::load(const uint8_t* data, size_t size)
+{
+    _button.reset();
+    _scheduler.reset();
+    _data = nullptr;
+    _size = 0;
+    _recordCount = 0;
+    _duration = 0;
+
+    TraceReader reader(data, size);
+    const uint8_t* header = reader.readBytes(TraceRecorder::kHeaderSize);
+    if (!header)
+    {
+        return Error::MissingData;
+    }
+    if (!std::equal(kMagic, kMagic + sizeof(kMagic), header) || header[4] < TraceRecorder::kOldestVersion ||
+        header[4] > TraceRecorder::kVersion)
+    {
+        return Error::UnknownDataReceived;
+    }
+
+    size_t records = 0;
+    Timestamp duration = 0;
+    while (!reader.atEnd())
+    {
+        uint8_t kind;
+        uint64_t delta;
+        reader.readByte(kind);
+        if (!reader.readVarint(delta))
+        {
+            return Error::MissingData;
+        }
+        duration += (Timestamp)delta;
+        size_t payload = 0;
+        switch (kind)
+        {
+            case TraceRecorder::Connected:
+                break;
+            case TraceRecorder::FailedToConnect:
+            case TraceRecorder::Disconnected:
+                payload = 1;
+                break;
+            case TraceRecorder::ReadRSSI:
+            case TraceRecorder::SampledRSSI:
+                payload = 2;
+                break;
+            case TraceRecorder::Received:
+            {
+                uint8_t packetSize;
+                if (!reader.readByte(packetSize))
+                {
+                    return Error::MissingData;
+                }
+                if (packetSize > kMaxPacketSize)
+                {
+                    return Error::UnknownDataReceived;
+                }
+                payload = packetSize;
+                break;
+            }
+            default:
+                return Error::UnknownDataReceived;
+        }
+        if (!reader.readBytes(payload))
+        {
+            return Error::MissingData;
+        }
+        records++;
+    }
+
+    _data = data;
+    _size = size;
+    _recordCount = records;
+    _duration = duration;
+    _scheduler.reset(new ManualScheduler((Timestamp)readLittleEndian(header + 5)));
+    _button.reset(new Button(_info, _transport, *_scheduler));
+    _button->_nonceState = readLittleEndian(header + 13);
+    return Error::None;
+}
+
+size_t TraceReplay::run()
+{
+    if (!_button)
+    {
+        return 0;
+    }
+    TraceReader reader(_data, _size);
+    reader.readBytes(TraceRecorder::kHeaderSize);
+
+    // The recording started at a connect, which the button only accepts while it wants a connection.
+    _button->connect();
+    TransportListener& listener = *_button;
+    Timestamp time = _scheduler->now();
+    size_t replayed = 0;
+    while (!reader.atEnd())
+    {
+        uint8_t kind;
+        uint64_t delta;
+        reader.readByte(kind);
+        reader.readVarint(delta);
+        time += (Timestamp)delta;
+        _scheduler->advanceTo(time);
+
+        uint8_t value = 0;
+        switch (kind)
+        {
+            case TraceRecorder::Connected:
+                listener.transportDidConnect();
+                break;
+            case TraceRecorder::FailedToConnect:
+                reader.readByte(value);
+                listener.transportDidFailToConnect(decodeError(value));
+                break;
+            case TraceRecorder::Disconnected:
+                reader.readByte(value);
+                listener.transportDidDisconnect(decodeError(value));
+                break;
+            case TraceRecorder::ReadRSSI:
+            case TraceRecorder::SampledRSSI:
+            {
+                uint8_t rssi = 0;
+                reader.readByte(rssi);
+                reader.readByte(value);
+                _button->receiveRSSI((int8_t)rssi, decodeError(value), kind == TraceRecorder::ReadRSSI);
+                break;
+            }
+            case TraceRecorder::Received:
+            {
+                reader.readByte(value);
+                listener.transportDidReceive(reader.readBytes(value), value);
+                break;
+            }
+        }
+        replayed++;
+    }
+    // No reading arrives after the end of the trace, and the sampling timer of a subscription would keep the scheduler
+    // busy for good.
+    _scheduler->cancel(_button->_rssiSampleTimer);
+    _scheduler->runUntilIdle();
+    return replayed;
+}
+
+namespace {
+
+class TransitionCollector : public ButtonDelegate
+{
+public:
+    explicit TransitionCollector(std::vector<PressTransition>& transitions) : _transitions(transitions) {}
+
+    void didReceiveButtonDown(Button& button, bool queued, long age) override { collect(button, true); }
+    void didReceiveButtonUp(Button& button, bool queued, long age) override { collect(button, false); }
+
+private:
+    void collect(Button& button, bool down)
+    {
+        _transitions.push_back(PressTransition { button.currentEventTime().eventTime, down });
+    }
+
+    std::vector<PressTransition>& _transitions;
+};
+
+} // namespace
+
+Error pressTransitionsFromTrace(const ButtonInfo& info, const uint8_t* data, size_t size,
+                                std::vector<PressTransition>& transitions)
+{
+    TraceReplay replay(info);
+    Error error = replay.load(data, size);
+    if (error != Error::None)
+    {
+        return error;
+    }
+    TransitionCollector collector(transitions);
+    replay.button().setDelegate(&collector);
+    replay.run();
+    replay.button().setDelegate(nullptr);
+    return Error::None;
+}
+
+} // namespace flic
+} // namespace scl
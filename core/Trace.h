@@ -0,0 +1,188 @@
+//
+//  @file Trace.h
+//  @framework fliclib-core
+//
+//  Copyright (c) 2016-2026 Shortcut Labs. All rights reserved.
+//
+
+#ifndef SCL_FLIC_TRACE_H
+#define SCL_FLIC_TRACE_H
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "Button.h"
+#include "Scheduler.h"
+#include "Transport.h"
+
+namespace scl {
+namespace flic {
+
+/*!
+ *  @class TraceRecorder
+ *
+ *  @discussion Records the link level input of one Button, i.e. connects, disconnects, RSSI readings and the raw packets
+ *              exactly as they were received, together with the scheduler time at which each of them arrived.
+ *              <br/><br/>
+ *              The trace format is compact and little endian. A 21 byte header holds the magic <code>FLTR</code>, a
+ *              version byte, the time of the first connect and the nonce generator state of the button at that point.
+ *              Each record that follows is a kind byte, the time since the previous record as an unsigned LEB128
+ *              varint in nanoseconds and a kind specific payload of at most 21 bytes. A button event costs about 25
+ *              bytes.
+ *              <br/><br/>
+ *              Recording starts at the first connect after the recorder is attached, so that a replay sees the same
+ *              verification handshake. That connection always does a full verification, later ones in the trace may be
+ *              resumed. The trace does not contain any key material, replaying it requires the long term key of the
+ *              button.
+ *
+ */
+class TraceRecorder
+{
+public:
+    /** Version 2 added SampledRSSI records. */
+    static const uint8_t kVersion = 2;
+    static const uint8_t kOldestVersion = 1;
+    static const size_t kHeaderSize = 21;
+
+    bool hasStarted() const { return !_data.empty(); }
+    const std::vector<uint8_t>& data() const { return _data; }
+    void clear() { _data.clear(); }
+
+    /*!
+     *  @method saveToFile:
+     *
+     *  @return false if the file could not be written.
+     *
+     */
+    bool saveToFile(const std::string& path) const;
+
+private:
+    friend class Button;
+    friend class TraceReplay;
+
+    enum Kind : uint8_t
+    {
+        Connected = 1,
+        FailedToConnect,
+        Disconnected,
+        Received,
+        /** A reading that answers ButtonDelegate readRSSI and is reported through didUpdateRSSI. */
+        ReadRSSI,
+        /** A reading nobody asked for through readRSSI: a sample of an RSSI subscription or a reading for the manager. */
+        SampledRSSI,
+    };
+
+    void begin(Timestamp time, uint64_t nonceState);
+    void recordConnected(Timestamp time);
+    void recordFailedToConnect(Timestamp time, Error error);
+    void recordDisconnected(Timestamp time, Error error);
+    void recordReceived(Timestamp time, const uint8_t* data, size_t size);
+    void recordRSSI(Timestamp time, int rssi, Error error, bool requested);
+    void appendRecord(Kind kind, Timestamp time);
+
+    std::vector<uint8_t> _data;
+    Timestamp _lastTime = 0;
+};
+
+/*!
+ *  @method loadTraceFile:data:
+ *
+ *  @return false if the file could not be read.
+ *
+ */
+bool loadTraceFile(const std::string& path, std::vector<uint8_t>& data);
+
+/*!
+ *  @class TraceReplay
+ *
+ *  @discussion Feeds a recorded trace back through a fresh Button, so that the packet decoder, signature verification,
+ *              the classifier and delegate dispatch all run exactly as they did when the trace was recorded. Time is
+ *              virtual, a replay runs as fast as the core can process the packets.
+ *              <br/><br/>
+ *              Writes of the button go nowhere. The button is configured (delegate, trigger behavior, RSSI subscription,
+ *              ...) between <code>load</code> and <code>run</code>. RSSI readings are replayed as what they were
+ *              recorded as: those that answered <code>readRSSI</code> make a didUpdateRSSI, subscription samples only
+ *              feed the filter of a subscribed button. The sampling timer of the replayed button still fires but its
+ *              reads go nowhere, the recorded samples arrive at the times they did.
+ *
+ */
+class TraceReplay
+{
+public:
+    explicit TraceReplay(const ButtonInfo& info) : _info(info) {}
+
+    TraceReplay(const TraceReplay&) = delete;
+    TraceReplay& operator=(const TraceReplay&) = delete;
+
+    /*!
+     *  @method load:size:
+     *
+     *  @discussion Validates the trace and sets up a new scheduler and Button for it. The data must stay alive until
+     *              <code>run</code> returns.
+     *
+     *  @return <code>Error::None</code>, <code>Error::MissingData</code> for a truncated trace or
+     *          <code>Error::UnknownDataReceived</code> for anything else that is not a valid trace.
+     *
+     */
+    Error load(const uint8_t* data, size_t size);
+
+    /*!
+     *  @method run
+     *
+     *  @discussion Replays every record at its recorded time, then runs the scheduler until idle so that pending windows
+     *              resolve.
+     *
+     *  @return The number of records replayed.
+     *
+     */
+    size_t run();
+
+    Button& button() const { return *_button; }
+    ManualScheduler& scheduler() const { return *_scheduler; }
+    size_t recordCount() const { return _recordCount; }
+
+    /*!
+     *  @method duration
+     *
+     *  @return The time between the first and the last record.
+     *
+     */
+    Timestamp duration() const { return _duration; }
+
+private:
+    class ReplayTransport : public Transport
+    {
+    public:
+        void connect() override {}
+        void disconnect() override {}
+        void write(const uint8_t* data, size_t size) override { (void)data; (void)size; }
+        void readRSSI() override {}
+    };
+
+    ButtonInfo _info;
+    ReplayTransport _transport;
+    std::unique_ptr<ManualScheduler> _scheduler;
+    std::unique_ptr<Button> _button;
+    const uint8_t* _data = nullptr;
+    size_t _size = 0;
+    size_t _recordCount = 0;
+    Timestamp _duration = 0;
+};
+
+/*!
+ *  @method pressTransitionsFromTrace:data:size:transitions:
+ *
+ *  @discussion Replays a trace and collects the down and up transitions of the button at the times the flic says they
+ *              happened, queued ones included, for runConnectionTrace or runClassifierTrace.
+ *
+ *  @return The error of TraceReplay::load.
+ *
+ */
+Error pressTransitionsFromTrace(const ButtonInfo& info, const uint8_t* data, size_t size,
+                                std::vector<PressTransition>& transitions);
+
+} // namespace flic
+} // namespace scl
+
+#endif // SCL_FLIC_TRACE_H
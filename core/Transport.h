@@ -0,0 +1,209 @@
+//
+//  @file Transport.h
+//  @framework fliclib-core
+//
+//  Copyright (c) 2016-2026 Shortcut Labs. All rights reserved.
+//
+
+#ifndef SCL_FLIC_TRANSPORT_H
+#define SCL_FLIC_TRANSPORT_H
+
+#include "Types.h"
+
+namespace scl {
+namespace flic {
+
+/*!
+ *  @struct ConnectionParameters
+ *
+ *  @discussion The connection parameters requested for a link, in the ranges of the Bluetooth connection parameter update
+ *              procedure. The host picks the interval within <code>minInterval</code> and <code>maxInterval</code>. A
+ *              flic with nothing to send may sleep through <code>peripheralLatency</code> connection events in a row.
+ *
+ */
+struct ConnectionParameters
+{
+    Timestamp minInterval = 0;
+    Timestamp maxInterval = 0;
+    uint16_t peripheralLatency = 0;
+    Timestamp supervisionTimeout = 0;
+};
+
+/*!
+ *  @method connectionParameters
+ *
+ *  @discussion The parameters of a profile. The intervals follow the Apple accessory design guidelines: 15 ms is the
+ *              shortest interval iOS grants, and with peripheral latency the longest effective interval stays below 2 s.
+ *
+ */
+inline ConnectionParameters connectionParameters(ConnectionProfile profile)
+{
+    const Timestamp ms = kNanosPerMilli;
+    switch (profile)
+    {
+        case ConnectionProfile::Gaming:
+            return { 15 * ms, 15 * ms, 0, 2000 * ms };
+        case ConnectionProfile::Kiosk:
+            return { 30 * ms, 45 * ms, 0, 4000 * ms };
+        case ConnectionProfile::Battery:
+            return { 150 * ms, 300 * ms, 4, 6000 * ms };
+        case ConnectionProfile::Balanced:
+        default:
+            return { 45 * ms, 75 * ms, 2, 6000 * ms };
+    }
+}
+
+/*!
+ *  @struct ReceivedPacket
+ *
+ *  @discussion One packet of a burst handed to TransportListener::transportDidReceivePackets.
+ *
+ */
+struct ReceivedPacket
+{
+    const uint8_t* data;
+    size_t size;
+};
+
+/*!
+ *  @protocol TransportListener
+ *
+ *  @discussion Receives the link level callbacks of a Transport. All callbacks are made on the scheduler that drives the
+ *              core, never re-entrantly from inside a Transport method.
+ *
+ */
+class TransportListener
+{
+public:
+    virtual ~TransportListener() = default;
+
+    virtual void transportDidConnect() = 0;
+    virtual void transportDidFailToConnect(Error error) = 0;
+
+    /*!
+     *  @discussion <code>error</code> is <code>Error::None</code> if the disconnect was requested through
+     *              Transport::disconnect.
+     *
+     */
+    virtual void transportDidDisconnect(Error error) = 0;
+    virtual void transportDidReceive(const uint8_t* data, size_t size) = 0;
+
+    /*!
+     *  @discussion Packets that arrived together, typically notifications queued during one connection event. The
+     *              default passes them to <code>transportDidReceive</code> one by one.
+     *
+     */
+    virtual void transportDidReceivePackets(const ReceivedPacket* packets, size_t count)
+    {
+        for (size_t i = 0; i < count; i++)
+        {
+            transportDidReceive(packets[i].data, packets[i].size);
+        }
+    }
+    virtual void transportDidReadRSSI(int rssi, Error error) = 0;
+};
+
+/*!
+ *  @class Transport
+ *
+ *  @discussion The link to one physical flic. On iOS this wraps a CBPeripheral and its characteristics, on Linux the
+ *              SimulatedPeripheral provides one. A transport carries whole packets and knows nothing about their content.
+ *
+ */
+class Transport
+{
+public:
+    virtual ~Transport() = default;
+
+    void setListener(TransportListener* listener) { _listener = listener; }
+    TransportListener* listener() const { return _listener; }
+
+    /*!
+     *  @method connect
+     *
+     *  @discussion Starts a pending connection. Like the Core Bluetooth equivalent this never times out.
+     *
+     */
+    virtual void connect() = 0;
+
+    /*!
+     *  @method disconnect
+     *
+     *  @discussion Disconnects the link or cancels a pending connection.
+     *
+     */
+    virtual void disconnect() = 0;
+
+    virtual void write(const uint8_t* data, size_t size) = 0;
+    virtual void readRSSI() = 0;
+
+    /*!
+     *  @method isAdvertising
+     *
+     *  @discussion Whether the flic has been seen advertising while not connected, which it does when it has events to
+     *              deliver. Transports that do not scan always report false.
+     *
+     */
+    virtual bool isAdvertising() const { return false; }
+
+    /*!
+     *  @property attributeLayout
+     *
+     *  @discussion Identifies the service and characteristic layout found on the current or last connection, 0 if none
+     *              is known. Given an earlier layout through <code>setCachedAttributeLayout</code> a transport skips
+     *              service discovery while the flic still has that layout, and discovers as usual when it does not.
+     *
+     */
+    virtual uint64_t attributeLayout() const { return 0; }
+    virtual void setCachedAttributeLayout(uint64_t layout) {}
+
+    /*!
+     *  @method setPipelinesSetup:
+     *
+     *  @discussion When enabled TransportListener::transportDidConnect is called as soon as the characteristics are known,
+     *              with the subscription to notifications still on its way. Writes are queued behind it, so nothing the
+     *              flic sends in response can be missed. By default the subscription is confirmed first.
+     *
+     */
+    virtual void setPipelinesSetup(bool pipelines) {}
+
+    /*!
+     *  @method requestConnectionParameters:
+     *
+     *  @discussion Asks the host for new connection parameters on the current link. The host has the last word and the
+     *              outcome shows up in <code>connectionInterval</code> and <code>peripheralLatency</code> once it has been
+     *              negotiated. Transports without control over the connection parameters ignore the request.
+     *
+     */
+    virtual void requestConnectionParameters(const ConnectionParameters& parameters) {}
+
+    /*!
+     *  @property connectionInterval
+     *
+     *  @discussion The negotiated connection interval of the current link, 0 when not connected or not known.
+     *
+     */
+    virtual Timestamp connectionInterval() const { return 0; }
+    virtual uint16_t peripheralLatency() const { return 0; }
+
+    /*!
+     *  @property untilNextConnectionEvent
+     *
+     *  @discussion How long until the next connection event the flic attends, the earliest a write reaches it or an RSSI
+     *              reading is taken. Transports that do not know where the events fall report the longest wait, one
+     *              connection interval per event the flic may sleep through plus one. 0 when not connected.
+     *
+     */
+    virtual Timestamp untilNextConnectionEvent() const
+    {
+        return connectionInterval() * (Timestamp)(peripheralLatency() + 1);
+    }
+
+private:
+    TransportListener* _listener = nullptr;
+};
+
+} // namespace flic
+} // namespace scl
+
+#endif // SCL_FLIC_TRANSPORT_H
@@ -0,0 +1,205 @@
+//
+//  @file Types.h
+//  @framework fliclib-core
+//
+//  Copyright (c) 2016-2026 Shortcut Labs. All rights reserved.
+//
+
+#ifndef SCL_FLIC_TYPES_H
+#define SCL_FLIC_TYPES_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace scl {
+namespace flic {
+
+/*!
+ *  @typedef Timestamp
+ *
+ *  @discussion Host time in nanoseconds as reported by the Scheduler that drives the core. The epoch is arbitrary, only
+ *              differences are meaningful.
+ *
+ */
+typedef int64_t Timestamp;
+
+static const Timestamp kNanosPerMilli = 1000000;
+static const Timestamp kNanosPerSecond = 1000000000;
+
+/*!
+ *  @discussion The flic keeps time using a 32768 Hz real time counter. Event timestamps sent over the air are expressed in
+ *              these ticks and wrap around roughly every 36 hours.
+ *
+ */
+static const uint32_t kButtonTicksPerSecond = 32768;
+
+inline Timestamp buttonTicksToNanos(uint32_t ticks)
+{
+    return (Timestamp)ticks * kNanosPerSecond / kButtonTicksPerSecond;
+}
+
+inline uint32_t nanosToButtonTicks(Timestamp time)
+{
+    return (uint32_t)((time / kNanosPerSecond) * kButtonTicksPerSecond +
+                      (time % kNanosPerSecond) * kButtonTicksPerSecond / kNanosPerSecond);
+}
+
+/*!
+ *  @struct EventTime
+ *
+ *  @discussion High resolution timing of a delivered event, computed once when the packet is decoded.
+ *              <code>buttonTicks</code> is the flic clock at the moment the event happened and is strictly monotonic per
+ *              button (modulo wrap around), <code>eventTime</code> is the same instant in host time and
+ *              <code>receivedTime</code> is the host time at which the packet was received, or at which the double
+ *              click/hold window expired for events produced that way. The sub-second age of the event is
+ *              <code>receivedTime - eventTime</code>.
+ *
+ */
+struct EventTime
+{
+    uint32_t buttonTicks = 0;
+    Timestamp eventTime = 0;
+    Timestamp receivedTime = 0;
+};
+
+/*!
+ *  @enum ConnectionState
+ *
+ *  @discussion Mirrors SCLFlicButtonConnectionState.
+ *
+ */
+enum class ConnectionState : int
+{
+    Connected = 0,
+    Connecting,
+    Disconnected,
+    Disconnecting,
+};
+
+/*!
+ *  @enum LEDIndicateCount
+ *
+ *  @discussion Mirrors SCLFlicButtonLEDIndicateCount.
+ *
+ */
+enum class LEDIndicateCount : int
+{
+    Count1 = 1,
+    Count2,
+    Count3,
+    Count4,
+    Count5,
+};
+
+/*!
+ *  @enum TriggerBehavior
+ *
+ *  @discussion Mirrors SCLFlicButtonTriggerBehavior. See SCLFlicButton.h for the exact timing rules of each behavior.
+ *
+ */
+enum class TriggerBehavior : int
+{
+    ClickAndHold = 0,
+    ClickAndDoubleClick,
+    ClickAndDoubleClickAndHold,
+    Click,
+};
+
+/*!
+ *  @enum ConnectionProfile
+ *
+ *  @discussion The connection parameters a Button asks for, from the shortest connection interval to the longest. The
+ *              interval is the longest a click waits on the flic before it can be sent, while the radio of an idle flic
+ *              wakes up once every interval times one plus the peripheral latency. See connectionParameters for the
+ *              values.
+ *
+ */
+enum class ConnectionProfile : int
+{
+    /** The default, equivalent to the regular latency setting of the Flic app. */
+    Balanced = 0,
+    /** The shortest interval the host allows, for foreground games. Replaces <code>lowLatency</code>. */
+    Gaming,
+    /** A short interval without the power cost of Gaming, for buttons that are pressed often, such as in a kiosk. */
+    Kiosk,
+    /** A long interval with peripheral latency, for buttons that are rarely pressed and where a click may take longer. */
+    Battery,
+};
+
+static const size_t kConnectionProfileCount = 4;
+
+/*!
+ *  @enum EventType
+ *
+ *  @discussion The button events that are delivered to a ButtonDelegate.
+ *
+ */
+enum class EventType : uint8_t
+{
+    ButtonDown = 0,
+    ButtonUp,
+    ButtonClick,
+    ButtonDoubleClick,
+    ButtonHold,
+    /** Only produced by a classifier in speculative mode, see Classifier::setSpeculative. */
+    ButtonProvisionalClick,
+};
+
+static const size_t kEventTypeCount = 6;
+
+/*!
+ *  @typedef EventMask
+ *
+ *  @discussion A set of event types, one bit per EventType as given by <code>eventMaskOf</code>.
+ *
+ */
+typedef uint8_t EventMask;
+
+static const EventMask kAllEvents = (EventMask)((1 << kEventTypeCount) - 1);
+
+inline EventMask eventMaskOf(EventType type)
+{
+    return (EventMask)(1 << (int)type);
+}
+
+/*!
+ *  @enum Error
+ *
+ *  @discussion Mirrors SCLFlicError and uses the same numeric values so that codes can be passed straight through to an
+ *              NSError. <code>None</code> is used where the Objective-C API would pass a nil error.
+ *
+ */
+enum class Error : int
+{
+    None = -1,
+    Unknown = 0,
+    CouldNotForgetButton = 1,
+    ConnectionFailed = 2,
+    CouldNotUpdateRSSI = 3,
+    UnknownDataReceived = 5,
+    CryptographicFailure = 11,
+    MissingData = 13,
+    InvalidSignature = 14,
+    ButtonAlreadyGrabbed = 15,
+    IllegalVerificationResponse = 31,
+    CouldNotDiscoverServices = 33,
+    ConnectionRetryLimitReached = 34,
+    BluetoothErrorUnknown = 100,
+    BluetoothErrorInvalidParameters = 101,
+    BluetoothErrorInvalidHandle = 102,
+    BluetoothErrorNotConnected = 103,
+    BluetoothErrorOutOfSpace = 104,
+    BluetoothErrorOperationCancelled = 105,
+    BluetoothErrorConnectionLost = 106,
+    BluetoothErrorPeripheralDisconnected = 107,
+    BluetoothErrorUUIDNotAllowed = 108,
+    BluetoothErrorAlreadyAdvertising = 109,
+    BluetoothErrorConnectionFailed = 110,
+    BluetoothErrorConnectionLimitReached = 111,
+    FlicRefusedConnection = 200,
+};
+
+} // namespace flic
+} // namespace scl
+
+#endif // SCL_FLIC_TYPES_H
@@ -0,0 +1,77 @@
+//
+//  @file ButtonTests.cpp
+//  @framework fliclib-core
+//
+//  Copyright (c) 2016-2026 Shortcut Labs. All rights reserved.
+//
+
+#include "Test.h"
+
+#include <cstring>
+#include <memory>
+
+#include "Button.h"
+#include "SimulatedPeripheral.h"
+
+using namespace scl::flic;
+
+namespace {
+
+const uint8_t kLongTermKey[ChaskeyKey::kKeySize] = { 1, 4, 1, 4, 2, 1, 3, 5, 6, 2, 3, 7, 3, 0, 9, 5 };
+
+ButtonInfo makeInfo()
+{
+    ButtonInfo info;
+    info.identifier = "button-test";
+    memcpy(info.longTermKey, kLongTermKey, sizeof(kLongTermKey));
+    return info;
+}
+
+class PressCountObserver : public ButtonStateObserver
+{
+public:
+    void buttonDidChangeConnectionState(Button& button, ConnectionState previous) override {}
+    void buttonDidUpdatePressCount(Button& button) override { updates++; }
+
+    unsigned updates = 0;
+};
+
+} // namespace
+
+TEST(Button, RestoredPressCountDropsResentEvents)
+{
+    ManualScheduler scheduler;
+    SimulatedPeripheral peripheral(scheduler, kLongTermKey, 5);
+    SimulatedLink link(scheduler, peripheral);
+    std::unique_ptr<Button> button(new Button(makeInfo(), link, scheduler));
+    button->connect();
+    scheduler.runUntilIdle();
+    REQUIRE(button->isReady());
+
+    // The events reach the host, but the link goes before the ack reaches the flic.
+    peripheral.press();
+    peripheral.release();
+    scheduler.advanceBy(link.parameters().latency);
+    CHECK_EQ(button->pressCount(), 2);
+    peripheral.setInRange(false);
+    scheduler.runUntilIdle();
+    REQUIRE(peripheral.queuedEvents() == 2);
+
+    // The app starts over from the press count it persisted, and the flic sends the events again.
+    button.reset(new Button(makeInfo(), link, scheduler));
+    PressCountObserver observer;
+    button->setStateObserver(&observer);
+    button->restorePressCount(2);
+    peripheral.setInRange(true);
+    button->connect();
+    scheduler.runUntilIdle();
+    REQUIRE(button->isReady());
+    CHECK_EQ(observer.updates, 0u);
+    CHECK_EQ(button->pressCount(), 2);
+    CHECK_EQ(peripheral.queuedEvents(), 0u);
+
+    peripheral.press();
+    scheduler.runUntilIdle();
+    CHECK_EQ(observer.updates, 1u);
+    CHECK_EQ(button->pressCount(), 3);
+}
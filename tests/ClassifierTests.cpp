@@ -0,0 +1,191 @@
+//
+//  @file ClassifierTests.cpp
+//  @framework fliclib-core
+//
+//  Copyright (c) 2016-2026 Shortcut Labs. All rights reserved.
+//
+
+#include "Test.h"
+
+#include <vector>
+
+#include "Classifier.h"
+
+using namespace scl::flic;
+
+namespace {
+
+const Timestamp kMs = kNanosPerMilli;
+const Timestamp kStart = 1000 * kMs;
+
+struct Emitted
+{
+    EventType type;
+    Timestamp time;
+    bool queued;
+};
+
+class Recorder : public ClassifierListener
+{
+public:
+    void classifierDidEmit(EventType type, Timestamp time, bool queued) override
+    {
+        events.push_back({ type, time, queued });
+    }
+
+    std::vector<Emitted> events;
+};
+
+} // namespace
+
+TEST(Classifier, HoldFiresExactlyAtThreshold)
+{
+    Recorder recorder;
+    Classifier classifier(recorder);
+    classifier.buttonDown(kStart, false);
+    CHECK_EQ(classifier.deadline(), kStart + Classifier::kHoldThreshold);
+
+    classifier.expire(kStart + Classifier::kHoldThreshold - 1);
+    CHECK(recorder.events.empty());
+    classifier.expire(kStart + Classifier::kHoldThreshold);
+    REQUIRE(recorder.events.size() == 1);
+    CHECK_EQ(recorder.events[0].type, EventType::ButtonHold);
+    CHECK_EQ(recorder.events[0].time, kStart + Classifier::kHoldThreshold);
+
+    // The release of a hold emits nothing more.
+    classifier.buttonUp(kStart + 1500 * kMs, false);
+    CHECK_EQ(recorder.events.size(), 1u);
+}
+
+TEST(Classifier, ReleaseJustBeforeThresholdIsClick)
+{
+    Recorder recorder;
+    Classifier classifier(recorder);
+    classifier.buttonDown(kStart, false);
+    classifier.buttonUp(kStart + Classifier::kHoldThreshold - 1, false);
+    REQUIRE(recorder.events.size() == 1);
+    CHECK_EQ(recorder.events[0].type, EventType::ButtonClick);
+    CHECK_EQ(classifier.deadline(), -1);
+}
+
+TEST(Classifier, SecondPressInsideWindowIsDoubleClick)
+{
+    Recorder recorder;
+    Classifier classifier(recorder);
+    classifier.setBehavior(TriggerBehavior::ClickAndDoubleClick);
+    classifier.buttonDown(kStart, false);
+    classifier.buttonUp(kStart + 100 * kMs, false);
+    CHECK(recorder.events.empty());
+    CHECK_EQ(classifier.deadline(), kStart + Classifier::kDoubleClickWindow);
+
+    classifier.buttonDown(kStart + Classifier::kDoubleClickWindow - 1, false);
+    classifier.buttonUp(kStart + 600 * kMs, false);
+    REQUIRE(recorder.events.size() == 1);
+    CHECK_EQ(recorder.events[0].type, EventType::ButtonDoubleClick);
+    CHECK_EQ(recorder.events[0].time, kStart + 600 * kMs);
+}
+
+TEST(Classifier, SecondPressAtWindowEndIsTwoClicks)
+{
+    Recorder recorder;
+    Classifier classifier(recorder);
+    classifier.setBehavior(TriggerBehavior::ClickAndDoubleClick);
+    classifier.buttonDown(kStart, false);
+    classifier.buttonUp(kStart + 100 * kMs, false);
+
+    // The window is closed at its deadline, so this press starts a new sequence.
+    classifier.buttonDown(kStart + Classifier::kDoubleClickWindow, false);
+    REQUIRE(recorder.events.size() == 1);
+    CHECK_EQ(recorder.events[0].type, EventType::ButtonClick);
+    CHECK_EQ(recorder.events[0].time, kStart + Classifier::kDoubleClickWindow);
+
+    classifier.buttonUp(kStart + 600 * kMs, false);
+    classifier.expire(kStart + 2 * Classifier::kDoubleClickWindow);
+    REQUIRE(recorder.events.size() == 2);
+    CHECK_EQ(recorder.events[1].type, EventType::ButtonClick);
+}
+
+TEST(Classifier, ReleaseAfterWindowIsImmediateClick)
+{
+    Recorder recorder;
+    Classifier classifier(recorder);
+    classifier.setBehavior(TriggerBehavior::ClickAndDoubleClick);
+    classifier.buttonDown(kStart, false);
+    classifier.buttonUp(kStart + Classifier::kDoubleClickWindow + 1, false);
+    REQUIRE(recorder.events.size() == 1);
+    CHECK_EQ(recorder.events[0].type, EventType::ButtonClick);
+    CHECK_EQ(recorder.events[0].time, kStart + Classifier::kDoubleClickWindow + 1);
+    CHECK_EQ(classifier.deadline(), -1);
+}
+
+TEST(Classifier, ClickBehaviorEmitsOnDown)
+{
+    Recorder recorder;
+    Classifier classifier(recorder);
+    classifier.setBehavior(TriggerBehavior::Click);
+    classifier.buttonDown(kStart, false);
+    REQUIRE(recorder.events.size() == 1);
+    CHECK_EQ(recorder.events[0].type, EventType::ButtonClick);
+    CHECK_EQ(recorder.events[0].time, kStart);
+
+    // Neither holding nor releasing adds anything.
+    CHECK_EQ(classifier.deadline(), -1);
+    classifier.buttonUp(kStart + 2 * Classifier::kHoldThreshold, false);
+    CHECK_EQ(recorder.events.size(), 1u);
+}
+
+TEST(Classifier, SpeculativeClickIsConfirmedOrReplaced)
+{
+    Recorder recorder;
+    Classifier classifier(recorder);
+    classifier.setBehavior(TriggerBehavior::ClickAndDoubleClickAndHold);
+    classifier.setSpeculative(true);
+
+    classifier.buttonDown(kStart, false);
+    classifier.buttonUp(kStart + 80 * kMs, false);
+    REQUIRE(recorder.events.size() == 1);
+    CHECK_EQ(recorder.events[0].type, EventType::ButtonProvisionalClick);
+    CHECK_EQ(recorder.events[0].time, kStart + 80 * kMs);
+    classifier.expire(kStart + Classifier::kDoubleClickWindow);
+    REQUIRE(recorder.events.size() == 2);
+    CHECK_EQ(recorder.events[1].type, EventType::ButtonClick);
+
+    Timestamp second = kStart + 2000 * kMs;
+    classifier.buttonDown(second, false);
+    classifier.buttonUp(second + 80 * kMs, false);
+    classifier.buttonDown(second + 200 * kMs, false);
+    classifier.buttonUp(second + 280 * kMs, false);
+    REQUIRE(recorder.events.size() == 4);
+    CHECK_EQ(recorder.events[2].type, EventType::ButtonProvisionalClick);
+    CHECK_EQ(recorder.events[3].type, EventType::ButtonDoubleClick);
+}
+
+TEST(Classifier, QueuedPressIsNeverSpeculative)
+{
+    Recorder recorder;
+    Classifier classifier(recorder);
+    classifier.setBehavior(TriggerBehavior::ClickAndDoubleClick);
+    classifier.setSpeculative(true);
+
+    // A backlog received long after the fact is still classified by the times it carries.
+    classifier.buttonDown(kStart, true);
+    classifier.buttonUp(kStart + 80 * kMs, true);
+    CHECK(recorder.events.empty());
+    classifier.buttonDown(kStart + 5000 * kMs, false);
+    REQUIRE(recorder.events.size() == 1);
+    CHECK_EQ(recorder.events[0].type, EventType::ButtonClick);
+    CHECK_EQ(recorder.events[0].time, kStart + Classifier::kDoubleClickWindow);
+    CHECK(recorder.events[0].queued);
+}
+
+TEST(Classifier, BehaviorChangeDropsSequence)
+{
+    Recorder recorder;
+    Classifier classifier(recorder);
+    classifier.buttonDown(kStart, false);
+    classifier.setBehavior(TriggerBehavior::ClickAndDoubleClick);
+    CHECK_EQ(classifier.deadline(), -1);
+    classifier.expire(kStart + 10 * Classifier::kHoldThreshold);
+    classifier.buttonUp(kStart + 10 * Classifier::kHoldThreshold, false);
+    CHECK(recorder.events.empty());
+}
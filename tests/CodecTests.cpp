@@ -0,0 +1,271 @@
+//
+//  @file CodecTests.cpp
+//  @framework fliclib-core
+//
+//  Copyright (c) 2016-2026 Shortcut Labs. All rights reserved.
+//
+
+#include "Test.h"
+
+#include <cstring>
+
+#include "Packet.h"
+
+using namespace scl::flic;
+
+namespace {
+
+const uint8_t kKey[kSessionKeySize] = { 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16 };
+const uint8_t kOtherKey[kSessionKeySize] = { 16, 15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1 };
+const uint8_t kNonce[kNonceSize] = { 0xa0, 0xa1, 0xa2, 0xa3, 0xa4, 0xa5, 0xa6, 0xa7 };
+
+ButtonEventPayload makeEvent(uint32_t pressCounter)
+{
+    ButtonEventPayload event;
+    event.pressCounter = pressCounter;
+    event.down = (pressCounter & 1) != 0;
+    event.queued = (pressCounter & 2) != 0;
+    event.ackRequested = true;
+    event.eventTicks = 0x01020304 + pressCounter;
+    event.sentTicks = 0xfffffff0;
+    return event;
+}
+
+} // namespace
+
+TEST(Codec, ButtonEventRoundTrip)
+{
+    PacketSigner flic(false);
+    PacketSigner host(true);
+    flic.reset(kKey);
+    host.reset(kKey);
+
+    ButtonEventPayload event = makeEvent(0xabcdef);
+    Packet packet;
+    encodeButtonEvent(packet, event);
+    flic.sign(packet);
+    CHECK_EQ(packet.size, (uint8_t)(13 + kSignatureSize));
+
+    DecodedPacket decoded;
+    REQUIRE(decodePacket(packet.bytes, packet.size, decoded) == Error::None);
+    CHECK(host.verify(packet.bytes, packet.size));
+    CHECK_EQ(decoded.opcode, Opcode::ButtonEvent);
+    CHECK_EQ(decoded.event.pressCounter, event.pressCounter);
+    CHECK_EQ(decoded.event.down, event.down);
+    CHECK_EQ(decoded.event.queued, event.queued);
+    CHECK_EQ(decoded.event.ackRequested, event.ackRequested);
+    CHECK_EQ(decoded.event.eventTicks, event.eventTicks);
+    CHECK_EQ(decoded.event.sentTicks, event.sentTicks);
+}
+
+TEST(Codec, PressCounterKeepsTwentyFourBits)
+{
+    Packet packet;
+    encodeEventAck(packet, 0x12345678);
+    DecodedPacket decoded;
+    REQUIRE(decodePacket(packet.bytes, packet.size + kSignatureSize, decoded) == Error::None);
+    CHECK_EQ(decoded.ackCounter, 0x345678u);
+}
+
+TEST(Codec, HandshakeRoundTrip)
+{
+    uint8_t proof[kProofSize] = { 9, 8, 7, 6, 5, 4, 3, 2 };
+    const uint8_t ticketId[kTicketIdSize] = { 0x11, 0x22, 0x33, 0x44 };
+    Packet packet;
+    DecodedPacket decoded;
+
+    encodeVerifyRequest(packet, kNonce);
+    REQUIRE(decodePacket(packet.bytes, packet.size, decoded) == Error::None);
+    CHECK_EQ(decoded.opcode, Opcode::VerifyRequest);
+    CHECK(memcmp(decoded.nonce, kNonce, kNonceSize) == 0);
+    CHECK_EQ(decoded.ackWindow, 1);
+
+    encodeVerifyRequest(packet, kNonce, 32);
+    REQUIRE(decodePacket(packet.bytes, packet.size, decoded) == Error::None);
+    CHECK_EQ(decoded.ackWindow, 32);
+
+    encodeVerifyResponse(packet, kNonce, proof, 16);
+    REQUIRE(decodePacket(packet.bytes, packet.size, decoded) == Error::None);
+    CHECK_EQ(decoded.opcode, Opcode::VerifyResponse);
+    CHECK(memcmp(decoded.proof, proof, kProofSize) == 0);
+    CHECK_EQ(decoded.ackWindow, 16);
+
+    encodeResumeRequest(packet, ticketId, kNonce, 8);
+    REQUIRE(decodePacket(packet.bytes, packet.size, decoded) == Error::None);
+    CHECK_EQ(decoded.opcode, Opcode::ResumeRequest);
+    CHECK(memcmp(decoded.ticketId, ticketId, kTicketIdSize) == 0);
+    CHECK(memcmp(decoded.nonce, kNonce, kNonceSize) == 0);
+    CHECK_EQ(decoded.ackWindow, 8);
+
+    encodeResumeRejected(packet);
+    REQUIRE(decodePacket(packet.bytes, packet.size, decoded) == Error::None);
+    CHECK_EQ(decoded.opcode, Opcode::ResumeRejected);
+}
+
+TEST(Codec, ResumedSessionDependsOnBothNonces)
+{
+    const uint8_t otherNonce[kNonceSize] = { 0xc0, 0xc1, 0xc2, 0xc3, 0xc4, 0xc5, 0xc6, 0xc7 };
+    ResumptionTicket ticket;
+    deriveResumptionTicket(ChaskeyKey(kKey), kNonce, otherNonce, 1234, ticket);
+
+    Packet packet;
+    encodeResumeResponse(packet, otherNonce, 4);
+    DecodedPacket decoded;
+    REQUIRE(decodePacket(packet.bytes, packet.size + kSignatureSize, decoded) == Error::None);
+    CHECK_EQ(decoded.opcode, Opcode::ResumeResponse);
+    CHECK(memcmp(decoded.nonce, otherNonce, kNonceSize) == 0);
+    CHECK_EQ(decoded.ackWindow, 4);
+
+    ResumptionTicket first = ticket;
+    ResumptionTicket second = ticket;
+    ResumptionTicket third = ticket;
+    uint8_t firstKey[kSessionKeySize];
+    uint8_t secondKey[kSessionKeySize];
+    uint8_t thirdKey[kSessionKeySize];
+    deriveResumedSession(first, kNonce, otherNonce, firstKey);
+    deriveResumedSession(second, kNonce, kNonce, secondKey);
+    deriveResumedSession(third, otherNonce, otherNonce, thirdKey);
+    CHECK(memcmp(firstKey, secondKey, kSessionKeySize) != 0);
+    CHECK(memcmp(secondKey, thirdKey, kSessionKeySize) != 0);
+
+    // The ticket is replaced by one for the next resumption, with the lifetime of the first.
+    CHECK(first.valid);
+    CHECK_EQ(first.issued, ticket.issued);
+    CHECK(memcmp(first.id, ticket.id, kTicketIdSize) != 0);
+    CHECK(memcmp(first.secret, ticket.secret, kSessionKeySize) != 0);
+    CHECK(memcmp(first.secret, second.secret, kSessionKeySize) != 0);
+}
+
+TEST(Codec, RejectsWrongSizesAndUnknownOpcodes)
+{
+    Packet packet;
+    DecodedPacket decoded;
+    encodeButtonEvent(packet, makeEvent(1));
+
+    CHECK_EQ(decodePacket(packet.bytes, 0, decoded), Error::MissingData);
+    // Without its signature, and with a byte too many.
+    CHECK_EQ(decodePacket(packet.bytes, packet.size, decoded), Error::MissingData);
+    CHECK_EQ(decodePacket(packet.bytes, packet.size + kSignatureSize + 1, decoded), Error::MissingData);
+
+    encodeVerifyRequest(packet, kNonce);
+    CHECK_EQ(decodePacket(packet.bytes, packet.size - 1, decoded), Error::MissingData);
+    CHECK_EQ(decodePacket(packet.bytes, packet.size + 2, decoded), Error::MissingData);
+
+    const uint8_t unknown[] = { 0x7f, 0, 0, 0 };
+    CHECK_EQ(decodePacket(unknown, sizeof(unknown), decoded), Error::UnknownDataReceived);
+}
+
+TEST(Codec, SignerRejectsReplayReflectionAndTampering)
+{
+    PacketSigner flic(false);
+    PacketSigner host(true);
+    flic.reset(kKey);
+    host.reset(kKey);
+
+    Packet first;
+    encodeButtonEvent(first, makeEvent(1));
+    flic.sign(first);
+    REQUIRE(host.verify(first.bytes, first.size));
+    // The same packet again is a replay.
+    CHECK(!host.verify(first.bytes, first.size));
+
+    Packet second;
+    encodeButtonEvent(second, makeEvent(2));
+    flic.sign(second);
+    Packet tampered = second;
+    tampered.bytes[1] ^= 0x01;
+    CHECK(!host.verify(tampered.bytes, tampered.size));
+    CHECK(host.verify(second.bytes, second.size));
+    CHECK_EQ(host.rxCounter(), 2u);
+
+    // A packet the host signed is not accepted by the host, even with the counter it expects.
+    PacketSigner reflecting(true);
+    reflecting.reset(kKey);
+    for (int i = 0; i < 2; i++)
+    {
+        Packet skipped;
+        encodeQueueDrained(skipped);
+        reflecting.sign(skipped);
+    }
+    Packet reflected;
+    encodeButtonEvent(reflected, makeEvent(3));
+    reflecting.sign(reflected);
+    CHECK(!host.verify(reflected.bytes, reflected.size));
+
+    PacketSigner stranger(false);
+    stranger.reset(kOtherKey);
+    Packet foreign;
+    encodeButtonEvent(foreign, makeEvent(3));
+    stranger.sign(foreign);
+    CHECK(!host.verify(foreign.bytes, foreign.size));
+    CHECK_EQ(host.rxCounter(), 2u);
+}
+
+TEST(Codec, VerifyBatchMatchesVerify)
+{
+    const size_t count = 3 * ChaskeyKey::kChaskeyLanes + 1;
+    PacketSigner flic(false);
+    flic.reset(kKey);
+    Packet packets[count];
+    const uint8_t* data[count];
+    size_t sizes[count];
+    for (size_t i = 0; i < count; i++)
+    {
+        if (i % 3 == 0)
+        {
+            encodeQueueDrained(packets[i]);
+        }
+        else
+        {
+            encodeButtonEvent(packets[i], makeEvent((uint32_t)i));
+        }
+        flic.sign(packets[i]);
+        data[i] = packets[i].bytes;
+        sizes[i] = packets[i].size;
+    }
+
+    PacketSigner batched(true);
+    batched.reset(kKey);
+    CHECK_EQ(batched.verifyBatch(data, sizes, count), count);
+    CHECK_EQ(batched.rxCounter(), (uint64_t)count);
+
+    // A bad signature in the middle stops both at the same packet.
+    const size_t bad = ChaskeyKey::kChaskeyLanes + 2;
+    packets[bad].bytes[packets[bad].size - 1] ^= 0x80;
+    PacketSigner sequential(true);
+    sequential.reset(kKey);
+    size_t valid = 0;
+    while (valid < count && sequential.verify(data[valid], sizes[valid]))
+    {
+        valid++;
+    }
+    batched.reset(kKey);
+    CHECK_EQ(valid, bad);
+    CHECK_EQ(batched.verifyBatch(data, sizes, count), bad);
+    CHECK_EQ(batched.rxCounter(), sequential.rxCounter());
+}
+
+TEST(Codec, MacBatchMatchesMac)
+{
+    ChaskeyKey key(kKey);
+    uint8_t storage[ChaskeyKey::kChaskeyLanes][40];
+    const uint8_t* messages[ChaskeyKey::kChaskeyLanes];
+    // Covers empty, partial and whole final blocks.
+    size_t sizes[ChaskeyKey::kChaskeyLanes] = { 0, 1, 15, 16, 17, 31, 32, 39 };
+    for (size_t i = 0; i < ChaskeyKey::kChaskeyLanes; i++)
+    {
+        for (size_t j = 0; j < sizeof(storage[i]); j++)
+        {
+            storage[i][j] = (uint8_t)(i * 31 + j);
+        }
+        messages[i] = storage[i];
+    }
+    uint8_t tags[ChaskeyKey::kChaskeyLanes][16];
+    key.macBatch(messages, sizes, ChaskeyKey::kChaskeyLanes, tags[0], 16);
+    for (size_t i = 0; i < ChaskeyKey::kChaskeyLanes; i++)
+    {
+        uint8_t tag[16];
+        key.mac(messages[i], sizes[i], tag, 16);
+        CHECK(memcmp(tag, tags[i], 16) == 0);
+    }
+}
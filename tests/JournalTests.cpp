@@ -0,0 +1,461 @@
+//
+//  @file JournalTests.cpp
+//  @framework fliclib-core
+//
+//  Copyright (c) 2016-2026 Shortcut Labs. All rights reserved.
+//
+
+#include "Test.h"
+
+#include <cstring>
+#include <csignal>
+#include <fcntl.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "Journal.h"
+
+using namespace scl::flic;
+using scl::test::temporaryPath;
+
+namespace {
+
+JournalButton makeButton(int index)
+{
+    JournalButton button;
+    button.info.identifier = "button-" + std::to_string(index);
+    button.info.publicKey = "key-" + std::to_string(index);
+    button.info.name = "F" + std::to_string(index);
+    button.info.userAssignedName = "Desk";
+    for (size_t i = 0; i < ChaskeyKey::kKeySize; i++)
+    {
+        button.info.longTermKey[i] = (uint8_t)(index + i);
+    }
+    button.pressCount = (uint32_t)index * 10;
+    button.settings.triggerBehavior = TriggerBehavior::ClickAndDoubleClickAndHold;
+    button.settings.connectionProfile = ConnectionProfile::Battery;
+    button.settings.adaptiveLatency = true;
+    button.settings.eventMask = (EventMask)0x0c;
+    return button;
+}
+
+off_t fileSizeAt(const std::string& path)
+{
+    struct stat info;
+    return stat(path.c_str(), &info) == 0 ? info.st_size : -1;
+}
+
+int readVersion(const std::string& path)
+{
+    int fd = open(path.c_str(), O_RDONLY);
+    uint8_t version = 0;
+    bool read = fd >= 0 && pread(fd, &version, 1, 4) == 1;
+    if (fd >= 0)
+    {
+        close(fd);
+    }
+    return read ? version : -1;
+}
+
+bool writeVersion(const std::string& path, uint8_t version)
+{
+    int fd = open(path.c_str(), O_WRONLY);
+    bool written = fd >= 0 && pwrite(fd, &version, 1, 4) == 1;
+    if (fd >= 0)
+    {
+        close(fd);
+    }
+    return written;
+}
+
+/*!
+ *  @class FileSizeLimit
+ *
+ *  @discussion Makes writes past <code>limit</code> bytes into any file fail for as long as it lives, a write across it
+ *              is cut short at the limit.
+ *
+ */
+class FileSizeLimit
+{
+public:
+    explicit FileSizeLimit(rlim_t limit)
+    {
+        _handler = signal(SIGXFSZ, SIG_IGN);
+        getrlimit(RLIMIT_FSIZE, &_saved);
+        rlimit lowered = _saved;
+        lowered.rlim_cur = limit;
+        setrlimit(RLIMIT_FSIZE, &lowered);
+    }
+
+    ~FileSizeLimit()
+    {
+        setrlimit(RLIMIT_FSIZE, &_saved);
+        signal(SIGXFSZ, _handler);
+    }
+
+private:
+    rlimit _saved;
+    void (*_handler)(int);
+};
+
+void checkSameButton(const JournalButton& actual, const JournalButton& expected)
+{
+    CHECK_EQ(actual.info.identifier, expected.info.identifier);
+    CHECK_EQ(actual.info.publicKey, expected.info.publicKey);
+    CHECK_EQ(actual.info.name, expected.info.name);
+    CHECK_EQ(actual.info.userAssignedName, expected.info.userAssignedName);
+    CHECK(memcmp(actual.info.longTermKey, expected.info.longTermKey, ChaskeyKey::kKeySize) == 0);
+    CHECK_EQ(actual.pressCount, expected.pressCount);
+    CHECK(actual.settings == expected.settings);
+    CHECK_EQ(actual.wantsConnection, expected.wantsConnection);
+}
+
+} // namespace
+
+TEST(Journal, RoundTrip)
+{
+    std::string path = temporaryPath("round-trip.journal");
+    JournalButton first = makeButton(1);
+    JournalButton second = makeButton(2);
+    {
+        StateJournal journal;
+        REQUIRE(journal.open(path));
+        CHECK(journal.recordButton(first));
+        CHECK(journal.recordButton(second));
+        CHECK(journal.recordButton(makeButton(3)));
+        CHECK(journal.recordRemoved("button-3"));
+
+        first.settings.speculativeClicks = true;
+        first.settings.eventMask = kAllEvents;
+        CHECK(journal.recordSettings(first.info.identifier, first.settings));
+        second.wantsConnection = false;
+        CHECK(journal.recordWantsConnection(second.info.identifier, false));
+        first.pressCount = 41;
+        CHECK(journal.recordPressCount(first.info.identifier, 40));
+        CHECK(journal.recordPressCount(first.info.identifier, 41));
+        CHECK_EQ(journal.pendingRecords(), 1u);
+        CHECK_EQ(journal.coalescedRecords(), 1u);
+        CHECK(journal.flush());
+        CHECK_EQ(journal.pendingRecords(), 0u);
+    }
+
+    StateJournal journal;
+    JournalState state;
+    REQUIRE(journal.open(path, &state));
+    CHECK(!state.truncated);
+    CHECK_EQ(state.records, 7u);
+    REQUIRE(state.buttons.size() == 2);
+    checkSameButton(state.buttons[0], first);
+    checkSameButton(state.buttons[1], second);
+}
+
+TEST(Journal, TornTailIsCutOff)
+{
+    std::string path = temporaryPath("torn.journal");
+    {
+        StateJournal journal;
+        REQUIRE(journal.open(path));
+        CHECK(journal.recordButton(makeButton(1)));
+        CHECK(journal.recordButton(makeButton(2)));
+    }
+    off_t intact = fileSizeAt(path);
+    // A crash in the middle of the third record.
+    {
+        StateJournal journal;
+        REQUIRE(journal.open(path));
+        CHECK(journal.recordButton(makeButton(3)));
+    }
+    REQUIRE(truncate(path.c_str(), fileSizeAt(path) - 3) == 0);
+
+    {
+        StateJournal journal;
+        JournalState state;
+        REQUIRE(journal.open(path, &state));
+        CHECK(state.truncated);
+        CHECK_EQ(state.records, 2u);
+        REQUIRE(state.buttons.size() == 2);
+        checkSameButton(state.buttons[1], makeButton(2));
+        CHECK_EQ(fileSizeAt(path), intact);
+
+        // What is appended after the cut is read back.
+        CHECK(journal.recordButton(makeButton(4)));
+    }
+
+    StateJournal journal;
+    JournalState state;
+    REQUIRE(journal.open(path, &state));
+    CHECK(!state.truncated);
+    REQUIRE(state.buttons.size() == 3);
+    checkSameButton(state.buttons[2], makeButton(4));
+}
+
+TEST(Journal, CorruptRecordEndsLoad)
+{
+    std::string path = temporaryPath("corrupt.journal");
+    {
+        StateJournal journal;
+        REQUIRE(journal.open(path));
+        CHECK(journal.recordButton(makeButton(1)));
+        CHECK(journal.recordButton(makeButton(2)));
+    }
+    // Flip a byte of the last checksum.
+    int fd = open(path.c_str(), O_RDWR);
+    REQUIRE(fd >= 0);
+    off_t last = fileSizeAt(path) - 1;
+    uint8_t byte = 0;
+    CHECK(pread(fd, &byte, 1, last) == 1);
+    byte ^= 0xff;
+    CHECK(pwrite(fd, &byte, 1, last) == 1);
+    close(fd);
+
+    StateJournal journal;
+    JournalState state;
+    REQUIRE(journal.open(path, &state));
+    CHECK(state.truncated);
+    REQUIRE(state.buttons.size() == 1);
+    checkSameButton(state.buttons[0], makeButton(1));
+}
+
+TEST(Journal, OlderVersionIsUpgraded)
+{
+    std::string path = temporaryPath("upgrade.journal");
+    JournalButton button = makeButton(1);
+    // Version 1 knew neither profiles above Gaming nor the extended settings byte.
+    button.settings.connectionProfile = ConnectionProfile::Gaming;
+    button.settings.adaptiveLatency = false;
+    button.settings.eventMask = kAllEvents;
+    {
+        StateJournal journal;
+        REQUIRE(journal.open(path));
+        CHECK(journal.recordButton(button));
+    }
+    REQUIRE(writeVersion(path, StateJournal::kOldestVersion));
+
+    {
+        StateJournal journal;
+        JournalState state;
+        REQUIRE(journal.open(path, &state));
+        REQUIRE(state.buttons.size() == 1);
+        checkSameButton(state.buttons[0], button);
+        CHECK_EQ(readVersion(path), (int)StateJournal::kVersion);
+        button.settings.adaptiveLatency = true;
+        CHECK(journal.recordSettings(button.info.identifier, button.settings));
+    }
+
+    StateJournal journal;
+    JournalState state;
+    REQUIRE(journal.open(path, &state));
+    REQUIRE(state.buttons.size() == 1);
+    CHECK(state.buttons[0].settings.adaptiveLatency);
+}
+
+TEST(Journal, UnknownVersionIsRejected)
+{
+    std::string path = temporaryPath("version.journal");
+    {
+        StateJournal journal;
+        REQUIRE(journal.open(path));
+        CHECK(journal.recordButton(makeButton(1)));
+    }
+    off_t size = fileSizeAt(path);
+
+    REQUIRE(writeVersion(path, StateJournal::kOldestVersion - 1));
+    StateJournal journal;
+    CHECK(!journal.open(path));
+    REQUIRE(writeVersion(path, StateJournal::kVersion + 1));
+    CHECK(!journal.open(path));
+    CHECK(!journal.isOpen());
+    // A rejected journal is left alone.
+    CHECK_EQ(fileSizeAt(path), size);
+    CHECK_EQ(readVersion(path), (int)StateJournal::kVersion + 1);
+}
+
+TEST(Journal, FailedCompactionLeavesJournal)
+{
+    std::string path = temporaryPath("compaction.journal");
+    REQUIRE(mkdir((path + ".compact").c_str(), 0755) == 0);
+    JournalButton button = makeButton(1);
+    {
+        StateJournal journal;
+        REQUIRE(journal.open(path));
+        CHECK(journal.recordButton(button));
+        CHECK(journal.recordButton(makeButton(2)));
+        CHECK(journal.recordRemoved("button-2"));
+        button.pressCount = 77;
+        CHECK(journal.recordPressCount(button.info.identifier, 77));
+        uint64_t size = journal.fileSize();
+
+        CHECK(!journal.compact());
+        CHECK_EQ(journal.compactions(), 0u);
+        CHECK_EQ(journal.fileSize(), size);
+        CHECK_EQ(journal.pendingRecords(), 1u);
+        // The journal goes on as before.
+        CHECK(journal.recordButton(makeButton(3)));
+    }
+    REQUIRE(rmdir((path + ".compact").c_str()) == 0);
+
+    StateJournal journal;
+    JournalState state;
+    REQUIRE(journal.open(path, &state));
+    CHECK(!state.truncated);
+    REQUIRE(state.buttons.size() == 2);
+    checkSameButton(state.buttons[0], button);
+    checkSameButton(state.buttons[1], makeButton(3));
+}
+
+TEST(Journal, CompactionKeepsState)
+{
+    std::string path = temporaryPath("compacted.journal");
+    JournalButton button = makeButton(1);
+    {
+        StateJournal journal;
+        REQUIRE(journal.open(path));
+        CHECK(journal.recordButton(button));
+        // Enough press counts to pass the threshold, each flushed on its own.
+        for (uint32_t count = 1; journal.compactions() == 0 && count < 100000; count++)
+        {
+            button.pressCount = count;
+            CHECK(journal.recordPressCount(button.info.identifier, count));
+            CHECK(journal.flush());
+        }
+        CHECK_EQ(journal.compactions(), 1u);
+        CHECK(journal.fileSize() < StateJournal::kCompactionThreshold);
+        CHECK_EQ((off_t)journal.fileSize(), fileSizeAt(path));
+    }
+
+    StateJournal journal;
+    JournalState state;
+    REQUIRE(journal.open(path, &state));
+    CHECK(!state.truncated);
+    REQUIRE(state.buttons.size() == 1);
+    checkSameButton(state.buttons[0], button);
+}
+
+TEST(Journal, ShortWriteIsCutOffAndRetried)
+{
+    std::string path = temporaryPath("short-write.journal");
+    JournalButton first = makeButton(1);
+    JournalButton second = makeButton(2);
+    StateJournal journal;
+    REQUIRE(journal.open(path));
+    CHECK(journal.recordButton(first));
+    uint64_t intact = journal.fileSize();
+    {
+        FileSizeLimit limit((rlim_t)intact + 10);
+        CHECK(!journal.recordButton(second));
+    }
+    CHECK_EQ(journal.fileSize(), intact);
+    CHECK_EQ(fileSizeAt(path), (off_t)intact);
+
+    // The next change carries the record that was cut short.
+    first.wantsConnection = false;
+    CHECK(journal.recordWantsConnection(first.info.identifier, false));
+    journal.close();
+
+    JournalState state;
+    REQUIRE(journal.open(path, &state));
+    CHECK(!state.truncated);
+    REQUIRE(state.buttons.size() == 2);
+    checkSameButton(state.buttons[0], first);
+    checkSameButton(state.buttons[1], second);
+}
+
+TEST(Journal, FailedWriteIsRetried)
+{
+    std::string path = temporaryPath("failed-write.journal");
+    JournalButton button = makeButton(1);
+    StateJournal journal;
+    REQUIRE(journal.open(path));
+    CHECK(journal.recordButton(button));
+    uint64_t intact = journal.fileSize();
+    button.settings.triggerBehavior = TriggerBehavior::Click;
+    {
+        // Nothing at all gets written.
+        FileSizeLimit limit((rlim_t)intact);
+        CHECK(!journal.recordSettings(button.info.identifier, button.settings));
+        CHECK(!journal.flush());
+    }
+    CHECK_EQ(fileSizeAt(path), (off_t)intact);
+    CHECK(journal.flush());
+    journal.close();
+
+    JournalState state;
+    REQUIRE(journal.open(path, &state));
+    REQUIRE(state.buttons.size() == 1);
+    checkSameButton(state.buttons[0], button);
+}
+
+TEST(Journal, FailedCompactionKeepsSizes)
+{
+    std::string path = temporaryPath("compaction-sizes.journal");
+    JournalButton button = makeButton(1);
+    button.pressCount = 0;
+    StateJournal journal;
+    REQUIRE(journal.open(path));
+    CHECK(journal.recordButton(button));
+    // Its compacted record would be larger than the one it was added with.
+    CHECK(journal.recordPressCount(button.info.identifier, 0xfffffff));
+    CHECK(journal.flush());
+
+    uint64_t liveSize = journal.liveSize();
+
+    REQUIRE(mkdir((path + ".compact").c_str(), 0755) == 0);
+    CHECK(!journal.compact());
+    REQUIRE(rmdir((path + ".compact").c_str()) == 0);
+    CHECK_EQ(journal.liveSize(), liveSize);
+    CHECK(journal.recordRemoved(button.info.identifier));
+    CHECK_EQ(journal.liveSize(), 0u);
+
+    // With the live size accounted for right the journal is still compacted once it is mostly dead records.
+    JournalButton other = makeButton(2);
+    CHECK(journal.recordButton(other));
+    for (uint32_t count = 1; journal.compactions() == 0 && count < 100000; count++)
+    {
+        other.pressCount = count;
+        CHECK(journal.recordPressCount(other.info.identifier, count));
+        CHECK(journal.flush());
+    }
+    CHECK_EQ(journal.compactions(), 1u);
+    journal.close();
+
+    JournalState state;
+    REQUIRE(journal.open(path, &state));
+    REQUIRE(state.buttons.size() == 1);
+    checkSameButton(state.buttons[0], other);
+}
+
+TEST(Journal, FailedFlushKeepsPressCountsPending)
+{
+    std::string path = temporaryPath("failed-flush.journal");
+    JournalButton first = makeButton(1);
+    JournalButton second = makeButton(2);
+    StateJournal journal;
+    REQUIRE(journal.open(path));
+    CHECK(journal.recordButton(first));
+    CHECK(journal.recordButton(second));
+    first.pressCount = 1000;
+    second.pressCount = 2000;
+    CHECK(journal.recordPressCount(first.info.identifier, first.pressCount));
+    CHECK(journal.recordPressCount(second.info.identifier, second.pressCount));
+    {
+        FileSizeLimit limit((rlim_t)journal.fileSize());
+        CHECK(!journal.flush());
+        CHECK_EQ(journal.pendingRecords(), 2u);
+        // A pending button can still be removed.
+        CHECK(!journal.recordRemoved(second.info.identifier));
+        CHECK_EQ(journal.pendingRecords(), 1u);
+    }
+
+    // A newer count replaces the pending one.
+    first.pressCount = 1001;
+    CHECK(journal.recordPressCount(first.info.identifier, first.pressCount));
+    CHECK(journal.flush());
+    CHECK_EQ(journal.pendingRecords(), 0u);
+    journal.close();
+
+    JournalState state;
+    REQUIRE(journal.open(path, &state));
+    REQUIRE(state.buttons.size() == 1);
+    checkSameButton(state.buttons[0], first);
+}
@@ -0,0 +1,125 @@
+//
+//  @file RSSITests.cpp
+//  @framework fliclib-core
+//
+//  Copyright (c) 2016-2026 Shortcut Labs. All rights reserved.
+//
+
+#include "Test.h"
+
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+#include "Button.h"
+#include "SimulatedPeripheral.h"
+
+using namespace scl::flic;
+
+namespace {
+
+const uint8_t kLongTermKey[ChaskeyKey::kKeySize] = { 2, 7, 1, 8, 2, 8, 1, 8, 2, 8, 4, 5, 9, 0, 4, 5 };
+
+ButtonInfo makeInfo()
+{
+    ButtonInfo info;
+    info.identifier = "rssi-test";
+    memcpy(info.longTermKey, kLongTermKey, sizeof(kLongTermKey));
+    return info;
+}
+
+struct Reading
+{
+    int rssi;
+    Error error;
+};
+
+class RecordingDelegate : public ButtonDelegate
+{
+public:
+    void didDisconnect(Button& button, Error error) override { disconnects++; }
+    void didUpdateRSSI(Button& button, int rssi, Error error) override
+    {
+        readings.push_back({ rssi, error });
+        disconnectsBeforeReading.push_back(disconnects);
+    }
+
+    unsigned disconnects = 0;
+    std::vector<Reading> readings;
+    std::vector<unsigned> disconnectsBeforeReading;
+};
+
+struct Simulation
+{
+    Simulation() : peripheral(scheduler, kLongTermKey, 3), link(scheduler, peripheral), button(makeInfo(), link, scheduler)
+    {
+        button.setDelegate(&delegate);
+        button.connect();
+        scheduler.runUntilIdle();
+    }
+
+    ManualScheduler scheduler;
+    SimulatedPeripheral peripheral;
+    SimulatedLink link;
+    Button button;
+    RecordingDelegate delegate;
+};
+
+} // namespace
+
+TEST(RSSI, ReadsLostWithLinkAreReportedAsFailed)
+{
+    Simulation simulation;
+    REQUIRE(simulation.button.isReady());
+
+    simulation.button.readRSSI();
+    simulation.button.readRSSI();
+    simulation.peripheral.setInRange(false);
+    simulation.scheduler.runUntilIdle();
+    REQUIRE(simulation.delegate.readings.size() == 2);
+    for (size_t i = 0; i < 2; i++)
+    {
+        CHECK_EQ(simulation.delegate.readings[i].error, Error::CouldNotUpdateRSSI);
+        CHECK_EQ(simulation.delegate.disconnectsBeforeReading[i], 1u);
+    }
+
+    // The next link starts without reads outstanding, so its subscription samples are not taken for the lost ones.
+    simulation.delegate.readings.clear();
+    simulation.button.subscribeRSSI();
+    simulation.peripheral.setInRange(true);
+    simulation.scheduler.advanceBy(5 * simulation.button.rssiSubscription().interval);
+    REQUIRE(simulation.button.isReady());
+    CHECK(simulation.delegate.readings.empty());
+    simulation.button.unsubscribeRSSI();
+    simulation.button.readRSSI();
+    simulation.scheduler.runUntilIdle();
+    REQUIRE(simulation.delegate.readings.size() == 1);
+    CHECK_EQ(simulation.delegate.readings[0].error, Error::None);
+    CHECK_EQ(simulation.delegate.readings[0].rssi, simulation.peripheral.rssi());
+}
+
+TEST(RSSI, SubscriptionWithoutNoiseStaysFinite)
+{
+    Simulation simulation;
+    REQUIRE(simulation.button.isReady());
+
+    RSSISubscription subscription;
+    subscription.measurementNoise = 0;
+    subscription.processNoise = 0;
+    subscription.smoothing = 3;
+    simulation.button.subscribeRSSI(subscription);
+    CHECK(simulation.button.rssiSubscription().measurementNoise > 0);
+    CHECK(simulation.button.rssiSubscription().processNoise > 0);
+    CHECK(simulation.button.rssiSubscription().smoothing <= 1);
+
+    simulation.peripheral.setRSSINoise(4);
+    simulation.scheduler.advanceBy(10 * subscription.interval);
+    CHECK(std::isfinite(simulation.button.filteredRSSI()));
+    CHECK(std::fabs(simulation.button.filteredRSSI() - simulation.peripheral.rssi()) < 20);
+
+    subscription.filter = RSSIFilterKind::EWMA;
+    subscription.smoothing = 0;
+    simulation.button.subscribeRSSI(subscription);
+    CHECK(simulation.button.rssiSubscription().smoothing > 0);
+    simulation.button.unsubscribeRSSI();
+}
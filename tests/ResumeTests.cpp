@@ -0,0 +1,308 @@
+//
+//  @file ResumeTests.cpp
+//  @framework fliclib-core
+//
+//  Copyright (c) 2016-2026 Shortcut Labs. All rights reserved.
+//
+
+#include "Test.h"
+
+#include <cstring>
+#include <vector>
+
+#include "Button.h"
+#include "SimulatedPeripheral.h"
+
+using namespace scl::flic;
+
+namespace {
+
+const uint8_t kLongTermKey[ChaskeyKey::kKeySize] = { 3, 1, 4, 1, 5, 9, 2, 6, 5, 3, 5, 8, 9, 7, 9, 3 };
+const uint8_t kButtonNonce[kNonceSize] = { 0xb0, 0xb1, 0xb2, 0xb3, 0xb4, 0xb5, 0xb6, 0xb7 };
+
+ButtonInfo makeInfo()
+{
+    ButtonInfo info;
+    info.identifier = "resume-test";
+    memcpy(info.longTermKey, kLongTermKey, sizeof(kLongTermKey));
+    return info;
+}
+
+/*!
+ *  @class ScriptedTransport
+ *
+ *  @discussion A transport the test plays the flic through by hand, for responses the simulated firmware never sends.
+ *
+ */
+class ScriptedTransport : public Transport
+{
+public:
+    void connect() override { connects++; }
+    void disconnect() override {}
+    void write(const uint8_t* data, size_t size) override { written.emplace_back(data, data + size); }
+    void readRSSI() override {}
+
+    DecodedPacket lastWritten()
+    {
+        DecodedPacket packet;
+        if (written.empty() || decodePacket(written.back().data(), written.back().size(), packet) != Error::None)
+        {
+            scl::test::fail(__FILE__, __LINE__, "no packet was written");
+        }
+        return packet;
+    }
+
+    void receive(const Packet& packet) { listener()->transportDidReceive(packet.bytes, packet.size); }
+
+    unsigned connects = 0;
+    std::vector<std::vector<uint8_t>> written;
+};
+
+/*!
+ *  @method verify:
+ *
+ *  @discussion Answers the verify request the button just wrote as the flic would, and returns the ticket both sides
+ *              now hold.
+ *
+ */
+ResumptionTicket verify(ScriptedTransport& transport, ManualScheduler& scheduler)
+{
+    DecodedPacket request = transport.lastWritten();
+    CHECK_EQ(request.opcode, Opcode::VerifyRequest);
+    ChaskeyKey longTermKey(kLongTermKey);
+    uint8_t proof[kProofSize];
+    computeVerificationProof(longTermKey, request.nonce, kButtonNonce, proof);
+    Packet response;
+    encodeVerifyResponse(response, kButtonNonce, proof);
+    transport.receive(response);
+
+    ResumptionTicket ticket;
+    deriveResumptionTicket(longTermKey, request.nonce, kButtonNonce, scheduler.now(), ticket);
+    return ticket;
+}
+
+/*!
+ *  @class RecordingListener
+ *
+ *  @discussion Stands in for the host on a SimulatedLink, keeping what the flic sends.
+ *
+ */
+class RecordingListener : public TransportListener
+{
+public:
+    void transportDidConnect() override { connected = true; }
+    void transportDidFailToConnect(Error error) override {}
+    void transportDidDisconnect(Error error) override { connected = false; }
+    void transportDidReceive(const uint8_t* data, size_t size) override { received.emplace_back(data, data + size); }
+    void transportDidReadRSSI(int rssi, Error error) override {}
+
+    /*!
+     *  @method answer
+     *
+     *  @return The first packet received since <code>received</code> was last cleared, a session that starts is
+     *          followed by others.
+     *
+     */
+    DecodedPacket answer() const
+    {
+        DecodedPacket packet;
+        if (received.empty() || decodePacket(received.front().data(), received.front().size(), packet) != Error::None)
+        {
+            scl::test::fail(__FILE__, __LINE__, "nothing was received");
+        }
+        return packet;
+    }
+
+    bool connected = false;
+    std::vector<std::vector<uint8_t>> received;
+};
+
+struct Simulation
+{
+    Simulation() : peripheral(scheduler, kLongTermKey, 7), link(scheduler, peripheral), button(makeInfo(), link, scheduler)
+    {
+    }
+
+    void reconnect(Timestamp away)
+    {
+        peripheral.setInRange(false);
+        scheduler.runUntilIdle();
+        scheduler.advanceBy(away);
+        peripheral.setInRange(true);
+        scheduler.runUntilIdle();
+    }
+
+    ManualScheduler scheduler;
+    SimulatedPeripheral peripheral;
+    SimulatedLink link;
+    Button button;
+};
+
+} // namespace
+
+TEST(Resume, ReconnectResumesSession)
+{
+    Simulation simulation;
+    simulation.button.connect();
+    simulation.scheduler.runUntilIdle();
+    REQUIRE(simulation.button.isReady());
+    CHECK(!simulation.button.isSessionResumed());
+
+    simulation.reconnect(kNanosPerSecond);
+    REQUIRE(simulation.button.isReady());
+    CHECK(simulation.button.isSessionResumed());
+    CHECK_EQ(simulation.peripheral.fullVerifications(), 1u);
+    CHECK_EQ(simulation.peripheral.resumptions(), 1u);
+
+    // Events flow over the resumed session.
+    simulation.peripheral.press();
+    simulation.peripheral.release();
+    simulation.scheduler.runUntilIdle();
+    CHECK_EQ(simulation.button.pressCount(), 2);
+    CHECK_EQ(simulation.peripheral.rejectedPackets(), 0u);
+    CHECK_EQ(simulation.peripheral.queuedEvents(), 0u);
+}
+
+TEST(Resume, RejectedTicketFallsBackToVerification)
+{
+    Simulation simulation;
+    simulation.button.connect();
+    simulation.scheduler.runUntilIdle();
+    REQUIRE(simulation.button.isReady());
+
+    simulation.peripheral.forgetTicket();
+    simulation.reconnect(kNanosPerSecond);
+    REQUIRE(simulation.button.isReady());
+    CHECK(!simulation.button.isSessionResumed());
+    CHECK_EQ(simulation.peripheral.fullVerifications(), 2u);
+    CHECK_EQ(simulation.peripheral.resumptions(), 0u);
+}
+
+TEST(Resume, ExpiredTicketIsNotOffered)
+{
+    Simulation simulation;
+    simulation.button.connect();
+    simulation.scheduler.runUntilIdle();
+    REQUIRE(simulation.button.isReady());
+
+    simulation.reconnect(kResumptionTicketLifetime);
+    REQUIRE(simulation.button.isReady());
+    CHECK(!simulation.button.isSessionResumed());
+    CHECK_EQ(simulation.peripheral.fullVerifications(), 2u);
+    CHECK_EQ(simulation.peripheral.resumptions(), 0u);
+}
+
+TEST(Resume, ResponseSignedWithWrongKeyIsRejected)
+{
+    ManualScheduler scheduler;
+    ScriptedTransport transport;
+    Button button(makeInfo(), transport, scheduler);
+    button.connect();
+    transport.listener()->transportDidConnect();
+    verify(transport, scheduler);
+    REQUIRE(button.isReady());
+
+    transport.listener()->transportDidDisconnect(Error::BluetoothErrorConnectionLost);
+    CHECK_EQ(transport.connects, 2u);
+    transport.listener()->transportDidConnect();
+    DecodedPacket request = transport.lastWritten();
+    REQUIRE(request.opcode == Opcode::ResumeRequest);
+
+    // Whoever answers does not hold the ticket.
+    const uint8_t wrongKey[kSessionKeySize] = {};
+    PacketSigner signer(false);
+    signer.reset(wrongKey);
+    Packet response;
+    encodeResumeResponse(response, kButtonNonce, 1);
+    signer.sign(response);
+    transport.receive(response);
+
+    CHECK(!button.isReady());
+    CHECK_EQ(transport.lastWritten().opcode, Opcode::VerifyRequest);
+    verify(transport, scheduler);
+    CHECK(button.isReady());
+    CHECK(!button.isSessionResumed());
+}
+
+TEST(Resume, TicketIsReplacedOnEveryResumption)
+{
+    Simulation simulation;
+    simulation.button.connect();
+    simulation.scheduler.runUntilIdle();
+    REQUIRE(simulation.button.isReady());
+
+    for (int i = 0; i < 3; i++)
+    {
+        simulation.reconnect(kNanosPerSecond);
+        REQUIRE(simulation.button.isReady());
+        CHECK(simulation.button.isSessionResumed());
+    }
+    CHECK_EQ(simulation.peripheral.fullVerifications(), 1u);
+    CHECK_EQ(simulation.peripheral.resumptions(), 3u);
+
+    // Resuming does not extend the lifetime of the verification.
+    simulation.reconnect(kResumptionTicketLifetime - 3 * kNanosPerSecond);
+    REQUIRE(simulation.button.isReady());
+    CHECK(!simulation.button.isSessionResumed());
+    CHECK_EQ(simulation.peripheral.fullVerifications(), 2u);
+}
+
+TEST(Resume, ReplayedRequestIsRejected)
+{
+    ManualScheduler scheduler;
+    SimulatedPeripheral peripheral(scheduler, kLongTermKey, 11);
+    SimulatedLink link(scheduler, peripheral);
+    RecordingListener host;
+    link.setListener(&host);
+    link.connect();
+    scheduler.runUntilIdle();
+    REQUIRE(host.connected);
+
+    const uint8_t hostNonce[kNonceSize] = { 1, 2, 3, 4, 5, 6, 7, 8 };
+    Packet request;
+    encodeVerifyRequest(request, hostNonce);
+    link.write(request.bytes, request.size);
+    scheduler.runUntilIdle();
+    DecodedPacket verified = host.answer();
+    REQUIRE(verified.opcode == Opcode::VerifyResponse);
+    ResumptionTicket ticket;
+    deriveResumptionTicket(ChaskeyKey(kLongTermKey), hostNonce, verified.nonce, scheduler.now(), ticket);
+
+    // What an eavesdropper records of a resumption.
+    Packet resume;
+    encodeResumeRequest(resume, ticket.id, hostNonce);
+    link.disconnect();
+    link.connect();
+    scheduler.runUntilIdle();
+    host.received.clear();
+    link.write(resume.bytes, resume.size);
+    scheduler.runUntilIdle();
+    DecodedPacket resumed = host.answer();
+    REQUIRE(resumed.opcode == Opcode::ResumeResponse);
+    ResumptionTicket next = ticket;
+    uint8_t sessionKey[kSessionKeySize];
+    deriveResumedSession(next, hostNonce, resumed.nonce, sessionKey);
+    PacketSigner signer(true);
+    signer.reset(sessionKey);
+    CHECK(signer.verify(host.received.front().data(), host.received.front().size()));
+    CHECK_EQ(peripheral.resumptions(), 1u);
+
+    // Played back on a later connection, within the lifetime of the ticket.
+    link.disconnect();
+    link.connect();
+    scheduler.runUntilIdle();
+    host.received.clear();
+    link.write(resume.bytes, resume.size);
+    scheduler.runUntilIdle();
+    CHECK_EQ(host.answer().opcode, Opcode::ResumeRejected);
+    CHECK_EQ(peripheral.resumptions(), 1u);
+
+    // The ticket that replaced it is accepted, once.
+    const uint8_t nextNonce[kNonceSize] = { 8, 7, 6, 5, 4, 3, 2, 1 };
+    encodeResumeRequest(resume, next.id, nextNonce);
+    host.received.clear();
+    link.write(resume.bytes, resume.size);
+    scheduler.runUntilIdle();
+    CHECK_EQ(host.answer().opcode, Opcode::ResumeResponse);
+    CHECK_EQ(peripheral.resumptions(), 2u);
+}
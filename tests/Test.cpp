@@ -0,0 +1,136 @@
+//
+//  @file Test.cpp
+//  @framework fliclib-core
+//
+//  Copyright (c) 2016-2026 Shortcut Labs. All rights reserved.
+//
+
+#include "Test.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <dirent.h>
+#include <unistd.h>
+#include <vector>
+
+namespace scl {
+namespace test {
+
+namespace {
+
+struct Registered
+{
+    const char* name;
+    Function function;
+};
+
+std::vector<Registered>& registry()
+{
+    static std::vector<Registered> tests;
+    return tests;
+}
+
+const char* running = nullptr;
+size_t failedChecks = 0;
+std::string directory;
+
+void removeDirectory()
+{
+    if (directory.empty())
+    {
+        return;
+    }
+    if (DIR* dir = opendir(directory.c_str()))
+    {
+        while (dirent* entry = readdir(dir))
+        {
+            if (strcmp(entry->d_name, ".") != 0 && strcmp(entry->d_name, "..") != 0)
+            {
+                std::string path = directory + "/" + entry->d_name;
+                // A test may leave a directory in place of a file, e.g. to make a rename fail.
+                if (unlink(path.c_str()) != 0)
+                {
+                    rmdir(path.c_str());
+                }
+            }
+        }
+        closedir(dir);
+    }
+    rmdir(directory.c_str());
+}
+
+} // namespace
+
+bool registerTest(const char* name, Function function)
+{
+    registry().push_back({ name, function });
+    return true;
+}
+
+void fail(const char* file, int line, const std::string& message)
+{
+    failedChecks++;
+    fprintf(stderr, "%s:%d: %s: CHECK failed: %s\n", file, line, running ? running : "", message.c_str());
+}
+
+std::string temporaryPath(const std::string& name)
+{
+    if (directory.empty())
+    {
+        char pattern[] = "/tmp/flic-tests-XXXXXX";
+        if (!mkdtemp(pattern))
+        {
+            fprintf(stderr, "could not create a temporary directory\n");
+            exit(1);
+        }
+        directory = pattern;
+    }
+    return directory + "/" + name;
+}
+
+int runTests(int argc, char** argv)
+{
+    std::string filter;
+    for (int i = 1; i < argc; i++)
+    {
+        if (strncmp(argv[i], "--filter=", 9) == 0)
+        {
+            filter = argv[i] + 9;
+        }
+        else
+        {
+            fprintf(stderr, "unknown option %s\n", argv[i]);
+            return 1;
+        }
+    }
+
+    size_t run = 0;
+    size_t failed = 0;
+    for (const Registered& test : registry())
+    {
+        if (!filter.empty() && strstr(test.name, filter.c_str()) == nullptr)
+        {
+            continue;
+        }
+        running = test.name;
+        size_t before = failedChecks;
+        test.function();
+        bool passed = failedChecks == before;
+        printf("%-6s %s\n", passed ? "ok" : "FAILED", test.name);
+        run++;
+        failed += passed ? 0 : 1;
+    }
+    running = nullptr;
+    removeDirectory();
+    printf("%zu tests, %zu failed\n", run, failed);
+    return failed == 0 ? 0 : 1;
+}
+
+} // namespace test
+} // namespace scl
+
+int main(int argc, char** argv)
+{
+    return scl::test::runTests(argc, argv);
+}
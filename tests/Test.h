@@ -0,0 +1,129 @@
+//
+//  @file Test.h
+//  @framework fliclib-core
+//
+//  Copyright (c) 2016-2026 Shortcut Labs. All rights reserved.
+//
+
+#ifndef SCL_FLIC_TEST_H
+#define SCL_FLIC_TEST_H
+
+#include <cstdint>
+#include <sstream>
+#include <string>
+#include <type_traits>
+
+namespace scl {
+namespace test {
+
+typedef void (*Function)();
+
+/*!
+ *  @method registerTest:function:
+ *
+ *  @discussion Adds a test to the ones <code>runTests</code> runs, in the order of registration within a file.
+ *
+ */
+bool registerTest(const char* name, Function function);
+
+/*!
+ *  @method fail:line:message:
+ *
+ *  @discussion Marks the running test as failed and reports where. The test goes on, so that one run shows every check
+ *              that fails.
+ *
+ */
+void fail(const char* file, int line, const std::string& message);
+
+/*!
+ *  @method temporaryPath:
+ *
+ *  @return A path for <code>name</code> in a directory of its own for this run, which is removed when the run ends.
+ *
+ */
+std::string temporaryPath(const std::string& name);
+
+/*!
+ *  @method runTests:argv:
+ *
+ *  @discussion Runs the registered tests, or those whose name contains <code>--filter=substring</code>.
+ *
+ *  @return The process exit code, 1 if any check failed.
+ *
+ */
+int runTests(int argc, char** argv);
+
+template <class T>
+std::string describe(const T& value)
+{
+    std::ostringstream out;
+    if constexpr (std::is_enum<T>::value)
+    {
+        out << (int64_t)value;
+    }
+    else if constexpr (std::is_same<T, uint8_t>::value || std::is_same<T, int8_t>::value)
+    {
+        out << (int)value;
+    }
+    else if constexpr (std::is_arithmetic<T>::value || std::is_convertible<T, std::string>::value)
+    {
+        out << value;
+    }
+    else
+    {
+        out << "?";
+    }
+    return out.str();
+}
+
+template <class A, class B>
+bool checkEqual(const A& actual, const B& expected, const char* actualText, const char* expectedText, const char* file,
+                int line)
+{
+    if (actual == expected)
+    {
+        return true;
+    }
+    fail(file, line, std::string(actualText) + " == " + expectedText + " (" + describe(actual) + " != " +
+                         describe(expected) + ")");
+    return false;
+}
+
+} // namespace test
+} // namespace scl
+
+#define SCL_TEST_CONCAT2(a, b) a##b
+#define SCL_TEST_CONCAT(a, b) SCL_TEST_CONCAT2(a, b)
+
+/*!
+ *  @define TEST
+ *
+ *  @discussion Defines and registers a test, e.g. <code>TEST(Journal, TornTail) { ... }</code>.
+ *
+ */
+#define TEST(suite, name)                                                                                              \
+    static void SCL_TEST_CONCAT(suite##_, name)();                                                                     \
+    static bool SCL_TEST_CONCAT(registered_##suite##_, name) =                                                         \
+        scl::test::registerTest(#suite "." #name, SCL_TEST_CONCAT(suite##_, name));                                    \
+    static void SCL_TEST_CONCAT(suite##_, name)()
+
+#define CHECK(condition) ((condition) ? (void)0 : scl::test::fail(__FILE__, __LINE__, #condition))
+#define CHECK_EQ(actual, expected) scl::test::checkEqual((actual), (expected), #actual, #expected, __FILE__, __LINE__)
+
+/*!
+ *  @define REQUIRE
+ *
+ *  @discussion Like CHECK, but ends the test when the condition does not hold, for checks the rest of it relies on.
+ *
+ */
+#define REQUIRE(condition)                                                                                             \
+    do                                                                                                                 \
+    {                                                                                                                  \
+        if (!(condition))                                                                                              \
+        {                                                                                                              \
+            scl::test::fail(__FILE__, __LINE__, #condition);                                                           \
+            return;                                                                                                    \
+        }                                                                                                              \
+    } while (0)
+
+#endif // SCL_FLIC_TEST_H